@@ -0,0 +1,164 @@
+#pragma once
+#include "pch.h"
+#include "Math.h"
+#include "Tuple.h"
+#include "Matrix.h"
+#include "Ray.h"
+
+/*An axis aligned bounding box. A default constructed box is empty (inverted),
+so growing it by any point or box yields exactly that point or box.
+Shapes that extend forever (planes, open ended cylinders and cones) get a box flagged as infinite,
+its extents are clamped to math::MIN/MAX and shouldn't be used for culling.*/
+struct AABB final {
+    Point min{ math::MAX, math::MAX, math::MAX };
+    Point max{ math::MIN, math::MIN, math::MIN };
+    bool infinite = false;
+    constexpr bool operator==(const AABB& that) const noexcept = default;
+};
+
+constexpr AABB aabb() noexcept {
+    return AABB{};
+}
+constexpr AABB aabb(Point min, Point max) noexcept {
+    return AABB{ min, max };
+}
+constexpr AABB infinite_aabb() noexcept {
+    return AABB{ point(math::MIN, math::MIN, math::MIN), point(math::MAX, math::MAX, math::MAX), true };
+}
+constexpr AABB infinite_aabb(Point min, Point max) noexcept {
+    return AABB{ min, max, true };
+}
+
+constexpr Real component(const Point& p, size_t axis) noexcept {
+    assert(axis < 3 && "component(p, axis): axis must be 0 (x), 1 (y) or 2 (z)");
+    return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+}
+constexpr Real component(const Vector& v, size_t axis) noexcept {
+    assert(axis < 3 && "component(v, axis): axis must be 0 (x), 1 (y) or 2 (z)");
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+constexpr bool is_empty(const AABB& box) noexcept {
+    return box.min.x > box.max.x || box.min.y > box.max.y || box.min.z > box.max.z;
+}
+constexpr bool is_infinite(const AABB& box) noexcept {
+    return box.infinite;
+}
+
+constexpr void grow(AABB& box, const Point& p) noexcept {
+    box.min = point(std::min(box.min.x, p.x), std::min(box.min.y, p.y), std::min(box.min.z, p.z));
+    box.max = point(std::max(box.max.x, p.x), std::max(box.max.y, p.y), std::max(box.max.z, p.z));
+}
+constexpr void grow(AABB& box, const AABB& other) noexcept {
+    if (is_empty(other)) {
+        return;
+    }
+    box.infinite = box.infinite || other.infinite;
+    grow(box, other.min);
+    grow(box, other.max);
+}
+constexpr AABB merge(AABB a, const AABB& b) noexcept {
+    grow(a, b);
+    return a;
+}
+
+//a box is its own bounds, which lets build_bvh work over a container of boxes computed up front.
+constexpr const AABB& bounds_of(const AABB& box) noexcept {
+    return box;
+}
+
+constexpr Vector extent(const AABB& box) noexcept {
+    return is_empty(box) ? vector(0.0f) : box.max - box.min;
+}
+constexpr Point centroid(const AABB& box) noexcept {
+    return box.min + (box.max - box.min) * 0.5f;
+}
+constexpr Real surface_area(const AABB& box) noexcept {
+    const auto e = extent(box);
+    return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+constexpr size_t longest_axis(const AABB& box) noexcept {
+    const auto e = extent(box);
+    if (e.x >= e.y && e.x >= e.z) { return 0; }
+    return (e.y >= e.z) ? 1 : 2;
+}
+
+//transforms the box and returns a new box bounding the result.
+//Arvo's method: each row of the matrix contributes its smallest and largest product per axis,
+//which is equivalent to (but cheaper than) transforming all eight corners.
+//m is a Matrix4 or an Affine; only the top three rows are read.
+template<class Transform>
+    requires (is_matrix<Transform> && Transform::COLUMNS == 4 && Transform::ROWS >= 3)
+constexpr AABB transform(const AABB& box, const Transform& m) noexcept {
+    if (is_empty(box)) {
+        return box;
+    }
+    if (is_infinite(box)) {
+        return infinite_aabb(); //any rotation can turn the infinite axis into any other, and MAX * m would overflow.
+    }
+    Real out_min[3]{ m[3], m[7], m[11] }; //start at the translation
+    Real out_max[3]{ m[3], m[7], m[11] };
+    const Real in_min[3]{ box.min.x, box.min.y, box.min.z };
+    const Real in_max[3]{ box.max.x, box.max.y, box.max.z };
+    for (uint8_t row = 0; row < 3; ++row) {
+        for (uint8_t col = 0; col < 3; ++col) {
+            const auto a = m(row, col) * in_min[col];
+            const auto b = m(row, col) * in_max[col];
+            out_min[row] += std::min(a, b);
+            out_max[row] += std::max(a, b);
+        }
+    }
+    return aabb(point(out_min[0], out_min[1], out_min[2]), point(out_max[0], out_max[1], out_max[2]));
+}
+
+//a ray prepared for repeated slab tests: the reciprocal of the direction is
+//computed once per ray instead of once per box.
+struct SlabRay final {
+    Point origin;
+    Vector inv_direction;
+};
+
+constexpr Real safe_reciprocal(Real d) noexcept {
+    //avoiding INFINITY (see check_axis in Cube.h), and 0*INFINITY == NaN when the ray origin lies on a slab.
+    if (math::abs(d) < math::MACHINE_EPSILON) {
+        return d < 0.0f ? math::MIN : math::MAX;
+    }
+    return 1.0f / d;
+}
+
+constexpr SlabRay slab_ray(const Ray& r) noexcept {
+    return SlabRay{ r.origin, vector(safe_reciprocal(r.dx()), safe_reciprocal(r.dy()), safe_reciprocal(r.dz())) };
+}
+
+static constexpr Real BOX_MISS = math::MAX; //magic value returned by entry_distance when the ray misses the box
+
+//slab test. returns the distance at which the ray enters the box (clamped to t_min), or BOX_MISS.
+constexpr Real entry_distance(const AABB& box, const SlabRay& r, Real t_min, Real t_max) noexcept {
+    const auto slab = [](Real min, Real max, Real origin, Real inv_dir) noexcept {
+        const auto t0 = (min - origin) * inv_dir;
+        const auto t1 = (max - origin) * inv_dir;
+        return (t0 > t1) ? std::pair{ t1, t0 } : std::pair{ t0, t1 };
+    };
+    const auto [xmin, xmax] = slab(box.min.x, box.max.x, r.origin.x, r.inv_direction.x);
+    const auto [ymin, ymax] = slab(box.min.y, box.max.y, r.origin.y, r.inv_direction.y);
+    const auto [zmin, zmax] = slab(box.min.z, box.max.z, r.origin.z, r.inv_direction.z);
+    const auto enter = std::max(t_min, math::max(xmin, ymin, zmin));
+    const auto exit = std::min(t_max, math::min(xmax, ymax, zmax));
+    return (enter <= exit) ? enter : BOX_MISS;
+}
+
+constexpr bool intersects(const AABB& box, const Ray& r, Real t_min = math::MIN, Real t_max = math::MAX) noexcept {
+    return entry_distance(box, slab_ray(r), t_min, t_max) != BOX_MISS;
+}
+
+#pragma warning(push)
+#pragma warning( disable : 26481 ) //spurious warning; "don't use pointer arithmetic"
+std::ostream& operator<<(std::ostream& os, const AABB& box) {
+    if (is_infinite(box)) {
+        os << "AABB(infinite)"sv;
+        return os;
+    }
+    os << std::format("AABB(({}, {}, {}), ({}, {}, {}))"sv, box.min.x, box.min.y, box.min.z, box.max.x, box.max.y, box.max.z);
+    return os;
+}
+#pragma warning(pop)
@@ -0,0 +1,146 @@
+#pragma once
+#include "pch.h"
+#include "Tuple.h"
+#include "Matrix.h"
+#include "Ray.h"
+
+/*
+ * A 3x4 affine transform: a Matrix4 without its bottom row, which is always 0, 0, 0, 1 for the
+ * translations, rotations, scalings and shearings that place shapes and patterns.
+ * 48 bytes instead of 64, and transforming a point or a vector never touches the 4th row.
+ * The layout is row major, exactly the first 12 elements of the equivalent Matrix4.
+ */
+using Affine = Matrix<3, 4>;
+
+constexpr Affine affine(const Matrix4& m) noexcept {
+    assert(m[12] == 0 && m[13] == 0 && m[14] == 0 && m[15] == 1 && "affine(): the bottom row of an affine transform must be 0, 0, 0, 1");
+    return Affine{
+        m[0], m[1], m[2], m[3],
+        m[4], m[5], m[6], m[7],
+        m[8], m[9], m[10], m[11]
+    };
+}
+
+constexpr Matrix4 to_matrix4(const Affine& a) noexcept {
+    return Matrix4{
+        a[0], a[1], a[2], a[3],
+        a[4], a[5], a[6], a[7],
+        a[8], a[9], a[10], a[11],
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+}
+
+static constexpr auto AffineIdentity = affine(Matrix4Identity);
+
+constexpr Affine operator*(const Affine& lhs, const Affine& rhs) noexcept {
+    return Affine{
+    lhs[0] * rhs[0] + lhs[1] * rhs[4] + lhs[2] * rhs[8], //0,0
+    lhs[0] * rhs[1] + lhs[1] * rhs[5] + lhs[2] * rhs[9], //0,1
+    lhs[0] * rhs[2] + lhs[1] * rhs[6] + lhs[2] * rhs[10], //0,2
+    lhs[0] * rhs[3] + lhs[1] * rhs[7] + lhs[2] * rhs[11] + lhs[3], //0,3
+    lhs[4] * rhs[0] + lhs[5] * rhs[4] + lhs[6] * rhs[8],
+    lhs[4] * rhs[1] + lhs[5] * rhs[5] + lhs[6] * rhs[9],
+    lhs[4] * rhs[2] + lhs[5] * rhs[6] + lhs[6] * rhs[10],
+    lhs[4] * rhs[3] + lhs[5] * rhs[7] + lhs[6] * rhs[11] + lhs[7],
+    lhs[8] * rhs[0] + lhs[9] * rhs[4] + lhs[10] * rhs[8],
+    lhs[8] * rhs[1] + lhs[9] * rhs[5] + lhs[10] * rhs[9],
+    lhs[8] * rhs[2] + lhs[9] * rhs[6] + lhs[10] * rhs[10],
+    lhs[8] * rhs[3] + lhs[9] * rhs[7] + lhs[10] * rhs[11] + lhs[11] }; //2,3
+}
+
+#if RTC_SIMD
+namespace simd {
+    //the columns of a, with the implicit bottom row filled in.
+    inline Rows4 load_columns(const Affine& a) noexcept {
+        Rows4 c{ _mm_loadu_ps(a.data()), _mm_loadu_ps(a.data() + 4), _mm_loadu_ps(a.data() + 8), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f) };
+        _MM_TRANSPOSE4_PS(c.r0, c.r1, c.r2, c.r3);
+        return c;
+    }
+}
+#endif
+
+//9 multiplies and 9 adds; the same operations, in the same order, as Matrix4 * Point.
+constexpr Point operator*(const Affine& lhs, const Point& rhs) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Point result;
+        simd::store(&result.x, simd::transform_point(simd::load_columns(lhs), simd::load(&rhs.x)));
+        return result;
+    }
+#endif
+    const auto x = rhs.x * lhs[0] + rhs.y * lhs[1] + rhs.z * lhs[2] + lhs[3];
+    const auto y = rhs.x * lhs[4] + rhs.y * lhs[5] + rhs.z * lhs[6] + lhs[7];
+    const auto z = rhs.x * lhs[8] + rhs.y * lhs[9] + rhs.z * lhs[10] + lhs[11];
+    return Point{ x, y, z };
+}
+
+//vectors ignore the translation column.
+constexpr Vector operator*(const Affine& lhs, const Vector& rhs) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Vector result;
+        simd::store(&result.x, simd::transform_vector(simd::load_columns(lhs), simd::load(&rhs.x)));
+        return result;
+    }
+#endif
+    const auto x = rhs.x * lhs[0] + rhs.y * lhs[1] + rhs.z * lhs[2];
+    const auto y = rhs.x * lhs[4] + rhs.y * lhs[5] + rhs.z * lhs[6];
+    const auto z = rhs.x * lhs[8] + rhs.y * lhs[9] + rhs.z * lhs[10];
+    return Vector{ x, y, z };
+}
+
+constexpr Ray operator*(const Affine& m, const Ray& r) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) { //transpose once, for both the origin and the direction
+        const auto columns = simd::load_columns(m);
+        Ray result;
+        simd::store(&result.origin.x, simd::transform_point(columns, simd::load(&r.origin.x)));
+        simd::store(&result.direction.x, simd::transform_vector(columns, simd::load(&r.direction.x)));
+        return result;
+    }
+#endif
+    return Ray{ m * r.origin, m * r.direction };
+}
+
+constexpr Ray transform(const Ray& r, const Affine& m) noexcept {
+    return m * r;
+}
+
+/*The matrix that takes object space normals to world space, given the object's *inverse* transform:
+ the transpose of its upper 3x3. Shapes compute it once, in set_transform.*/
+constexpr Matrix3 normal_matrix(const Affine& inv) noexcept {
+    return Matrix3{
+        inv[0], inv[4], inv[8],
+        inv[1], inv[5], inv[9],
+        inv[2], inv[6], inv[10]
+    };
+}
+
+//a linear transform of a vector, such as a normal through its normal_matrix. The result is not normalized.
+constexpr Vector operator*(const Matrix3& lhs, const Vector& rhs) noexcept {
+    const auto x = rhs.x * lhs[0] + rhs.y * lhs[1] + rhs.z * lhs[2];
+    const auto y = rhs.x * lhs[3] + rhs.y * lhs[4] + rhs.z * lhs[5];
+    const auto z = rhs.x * lhs[6] + rhs.y * lhs[7] + rhs.z * lhs[8];
+    return Vector{ x, y, z };
+}
+
+/*The inverse of an affine transform is affine too: invert the 3x3 part (through its cofactors),
+ and move the translation back through it.*/
+constexpr Affine inverse(const Affine& m) noexcept {
+    const auto c00 = m[5] * m[10] - m[6] * m[9];
+    const auto c01 = m[6] * m[8] - m[4] * m[10];
+    const auto c02 = m[4] * m[9] - m[5] * m[8];
+    const auto det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+    assert(det != 0 && "Affine inverse called with non-invertible transform");
+    const auto inv_det = 1.0f / det;
+    const Real l[9]{
+        c00 * inv_det, (m[2] * m[9] - m[1] * m[10]) * inv_det, (m[1] * m[6] - m[2] * m[5]) * inv_det,
+        c01 * inv_det, (m[0] * m[10] - m[2] * m[8]) * inv_det, (m[2] * m[4] - m[0] * m[6]) * inv_det,
+        c02 * inv_det, (m[1] * m[8] - m[0] * m[9]) * inv_det, (m[0] * m[5] - m[1] * m[4]) * inv_det
+    };
+    return Affine{
+        l[0], l[1], l[2], -(l[0] * m[3] + l[1] * m[7] + l[2] * m[11]),
+        l[3], l[4], l[5], -(l[3] * m[3] + l[4] * m[7] + l[5] * m[11]),
+        l[6], l[7], l[8], -(l[6] * m[3] + l[7] * m[7] + l[8] * m[11])
+    };
+}
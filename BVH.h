@@ -0,0 +1,254 @@
+#pragma once
+#include "pch.h"
+#include <array>
+#include <optional>
+#include <span>
+#include "AABB.h"
+#include "Ray.h"
+#include "InlineVector.h"
+
+/*
+ * A bounding volume hierarchy over the objects of a World, built with the surface area heuristic (SAH).
+ *
+ * The BVH never owns or copies shapes. It stores indices into the container it was built from,
+ * so a World can be copied or moved without invalidating its hierarchy. Shapes without finite
+ * bounds (planes, infinite cylinders and cones, see bounds_of) can't be placed in the tree; they are kept in a
+ * separate list that is tested for every ray.
+ */
+
+struct BVHNode final {
+    AABB bounds;
+    uint32_t first = 0; //leaf: offset of the first object index. interior: index of the left child (the right child is first + 1)
+    uint32_t count = 0; //number of objects in a leaf. interior nodes have a count of 0
+    constexpr bool is_leaf() const noexcept { return count > 0; }
+};
+
+struct BVH final {
+    using size_type = uint32_t;
+    static constexpr size_type MAX_LEAF_SIZE = 4;
+    static constexpr size_type BIN_COUNT = 12;
+    static constexpr size_type MAX_DEPTH = 48; //below this depth we stop trusting SAH and split on the median, to bound the traversal stack
+    static constexpr Real TRAVERSAL_COST = 1.0f; //relative to the cost of intersecting one object
+
+    std::vector<BVHNode> nodes; //nodes[0] is the root
+    std::vector<size_type> indices; //object indices, referenced by the leaves
+    std::vector<size_type> unbounded; //objects without finite bounds, tested for every ray
+    size_t object_count = 0; //number of objects the hierarchy was built for
+
+    constexpr bool empty() const noexcept { return object_count == 0; }
+    constexpr size_t size() const noexcept { return object_count; }
+};
+
+namespace Detail {
+    struct BVHBuildItem final {
+        AABB bounds;
+        Point centroid;
+        BVH::size_type index = 0;
+    };
+
+    struct SAHSplit final {
+        size_t axis = 0;
+        Real position = 0.0f;
+        Real cost = math::MAX;
+    };
+
+    constexpr size_t bin_of(Real centroid, Real min, Real scale) noexcept {
+        const auto bin = static_cast<size_t>((centroid - min) * scale);
+        return std::min(bin, size_t{ BVH::BIN_COUNT - 1 });
+    }
+
+    //evaluates BIN_COUNT-1 candidate planes on each axis and returns the cheapest by the surface area heuristic.
+    constexpr SAHSplit find_sah_split(std::span<const BVHBuildItem> items, const AABB& centroid_bounds) noexcept {
+        SAHSplit best;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const auto min = component(centroid_bounds.min, axis);
+            const auto max = component(centroid_bounds.max, axis);
+            if (max - min <= math::MACHINE_EPSILON) {
+                continue; //all centroids share this coordinate, no plane can separate them
+            }
+            std::array<AABB, BVH::BIN_COUNT> bin_bounds{};
+            std::array<size_t, BVH::BIN_COUNT> bin_count{};
+            const auto scale = BVH::BIN_COUNT / (max - min);
+            for (const auto& item : items) {
+                const auto bin = bin_of(component(item.centroid, axis), min, scale);
+                grow(bin_bounds[bin], item.bounds);
+                ++bin_count[bin];
+            }
+            //sweep from the right to get the area and count of everything right of each plane
+            std::array<Real, BVH::BIN_COUNT> right_area{};
+            std::array<size_t, BVH::BIN_COUNT> right_count{};
+            AABB right;
+            size_t count = 0;
+            for (size_t i = BVH::BIN_COUNT - 1; i > 0; --i) {
+                grow(right, bin_bounds[i]);
+                count += bin_count[i];
+                right_area[i] = surface_area(right);
+                right_count[i] = count;
+            }
+            AABB left;
+            count = 0;
+            for (size_t i = 0; i < BVH::BIN_COUNT - 1; ++i) {
+                grow(left, bin_bounds[i]);
+                count += bin_count[i];
+                if (count == 0 || right_count[i + 1] == 0) {
+                    continue;
+                }
+                const auto cost = surface_area(left) * static_cast<Real>(count) + right_area[i + 1] * static_cast<Real>(right_count[i + 1]);
+                if (cost < best.cost) {
+                    best = SAHSplit{ axis, min + static_cast<Real>(i + 1) / scale, cost };
+                }
+            }
+        }
+        return best;
+    }
+
+    constexpr void build_bvh_node(BVH& bvh, std::vector<BVHBuildItem>& items, BVH::size_type node_index, size_t begin, size_t end, size_t depth) {
+        AABB bounds;
+        AABB centroid_bounds;
+        for (size_t i = begin; i < end; ++i) {
+            grow(bounds, items[i].bounds);
+            grow(centroid_bounds, items[i].centroid);
+        }
+        const auto count = end - begin;
+        const auto make_leaf = [&]() {
+            bvh.nodes[node_index] = BVHNode{ bounds, narrow_cast<BVH::size_type>(bvh.indices.size()), narrow_cast<BVH::size_type>(count) };
+            for (size_t i = begin; i < end; ++i) {
+                bvh.indices.push_back(items[i].index);
+            }
+        };
+        if (count == 1) {
+            make_leaf();
+            return;
+        }
+        const auto span = std::span<const BVHBuildItem>(items.data() + begin, count);
+        auto mid = begin;
+        const auto split = (depth < BVH::MAX_DEPTH) ? find_sah_split(span, centroid_bounds) : SAHSplit{};
+        if (split.cost != math::MAX) {
+            const auto leaf_cost = static_cast<Real>(count);
+            const auto split_cost = BVH::TRAVERSAL_COST + split.cost / surface_area(bounds);
+            if (count <= BVH::MAX_LEAF_SIZE && leaf_cost <= split_cost) {
+                make_leaf();
+                return;
+            }
+            const auto first = items.begin() + begin;
+            const auto middle = std::partition(first, items.begin() + end, [&split](const BVHBuildItem& item) noexcept {
+                return component(item.centroid, split.axis) < split.position;
+            });
+            mid = begin + static_cast<size_t>(middle - first);
+        }
+        if (mid == begin || mid == end) { //SAH couldn't (or wasn't allowed to) split, fall back to the object median
+            if (count <= BVH::MAX_LEAF_SIZE) {
+                make_leaf();
+                return;
+            }
+            const auto axis = longest_axis(centroid_bounds);
+            mid = begin + count / 2;
+            std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                [axis](const BVHBuildItem& a, const BVHBuildItem& b) noexcept {
+                    return component(a.centroid, axis) < component(b.centroid, axis);
+                });
+        }
+        const auto left = narrow_cast<BVH::size_type>(bvh.nodes.size());
+        bvh.nodes.emplace_back();
+        bvh.nodes.emplace_back();
+        bvh.nodes[node_index] = BVHNode{ bounds, left, 0 };
+        build_bvh_node(bvh, items, left, begin, mid, depth + 1);
+        build_bvh_node(bvh, items, left + 1, mid, end, depth + 1);
+    }
+}
+
+template<std::ranges::random_access_range Container>
+constexpr BVH build_bvh(const Container& objects) {
+    BVH bvh;
+    bvh.object_count = std::ranges::size(objects);
+    std::vector<Detail::BVHBuildItem> items;
+    items.reserve(bvh.object_count);
+    for (BVH::size_type i = 0; i < bvh.object_count; ++i) {
+        const auto box = bounds_of(objects[i]);
+        if (is_infinite(box)) {
+            bvh.unbounded.push_back(i);
+        } else {
+            items.push_back(Detail::BVHBuildItem{ box, centroid(box), i });
+        }
+    }
+    if (items.empty()) {
+        return bvh;
+    }
+    bvh.nodes.reserve(items.size() * 2 - 1);
+    bvh.indices.reserve(items.size());
+    bvh.nodes.emplace_back();
+    Detail::build_bvh_node(bvh, items, 0, 0, items.size(), 0);
+    return bvh;
+}
+
+static constexpr Real TRAVERSAL_DONE = math::MIN; //return from a traverse visitor to stop the traversal
+
+/*Visits the candidate objects for a ray, nearest box first.
+ visit(object_index) is called for every object whose bounds the ray enters within [t_min, t_max],
+ and for every unbounded object. visit returns the (possibly shrunk) t_max, which lets a caller that
+ only cares about the closest hit prune everything behind it. Returning a t_max below t_min
+ (e.g. TRAVERSAL_DONE) ends the traversal, for any-hit queries. */
+template<class Visitor>
+constexpr void traverse(const BVH& bvh, const Ray& r, Real t_min, Real t_max, Visitor&& visit) {
+    traverse(bvh, r, t_min, t_max, visit, [](size_t) noexcept { return std::optional<Real>{}; });
+}
+
+/*traverse, for visitors that can take every object below some nodes at once. visit_node(node_index) is
+ called for each node the ray enters, before it's opened. It returns the (possibly shrunk) t_max if it
+ visited the objects below the node itself, or nothing to have them visited one by one as usual.*/
+template<class Visitor, class NodeVisitor>
+constexpr void traverse(const BVH& bvh, const Ray& r, Real t_min, Real t_max, Visitor&& visit, NodeVisitor&& visit_node) {
+    for (const auto i : bvh.unbounded) {
+        t_max = std::invoke(visit, size_t{ i });
+        if (t_max < t_min) {
+            return;
+        }
+    }
+    if (bvh.nodes.empty()) {
+        return;
+    }
+    const auto sr = slab_ray(r);
+    if (entry_distance(bvh.nodes[0].bounds, sr, t_min, t_max) == BOX_MISS) {
+        return;
+    }
+    struct Entry { BVH::size_type node; Real t; };
+    std::array<Entry, BVH::MAX_DEPTH * 2> stack{};
+    size_t top = 0;
+    stack[top++] = Entry{ 0, t_min };
+    while (top > 0) {
+        const auto [node_index, t_entry] = stack[--top];
+        if (t_entry > t_max) {
+            continue; //the box was pushed before a closer hit was found
+        }
+        if (const auto t = std::invoke(visit_node, size_t{ node_index })) {
+            t_max = *t;
+            if (t_max < t_min) {
+                return;
+            }
+            continue;
+        }
+        const auto& node = bvh.nodes[node_index];
+        if (node.is_leaf()) {
+            for (auto i = node.first; i < node.first + node.count; ++i) {
+                t_max = std::invoke(visit, size_t{ bvh.indices[i] });
+                if (t_max < t_min) {
+                    return;
+                }
+            }
+            continue;
+        }
+        auto closer = Entry{ node.first, entry_distance(bvh.nodes[node.first].bounds, sr, t_min, t_max) };
+        auto farther = Entry{ node.first + 1, entry_distance(bvh.nodes[node.first + 1].bounds, sr, t_min, t_max) };
+        if (farther.t < closer.t) {
+            std::swap(closer, farther);
+        }
+        if (farther.t != BOX_MISS) {
+            assert(top < stack.size() && "BVH traversal stack overflow");
+            stack[top++] = farther;
+        }
+        if (closer.t != BOX_MISS) {
+            assert(top < stack.size() && "BVH traversal stack overflow");
+            stack[top++] = closer; //pushed last so it's popped first: front-to-back
+        }
+    }
+}
@@ -1,9 +1,11 @@
 #pragma once
 #include "pch.h"
+#include <array>
 #include "Tuple.h"
 #include "Color.h"
 #include "StringHelpers.h"
-#include "WorkQue.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
 //A neat API example by lippuu: https://gist.github.com/lippuu/cbf4fa62fe8eed408159a558ff5c96ee
 static constexpr size_t CHANNELS = 3; //RGB
 static constexpr size_t CHARS_PER_CHANNEL = 4; //"255 "
@@ -11,6 +13,7 @@ static constexpr size_t CHARS_PER_PIXEL = CHANNELS * CHARS_PER_CHANNEL; //"255 2
 static constexpr size_t MAX_PIXELS_PER_LINE = (PPM_MAX_LINE_LENGTH / CHARS_PER_PIXEL); //(70/12) == 5
 static constexpr size_t SPACES_PER_PIXEL = 3; //"255 255 255 "
 static constexpr size_t MAX_SPACES_PER_LINE = MAX_PIXELS_PER_LINE * SPACES_PER_PIXEL; //5*3 == 15. 15*MAX_CHARACTERS_PER_PIXEL = 60 (a safe value <70) 
+static constexpr size_t PIXELS_PER_TASK = 4096; //parallel_for grain for per-pixel image work
 
 std::string ppm_header(size_t width, size_t height){
 #pragma warning( suppress : 26481 ) //spurious warning; "don't use pointer arithmetic" 
@@ -27,21 +30,72 @@ std::string to_ppm_seq(std::span<const Color> bitmap, size_t width, size_t heigh
     return ppm;
 }
 
-std::string to_ppm_par(std::span<const Color> bitmap, size_t width, size_t height){
-    std::vector<ByteColor_sRGB> buffer(bitmap.begin(), bitmap.end());
-    WorkQue worker;
-    std::vector<std::string> out(worker.thread_count());
-    worker.schedule(buffer.size(), [&out, &buffer](size_t part, size_t i) noexcept{
-        out[part].append(to_string_with_trailing_space(buffer[i]));
+//the decimal text of every byte value, so the P3 encoder never formats a number at runtime.
+struct PPMDigits final{
+    std::array<char, 3> text{};
+    uint8_t length = 0;
+};
+static constexpr auto PPM_DIGIT_TABLE = []() constexpr noexcept{
+    std::array<PPMDigits, PPM_MAX_BYTE_VALUE + 1> table{};
+    for(uint16_t value = 0; value < table.size(); ++value){
+        auto& entry = table[value];
+        if(value >= 100){ entry.text[entry.length++] = static_cast<char>('0' + value / 100); }
+        if(value >= 10){ entry.text[entry.length++] = static_cast<char>('0' + (value / 10) % 10); }
+        entry.text[entry.length++] = static_cast<char>('0' + value % 10);
+    }
+    return table;
+}();
+
+/*Encodes pixels as P3 text into out, which must have room for CHARS_PER_PIXEL per pixel.
+ Produces exactly what ppm_add_linebreaks makes of to_ppm_seq's output: every channel is followed by a
+ space, except that every every_nth_space'th space (counted from the first pixel of the image) is a newline.
+ first_pixel is the index of pixels[0] in the image, so chunks of one image can be encoded independently.
+ Returns one past the last character written.*/
+constexpr char* encode_ppm_p3(std::span<const Color> pixels, size_t first_pixel, size_t every_nth_space, char* out) noexcept{
+    auto space_count = (first_pixel * CHANNELS) % every_nth_space;
+    const auto put = [&out, &space_count, every_nth_space](uint8_t value) noexcept{
+        const auto& digits = PPM_DIGIT_TABLE[value];
+        for(uint8_t i = 0; i < digits.length; ++i){
+            *out++ = digits.text[i];
+        }
+        if(++space_count == every_nth_space){
+            *out++ = '\n';
+            space_count = 0;
+        } else{
+            *out++ = ' ';
+        }
+    };
+    for(const auto& color : pixels){
+        const auto c = ByteColor_sRGB(color);
+        put(c.r);
+        put(c.g);
+        put(c.b);
+    }
+    return out;
+}
+
+//P3 encoding of a whole image, chunks encoded in parallel then stitched together. Byte-identical to to_ppm_seq + ppm_add_linebreaks.
+std::string to_ppm_lut(std::span<const Color> bitmap, size_t width, size_t height){
+    const auto every_nth_space = std::min(width * SPACES_PER_PIXEL, MAX_SPACES_PER_LINE);
+    std::vector<std::string> out((bitmap.size() + PIXELS_PER_TASK - 1) / PIXELS_PER_TASK);
+    parallel_for(bitmap.size(), PIXELS_PER_TASK, [&out, bitmap, every_nth_space](size_t begin, size_t end) noexcept{
+        auto& out_part = out[begin / PIXELS_PER_TASK]; //begin is always a multiple of the grain
+        out_part.resize((end - begin) * CHARS_PER_PIXEL);
+        const auto last = encode_ppm_p3(bitmap.subspan(begin, end - begin), begin, every_nth_space, out_part.data());
+        out_part.resize(narrow_cast<size_t>(last - out_part.data()));
         });
-    std::ranges::for_each(out, [partition_size = worker.partition_size()](auto& out_part){
-        out_part.reserve(partition_size * CHARS_PER_PIXEL); }
-    );
-    out[0].append(ppm_header(width, height));
-    worker.run_in_parallel();
-    buffer.clear();
-    worker.clear();
-    return std::accumulate(out.begin() + 1, out.end(), out[0]);
+    std::string ppm = ppm_header(width, height);
+    size_t length = ppm.size() + 1;
+    for(const auto& out_part : out){
+        length += out_part.size();
+    }
+    ppm.reserve(length);
+    for(const auto& out_part : out){
+        ppm.append(out_part);
+    }
+    if(ppm.back() == ' '){ ppm.pop_back(); }
+    ppm.push_back('\n');
+    return ppm;
 }
 
 constexpr void ppm_add_linebreaks(std::string& str, size_t max_spaces_per_line) noexcept{
@@ -141,15 +195,7 @@ public:
     constexpr size_type size() const noexcept{ return bitmap.size(); }
 
     std::string to_ppm() const{
-        std::string ppm;
-        if constexpr(RUN_SEQUENTIAL){
-            ppm = to_ppm_seq(bitmap, _width, _height);
-        } else{
-            ppm = to_ppm_par(bitmap, _width, _height);
-        }
-        const auto every_nth_space = std::min(width() * SPACES_PER_PIXEL, MAX_SPACES_PER_LINE);
-        ppm_add_linebreaks(ppm, every_nth_space);
-        return ppm;
+        return to_ppm_lut(bitmap, _width, _height);
     }
 
 private:
@@ -163,6 +209,40 @@ void save_to_file(const Canvas& img, std::string_view path){
     ofs << img.to_ppm();
 }
 
+static constexpr size_t P6_PIXELS_PER_WRITE = 16 * PIXELS_PER_TASK; //pixels converted per chunk before handing them to the stream
+
+/*Binary PPM (P6): the header, then 3 raw sRGB bytes per pixel. Streams the image in chunks
+ of P6_PIXELS_PER_WRITE pixels through one reusable buffer, so memory use stays flat no matter the resolution.
+ os should be opened in binary mode.*/
+void write_ppm_p6(std::ostream& os, const Canvas& img){
+#pragma warning( suppress : 26481 ) //spurious warning; "don't use pointer arithmetic"
+    os << std::format("{}\n{} {}\n{}\n"sv, PPM_BINARY_VERSION, img.width(), img.height(), PPM_MAX_BYTE_VALUE);
+    std::vector<char> buffer(std::min(img.size(), P6_PIXELS_PER_WRITE) * CHANNELS);
+    for(size_t first = 0; first < img.size(); first += P6_PIXELS_PER_WRITE){
+        const auto count = std::min(P6_PIXELS_PER_WRITE, img.size() - first);
+        parallel_for(count, PIXELS_PER_TASK, [&buffer, &img, first](size_t begin, size_t end) noexcept{
+            for(auto i = begin; i < end; ++i){
+                const auto c = ByteColor_sRGB(img[first + i]);
+                buffer[i * CHANNELS + 0] = static_cast<char>(c.r);
+                buffer[i * CHANNELS + 1] = static_cast<char>(c.g);
+                buffer[i * CHANNELS + 2] = static_cast<char>(c.b);
+            }
+            });
+        os.write(buffer.data(), narrow_cast<std::streamsize>(count * CHANNELS));
+    }
+}
+
+enum class PPMFormat{ P3, P6 };
+
+void save_to_file(const Canvas& img, std::string_view path, PPMFormat format){
+    if(format == PPMFormat::P3){
+        save_to_file(img, path);
+        return;
+    }
+    std::ofstream ofs(path.data(), std::ofstream::out | std::ofstream::binary);
+    write_ppm_p6(ofs, img);
+}
+
 class ppm_parse_error : public std::runtime_error{   
 public: 
     explicit ppm_parse_error(std::string_view what) noexcept : std::runtime_error(what.data()){}
@@ -200,40 +280,148 @@ struct ppm_header_data{
     size_t height;
     float maxByteValue;
     size_t data_start;
+    PPMFormat format;
 
-    constexpr ppm_header_data(size_t w, size_t h, float max, size_t data_start) : width(w), height(h), maxByteValue(max), data_start(data_start){
+    constexpr ppm_header_data(size_t w, size_t h, float max, size_t data_start, PPMFormat format = PPMFormat::P3) : width(w), height(h), maxByteValue(max), data_start(data_start), format(format){
         if(width == 0 || height == 0) throw ppm_parse_error("Canvas dimensions must be non-zero."sv);
         if(maxByteValue > 255 || maxByteValue <= 0) throw ppm_parse_error("Invalid max byte value."sv);
         if(data_start == std::string_view::npos) throw ppm_parse_error("Incomplete or incorrect PPM header."sv);
     }
 };
 
+constexpr bool is_ppm_space(char c) noexcept{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
 ppm_header_data parse_header(std::string_view data) {
     size_t offset = 0;
     offset = next_non_comment(data, offset); //skip any leading comments. 
-    if (data.substr(offset, 2) != PPM_VERSION || !std::isspace(data[offset + 2])) {
-        throw ppm_parse_error("Unsupported or invalid PPM format. Only P3 is supported.");
+    if (offset == std::string_view::npos || offset + PPM_VERSION.size() >= data.size() || !is_ppm_space(data[offset + PPM_VERSION.size()])) {
+        throw ppm_parse_error("Unsupported or invalid PPM format. Only P3 and P6 are supported.");
     }
+    const auto magic = data.substr(offset, PPM_VERSION.size());
+    if (magic != PPM_VERSION && magic != PPM_BINARY_VERSION) {
+        throw ppm_parse_error("Unsupported or invalid PPM format. Only P3 and P6 are supported.");
+    }
+    const auto format = (magic == PPM_VERSION) ? PPMFormat::P3 : PPMFormat::P6;
     offset += PPM_VERSION.size()+1;// Move past "P3" and the whitespace after it
     auto width = next_number<size_t>(data, offset);
     auto height = next_number<size_t>(data, offset);
     auto maxByteValue = next_number<float>(data, offset);
+    if (format == PPMFormat::P6) { //exactly one whitespace character, then raw bytes (which may well look like whitespace)
+        const auto pixel_data_start = (offset < data.size() && is_ppm_space(data[offset])) ? offset + 1 : std::string_view::npos;
+        return {width, height, maxByteValue, pixel_data_start, format};
+    }
     size_t pixel_data_start = data.find_first_not_of("\n", offset);    
-    return {width, height, maxByteValue, pixel_data_start};
+    return {width, height, maxByteValue, pixel_data_start, format};
 }
 
+static constexpr size_t PPM_BYTES_PER_TASK = 64 * 1024; //P3 text handed to each parse task
+
+namespace Detail{
+    /*Splits P3 pixel text into chunks for parallel parsing, each starting right after a newline:
+     a number can't straddle a line break, and neither can a comment, so each chunk parses on its own.
+     Returns the chunk start offsets, followed by text.size().*/
+    std::vector<size_t> ppm_chunk_starts(std::string_view text, size_t chunk_size = PPM_BYTES_PER_TASK){
+        return line_chunk_starts(text, chunk_size);
+    }
+
+    //calls on_token(token) for every number in a chunk of P3 text, skipping whitespace and comments.
+    template<class Callable>
+    constexpr void for_each_ppm_token(std::string_view text, Callable&& on_token) noexcept{
+        size_t offset = 0;
+        while (offset < text.size()) {
+            const auto c = text[offset];
+            if (c == '#') {
+                const auto line_end = text.find('\n', offset);
+                offset = (line_end == std::string_view::npos) ? text.size() : line_end + 1;
+            } else if (is_ppm_space(c)) {
+                ++offset;
+            } else {
+                const auto begin = offset;
+                while (offset < text.size() && !is_ppm_space(text[offset]) && text[offset] != '#') {
+                    ++offset;
+                }
+                on_token(text.substr(begin, offset - begin));
+            }
+        }
+    }
+
+    constexpr Real& channel(Color& c, size_t i) noexcept{
+        assert(i < CHANNELS);
+        return (i == 0) ? c.r : (i == 1) ? c.g : c.b;
+    }
+
+    /*Parses P3 pixel text in two parallel passes: the first counts the numbers in each chunk, and a
+     prefix sum over those counts tells each chunk which channel its first number belongs to. The
+     second pass parses every chunk straight into the canvas. Values past width*height are ignored.*/
+    Canvas parse_ppm_p3(std::string_view text, size_t width, size_t height, float maxByteValue){
+        const auto starts = ppm_chunk_starts(text);
+        const auto chunk_count = starts.size() - 1;
+        const auto chunk = [&text, &starts](size_t i) noexcept{ return text.substr(starts[i], starts[i + 1] - starts[i]); };
+        std::vector<size_t> first_value(chunk_count + 1, 0);
+        parallel_for(chunk_count, 1, [&chunk, &first_value](size_t begin, size_t end) noexcept{
+            for (auto i = begin; i < end; ++i) {
+                size_t count = 0;
+                for_each_ppm_token(chunk(i), [&count](std::string_view) noexcept{ ++count; });
+                first_value[i + 1] = count;
+            }
+        });
+        std::partial_sum(first_value.begin(), first_value.end(), first_value.begin());
+        const auto value_count = width * height * CHANNELS;
+        if (first_value.back() < value_count) throw ppm_parse_error("Pixel data does not match width*height.");
+
+        Canvas img(width, height);
+        std::atomic<bool> malformed{ false };
+        parallel_for(chunk_count, 1, [&](size_t begin, size_t end) noexcept{
+            for (auto i = begin; i < end; ++i) {
+                auto value = first_value[i];
+                for_each_ppm_token(chunk(i), [&](std::string_view token) noexcept{
+                    if (value >= value_count) {
+                        return;
+                    }
+                    float number{};
+                    const auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), number);
+                    if (ec != std::errc{} || ptr != token.data() + token.size()) {
+                        malformed.store(true, std::memory_order_relaxed);
+                    }
+                    channel(img[value / CHANNELS], value % CHANNELS) = number / maxByteValue;
+                    ++value;
+                });
+            }
+        });
+        if (malformed.load()) throw ppm_parse_error("Failed to parse number!");
+        return img;
+    }
+
+    //P6 pixel data is width*height*3 raw bytes (maxval is at most 255, so one byte per channel).
+    Canvas parse_ppm_p6(std::string_view bytes, size_t width, size_t height, float maxByteValue){
+        if (bytes.size() / CHANNELS < width * height) throw ppm_parse_error("Pixel data does not match width*height.");
+        Canvas img(width, height);
+        parallel_for(img.size(), PIXELS_PER_TASK, [&img, bytes, maxByteValue](size_t begin, size_t end) noexcept{
+            for (auto i = begin; i < end; ++i) {
+                const auto rgb = bytes.substr(i * CHANNELS, CHANNELS);
+                img[i] = Color{ static_cast<uint8_t>(rgb[0]) / maxByteValue,
+                                static_cast<uint8_t>(rgb[1]) / maxByteValue,
+                                static_cast<uint8_t>(rgb[2]) / maxByteValue };
+            }
+        });
+        return img;
+    }
+}
+
+//reads P3 or P6. Color values are scaled to [0, 1] by the header's max value.
 Canvas canvas_from_ppm(std::string_view ppm) {
-    auto [width, height, maxByteValue, data_start] = parse_header(ppm);
-    std::vector<Color> pixels;
-    pixels.reserve(width * height);
-    size_t offset = data_start;
-    while (offset < ppm.size() && pixels.size() < width * height) {
-        next_non_comment(ppm, offset);
-        auto r = next_number<float>(ppm, offset) / maxByteValue;
-        auto g = next_number<float>(ppm, offset) / maxByteValue;
-        auto b = next_number<float>(ppm, offset) / maxByteValue;
-        pixels.emplace_back(r, g, b);
-    }
-    if (pixels.size() != width * height) throw ppm_parse_error("Pixel data does not match width*height."); 
-    return Canvas(width, height, std::move(pixels));
-}
\ No newline at end of file
+    const auto header = parse_header(ppm);
+    const auto pixel_data = ppm.substr(header.data_start);
+    if (header.format == PPMFormat::P6) {
+        return Detail::parse_ppm_p6(pixel_data, header.width, header.height, header.maxByteValue);
+    }
+    return Detail::parse_ppm_p3(pixel_data, header.width, header.height, header.maxByteValue);
+}
+
+//memory maps the file and parses it in place, without reading it into a buffer first.
+Canvas load_from_file(std::string_view path) {
+    const MappedFile file(path);
+    return canvas_from_ppm(file.view());
+}
@@ -1,14 +1,22 @@
 #pragma once
 #include "pch.h"
 #include "Math.h"
+#include "Simd.h"
 #include "StringHelpers.h"
+#include "ThreadPool.h"
+#include <array>
+#include <bit>
 
-struct Color final {
+struct alignas(TUPLE_ALIGNMENT) Color final {
     using value_type = Real;
     value_type r{};
     value_type g{};
     value_type b{};
+#if RTC_SIMD
+    value_type padding{}; //the 4th SIMD lane. always 0.
+#endif
 };
+static_assert(!USE_SIMD || sizeof(Color) == 16);
 
 constexpr Color color(Real r, Real g, Real b) noexcept {
     return Color{ r, g, b };
@@ -101,6 +109,68 @@ Color color_from_srgb(const Color& c) noexcept {
     return std::pow(s, (1.0f / 2.2f));
 }
 
+//the reference linear -> sRGB byte conversion. Slow (a pow per channel); the export path goes through sRGB_encode instead.
+uint8_t linear_to_sRGB_byte(Real s) noexcept {
+    return math::map_to<uint8_t>(linear_to_sRGB(std::clamp(s, 0.0f, 1.0f)));
+}
+
+static constexpr size_t SRGB_TABLE_SIZE = 4096; //buckets over the linear [0, 1] range
+
+/*Table driven linear -> sRGB byte encoding, with no pow at runtime.
+ A value's bucket holds the byte at the bucket's lower edge, and the curve climbs at most a couple of
+ bytes across one bucket (even in the steep dark end), so a short walk up the per-byte thresholds
+ finishes the job. The thresholds are the exact smallest floats that reach each byte under
+ linear_to_sRGB_byte, so the maximum error against the reference is 0: every float maps to the same byte.*/
+struct SRGBEncodeTable final {
+    std::array<uint8_t, SRGB_TABLE_SIZE> bucket_byte{};
+    std::array<Real, PPM_MAX_BYTE_VALUE + 2> threshold{}; //threshold[k]: smallest linear value that encodes to k or more
+
+    SRGBEncodeTable() noexcept {
+        for (size_t i = 0; i < bucket_byte.size(); ++i) {
+            bucket_byte[i] = linear_to_sRGB_byte(static_cast<Real>(i) / static_cast<Real>(SRGB_TABLE_SIZE));
+        }
+        const auto one = std::bit_cast<uint32_t>(1.0f);
+        for (size_t k = 0; k < threshold.size(); ++k) {
+            if (linear_to_sRGB_byte(1.0f) < k) {
+                threshold[k] = std::numeric_limits<Real>::infinity();
+                continue;
+            }
+            uint32_t lo = 0, hi = one; //bisect on the bit pattern: positive floats sort like their bits
+            while (lo < hi) {
+                const auto mid = lo + (hi - lo) / 2;
+                if (linear_to_sRGB_byte(std::bit_cast<Real>(mid)) >= k) {
+                    hi = mid;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+            threshold[k] = std::bit_cast<Real>(lo);
+        }
+    }
+
+    uint8_t encode(Real s) const noexcept {
+        if (!(s > 0.0f)) { //also catches NaN
+            return bucket_byte[0];
+        }
+        s = std::min(s, 1.0f);
+        const auto bucket = std::min(static_cast<size_t>(s * SRGB_TABLE_SIZE), SRGB_TABLE_SIZE - 1);
+        auto byte = size_t{ bucket_byte[bucket] };
+        while (s >= threshold[byte + 1]) {
+            ++byte;
+        }
+        return narrow_cast<uint8_t>(byte);
+    }
+};
+
+const SRGBEncodeTable& sRGB_encode_table() noexcept {
+    static const SRGBEncodeTable table;
+    return table;
+}
+
+uint8_t sRGB_encode(Real s) noexcept {
+    return sRGB_encode_table().encode(s);
+}
+
 //same as ByteColor, but additionally converts each pixel to the sRGB color space.
 struct ByteColor_sRGB final {
     using value_type = uint8_t;
@@ -108,11 +178,11 @@ struct ByteColor_sRGB final {
     value_type g{};
     value_type b{};
     constexpr ByteColor_sRGB() noexcept = default;
-    /*constexpr*/ explicit ByteColor_sRGB(const Color& c) noexcept {
-        const auto srgb = ByteColor(linear_to_sRGB(clamp(c, 0.0f, 1.0f)));
-        r = srgb.r;
-        g = srgb.g;
-        b = srgb.b;
+    explicit ByteColor_sRGB(const Color& c) noexcept {
+        const auto& table = sRGB_encode_table();
+        r = table.encode(c.r);
+        g = table.encode(c.g);
+        b = table.encode(c.b);
     };
 };
 
@@ -134,25 +204,62 @@ static constexpr auto PURPLE = MAGENTA;
 
 //Color interface
 constexpr Color operator*(const Color& lhs, const Color& rhs) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Color result;
+        simd::store(&result.r, simd::mul(simd::load(&lhs.r), simd::load(&rhs.r)));
+        return result;
+    }
+#endif
     return { lhs.r * rhs.r, lhs.g * rhs.g, lhs.b * rhs.b }; //hadamard product
 }
 constexpr Color operator*(const Color& lhs, Real scalar) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Color result;
+        simd::store(&result.r, simd::mul(simd::load(&lhs.r), simd::splat(scalar)));
+        return result;
+    }
+#endif
     return Color{ lhs.r * scalar, lhs.g * scalar, lhs.b * scalar };
 }
 constexpr void operator*=(Color& lhs, Real scalar) noexcept {
-    lhs.r *= scalar;
-    lhs.g *= scalar;
-    lhs.b *= scalar;
+    lhs = lhs * scalar;
 }
 constexpr Color operator/(const Color& lhs, Real scalar) noexcept {
     return Color{ lhs.r / scalar, lhs.g / scalar, lhs.b / scalar };
 }
 constexpr Color operator+(const Color& lhs, Color rhs) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Color result;
+        simd::store(&result.r, simd::add(simd::load(&lhs.r), simd::load(&rhs.r)));
+        return result;
+    }
+#endif
     return Color{ lhs.r + rhs.r, lhs.g + rhs.g, lhs.b + rhs.b };
 }
 constexpr Color operator-(const Color& lhs, Color rhs) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Color result;
+        simd::store(&result.r, simd::sub(simd::load(&lhs.r), simd::load(&rhs.r)));
+        return result;
+    }
+#endif
     return Color{ lhs.r - rhs.r, lhs.g - rhs.g, lhs.b - rhs.b };
 }
+//c * scale + offset
+constexpr Color madd(const Color& c, Real scale, const Color& offset) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Color result;
+        simd::store(&result.r, simd::madd(simd::load(&c.r), simd::splat(scale), simd::load(&offset.r)));
+        return result;
+    }
+#endif
+    return Color{ c.r * scale + offset.r, c.g * scale + offset.g, c.b * scale + offset.b };
+}
 constexpr bool operator==(const Color& lhs, const Color& rhs) noexcept {
     using math::float_cmp;
     constexpr auto epsilon = 0.0005f;
@@ -169,9 +276,12 @@ constexpr Color lerp(Color start, Color end, Real t) {
 }
 
 void to_sRGB(std::span<Color> buffer) noexcept {
-    std::for_each(std::execution::par, buffer.begin(), buffer.end(),
-        [](auto& color) constexpr -> void { to_sRGB(color); }
-    );
+    constexpr size_t COLORS_PER_TASK = 4096;
+    parallel_for(buffer.size(), COLORS_PER_TASK, [buffer](size_t begin, size_t end) noexcept {
+        for (auto i = begin; i < end; ++i) {
+            to_sRGB(buffer[i]);
+        }
+    });
 }
 
 //print and string features
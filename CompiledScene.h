@@ -0,0 +1,449 @@
+#pragma once
+#include "pch.h"
+#include <array>
+#include <bit>
+#include <vector>
+#include "Ray.h"
+#include "Shapes.h"
+#include "World.h"
+#include "Intersection.h"
+#include "TransformArrays.h"
+
+/*
+ * A World flattened for packets of primary rays: its shapes grouped by type, each type stored as a
+ * structure of arrays.
+ *
+ * World::objects is a vector of variants, so every test pays for a dispatch and strides over
+ * elements sized for the largest shape. Here each type keeps its inverse transforms as 12 parallel
+ * arrays (one per matrix element), next to any per-shape data its intersection needs (cylinder and
+ * cone extents), and is intersected in a loop of its own. Spheres, planes and cubes are intersected
+ * with all 4 rays of a packet at once with SSE when RTC_SIMD is on, with the same arithmetic as their
+ * local_intersect. Cylinders and cones still go through their scalar local_intersect, one ray at a time.
+ *
+ * Every object is tested for every packet; there is no hierarchy. For the spheres, cubes and planes of
+ * the book chapters that beats the BVH, whose tree is only a level or two deep. Packets over a bigger
+ * World walk the World's BVH instead (see PACKET_FLAT_LIMIT). Single rays, like the shadow and
+ * secondary rays of shading, use the World's queries in Intersection.h. Build it with compile(world)
+ * once the world is complete, and rebuild it if the world changes. It refers back to the world for
+ * the objects (and for meshes and instances, which it doesn't flatten), so the world must outlive it.
+ */
+
+//CylinderExtents and ConeExtents, one array per member.
+struct ExtentArrays final {
+    std::vector<Real> minimum;
+    std::vector<Real> maximum;
+    std::vector<uint8_t> closed;
+
+    void push_back(Real min, Real max, bool is_closed) {
+        minimum.push_back(min);
+        maximum.push_back(max);
+        closed.push_back(is_closed ? 1 : 0);
+    }
+};
+
+struct CompiledScene final {
+    const World* world = nullptr;
+    TransformArrays spheres;
+    TransformArrays planes;
+    TransformArrays cubes;
+    TransformArrays cylinders;
+    ExtentArrays cylinder_extents;
+    TransformArrays cones;
+    ExtentArrays cone_extents;
+    std::vector<uint32_t> meshes; //meshes have a BVH of their own, so they're intersected through the World
+
+    constexpr size_t size() const noexcept {
+        return spheres.size() + planes.size() + cubes.size() + cylinders.size() + cones.size() + meshes.size();
+    }
+};
+
+inline CompiledScene compile(const World& world) {
+    CompiledScene scene;
+    scene.world = &world;
+    for (size_t i = 0; i < world.size(); ++i) {
+        std::visit([&scene, i](const auto& obj) {
+            using T = std::decay_t<decltype(obj)>;
+            if constexpr (std::is_same_v<T, Sphere>) {
+                scene.spheres.push_back(obj.inv_transform(), i);
+            } else if constexpr (std::is_same_v<T, Plane>) {
+                scene.planes.push_back(obj.inv_transform(), i);
+            } else if constexpr (std::is_same_v<T, Cube>) {
+                scene.cubes.push_back(obj.inv_transform(), i);
+            } else if constexpr (std::is_same_v<T, Cylinder>) {
+                scene.cylinders.push_back(obj.inv_transform(), i);
+                scene.cylinder_extents.push_back(obj.minimum, obj.maximum, obj.closed);
+            } else if constexpr (std::is_same_v<T, Cone>) {
+                scene.cones.push_back(obj.inv_transform(), i);
+                scene.cone_extents.push_back(obj.minimum, obj.maximum, obj.closed);
+            } else {
+                static_assert(std::is_same_v<T, Mesh>);
+                scene.meshes.push_back(narrow_cast<uint32_t>(i));
+            }
+        }, world[i]);
+    }
+    return scene;
+}
+
+namespace Detail {
+    //a ray in the object space of one shape, as plain lanes.
+    struct LocalRay final {
+        Real x, y, z;
+        Real dx, dy, dz;
+    };
+
+    //the same operations in the same order as Affine * Ray, so distances match the World's bit for bit.
+    constexpr LocalRay local_ray(const TransformArrays& t, size_t i, const Ray& r) noexcept {
+        const auto& m = t.inv;
+        return LocalRay{
+            r.x() * m[0][i] + r.y() * m[1][i] + r.z() * m[2][i] + m[3][i],
+            r.x() * m[4][i] + r.y() * m[5][i] + r.z() * m[6][i] + m[7][i],
+            r.x() * m[8][i] + r.y() * m[9][i] + r.z() * m[10][i] + m[11][i],
+            r.dx() * m[0][i] + r.dy() * m[1][i] + r.dz() * m[2][i],
+            r.dx() * m[4][i] + r.dy() * m[5][i] + r.dz() * m[6][i],
+            r.dx() * m[8][i] + r.dy() * m[9][i] + r.dz() * m[10][i]
+        };
+    }
+
+#if RTC_SIMD
+    /*The nearest hit with t >= t_min on spheres, planes and cubes, for 4 local rays at a time: one shape
+     against the 4 rays of a packet. Every step is an operation of local_intersect on 4 lanes, and
+     _mm_max_ps / _mm_min_ps are exactly (a > b) ? a : b and (a < b) ? a : b, like math::max and
+     math::min, so each lane gives local_intersect's result bit for bit, or NO_HIT.*/
+    struct LocalRay4 final {
+        simd::f32x4 x, y, z;
+        simd::f32x4 dx, dy, dz;
+    };
+
+    inline simd::f32x4 nearest_of(simd::f32x4 t1, simd::f32x4 t2, simd::f32x4 t_min) noexcept {
+        const auto second = _mm_blendv_ps(simd::splat(NO_HIT), t2, _mm_cmpge_ps(t2, t_min));
+        return _mm_blendv_ps(second, t1, _mm_cmpge_ps(t1, t_min));
+    }
+
+    inline simd::f32x4 negate(simd::f32x4 v) noexcept {
+        return _mm_xor_ps(v, simd::splat(-0.0f));
+    }
+    inline simd::f32x4 abs(simd::f32x4 v) noexcept {
+        return _mm_andnot_ps(simd::splat(-0.0f), v);
+    }
+
+    inline simd::f32x4 nearest_sphere_hit(const LocalRay4& l, simd::f32x4 t_min) noexcept {
+        using namespace simd;
+        const auto two = splat(2.0f);
+        const auto a = mul(two, add(add(mul(l.dx, l.dx), mul(l.dy, l.dy)), mul(l.dz, l.dz)));
+        const auto b = mul(two, add(add(mul(l.dx, l.x), mul(l.dy, l.y)), mul(l.dz, l.z)));
+        const auto c = sub(add(add(mul(l.x, l.x), mul(l.y, l.y)), mul(l.z, l.z)), splat(1.0f));
+        const auto discriminant = sub(mul(b, b), mul(mul(two, a), c));
+        const auto x1 = _mm_div_ps(negate(b), a);
+        const auto sqrt_det = _mm_div_ps(_mm_sqrt_ps(_mm_max_ps(discriminant, _mm_setzero_ps())), a);
+        const auto t = nearest_of(sub(x1, sqrt_det), add(x1, sqrt_det), t_min);
+        return _mm_blendv_ps(t, splat(NO_HIT), _mm_cmplt_ps(discriminant, _mm_setzero_ps()));
+    }
+
+    inline simd::f32x4 nearest_plane_hit(const LocalRay4& l, simd::f32x4 t_min) noexcept {
+        const auto t = _mm_div_ps(negate(l.y), l.dy);
+        const auto hit = _mm_and_ps(_mm_cmpnlt_ps(abs(l.dy), simd::splat(math::BOOK_EPSILON)), _mm_cmpge_ps(t, t_min));
+        return _mm_blendv_ps(simd::splat(NO_HIT), t, hit);
+    }
+
+    struct Slab4 final {
+        simd::f32x4 tmin, tmax;
+    };
+    //check_axis for 4 lanes
+    inline Slab4 check_axis(simd::f32x4 origin, simd::f32x4 direction) noexcept {
+        using namespace simd;
+        const auto tmin_numerator = sub(splat(-1.0f), origin);
+        const auto tmax_numerator = sub(splat(1.0f), origin);
+        const auto divide = _mm_cmpge_ps(abs(direction), splat(math::BOOK_EPSILON));
+        const auto tmin = _mm_blendv_ps(mul(tmin_numerator, splat(math::MAX)), _mm_div_ps(tmin_numerator, direction), divide);
+        const auto tmax = _mm_blendv_ps(mul(tmax_numerator, splat(math::MAX)), _mm_div_ps(tmax_numerator, direction), divide);
+        const auto swap = _mm_cmpgt_ps(tmin, tmax);
+        return Slab4{ _mm_blendv_ps(tmin, tmax, swap), _mm_blendv_ps(tmax, tmin, swap) };
+    }
+
+    inline simd::f32x4 nearest_cube_hit(const LocalRay4& l, simd::f32x4 t_min) noexcept {
+        const auto x = check_axis(l.x, l.dx);
+        const auto y = check_axis(l.y, l.dy);
+        const auto z = check_axis(l.z, l.dz);
+        const auto tmin = _mm_max_ps(_mm_max_ps(x.tmin, y.tmin), z.tmin);
+        const auto tmax = _mm_min_ps(_mm_min_ps(x.tmax, y.tmax), z.tmax);
+        const auto t = nearest_of(tmin, tmax, t_min);
+        return _mm_blendv_ps(t, simd::splat(NO_HIT), _mm_cmpgt_ps(tmin, tmax));
+    }
+#endif
+
+    //a kernel for shapes without a 4 wide version: nearest(i, local_ray, t_min).
+    template<class Extents>
+    struct ExtentsKernel final {
+        const ExtentArrays& extents;
+        constexpr Real operator()(size_t i, const LocalRay& l, Real t_min) const noexcept {
+            const auto shape = Extents{ extents.minimum[i], extents.maximum[i], extents.closed[i] != 0 };
+            Real nearest = NO_HIT;
+            for (const auto t : local_intersect(shape, ray(point(l.x, l.y, l.z), vector(l.dx, l.dy, l.dz)))) {
+                if (t >= t_min && t < nearest) {
+                    nearest = t;
+                }
+            }
+            return nearest;
+        }
+    };
+
+#if RTC_SIMD
+    //the unit shapes need nothing but the local rays.
+    struct SphereKernel final {
+        simd::f32x4 operator()(const LocalRay4& l, simd::f32x4 t_min) const noexcept { return nearest_sphere_hit(l, t_min); }
+    };
+    struct PlaneKernel final {
+        simd::f32x4 operator()(const LocalRay4& l, simd::f32x4 t_min) const noexcept { return nearest_plane_hit(l, t_min); }
+    };
+    struct CubeKernel final {
+        simd::f32x4 operator()(const LocalRay4& l, simd::f32x4 t_min) const noexcept { return nearest_cube_hit(l, t_min); }
+    };
+#endif
+
+    struct SceneHit final {
+        Real t = NO_HIT;
+        uint32_t object = 0; //an index into the World's objects, or past them, into its instances
+        Intersection found{}; //set when the hit is on a mesh or an instance, which object alone can't say
+
+        //nearer wins, and on a tie the shape that comes first in the World, like closest_hit(world, r).
+        constexpr bool is_beaten_by(Real t_other, uint32_t other) const noexcept {
+            return t_other < t || (t_other == t && other < object);
+        }
+    };
+
+    //finds the nearest hit with t >= t_min among the shapes of one type, closer than hit.t, one shape at a time.
+    template<class Kernel>
+    constexpr void nearest_hit(const TransformArrays& shapes, const Ray& r, Real t_min, SceneHit& hit, const Kernel& nearest) noexcept {
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            const auto t = nearest(i, local_ray(shapes, i, r), t_min);
+            if (hit.is_beaten_by(t, shapes.object[i])) {
+                hit = SceneHit{ t, shapes.object[i] };
+            }
+        }
+    }
+
+    //the shapes without a 4 wide kernel: cylinders, cones, meshes, and the World's instances.
+    constexpr void nearest_scalar_hit(const CompiledScene& scene, const Ray& r, Real t_min, SceneHit& hit) noexcept {
+        nearest_hit(scene.cylinders, r, t_min, hit, ExtentsKernel<CylinderExtents>{ scene.cylinder_extents });
+        nearest_hit(scene.cones, r, t_min, hit, ExtentsKernel<ConeExtents>{ scene.cone_extents });
+        const auto& world = *scene.world;
+        for (const auto i : scene.meshes) {
+            const auto x = ::nearest_hit(world[i], r, t_min, hit.t);
+            if (x && hit.is_beaten_by(x.t, i)) {
+                hit = SceneHit{ x.t, i, x };
+            }
+        }
+        if (!world.instances().empty()) {
+            const auto x = nearest_instance_hit(world, r, t_min, hit.t);
+            const auto i = x ? narrow_cast<uint32_t>(world.size() + static_cast<size_t>(x.instance - world.instances().data())) : 0;
+            if (x && hit.is_beaten_by(x.t, i)) {
+                hit = SceneHit{ x.t, i, x };
+            }
+        }
+    }
+
+    constexpr Intersection resolve(const CompiledScene& scene, const SceneHit& hit) noexcept {
+        return hit.found ? hit.found : intersection(hit.t, (*scene.world)[hit.object]);
+    }
+}
+
+/*
+ * Ray packets: closest hits for RAY_PACKET_SIZE rays at once, SIMD across the rays instead of across
+ * the shapes. Meant for primary rays, which start at the same point and point in nearly the same
+ * direction, so the 4 rays of a packet hit the same shapes. Each shape is transformed once for the
+ * whole packet. Spheres, planes and cubes go through the 4 wide kernels above, one lane per ray.
+ * The results are the same as 4 calls to closest_hit(world, r).
+ *
+ * That is still every shape for every packet. Above PACKET_FLAT_LIMIT objects the packet walks the
+ * World's BVH instead: each box is tested against the 4 rays at once, and the objects in the leaves
+ * are tested one ray at a time, for the rays that reach them, with the same results.
+ */
+static constexpr size_t RAY_PACKET_SIZE = 4;
+static constexpr size_t PACKET_FLAT_LIMIT = 8; //objects. past a handful, the BVH beats testing them all, even 4 rays at a time
+using RayPacket = std::array<Ray, RAY_PACKET_SIZE>;
+using PacketHits = std::array<Intersection, RAY_PACKET_SIZE>;
+
+namespace Detail {
+#if RTC_SIMD
+    inline LocalRay4 load_packet(const RayPacket& rays) noexcept {
+        const auto lane = [&rays](auto component) noexcept {
+            return _mm_setr_ps(component(rays[0]), component(rays[1]), component(rays[2]), component(rays[3]));
+        };
+        return LocalRay4{
+            lane([](const Ray& r) noexcept { return r.x(); }), lane([](const Ray& r) noexcept { return r.y(); }), lane([](const Ray& r) noexcept { return r.z(); }),
+            lane([](const Ray& r) noexcept { return r.dx(); }), lane([](const Ray& r) noexcept { return r.dy(); }), lane([](const Ray& r) noexcept { return r.dz(); })
+        };
+    }
+
+    //shape i's inverse transform applied to every ray of the packet; local_ray4 with the roles swapped.
+    inline LocalRay4 local_packet(const TransformArrays& t, size_t i, const LocalRay4& rays) noexcept {
+        using namespace simd;
+        const auto m = [&t, i](size_t e) noexcept { return splat(t.inv[e][i]); };
+        return LocalRay4{
+            add(madd(rays.z, m(2), madd(rays.y, m(1), mul(rays.x, m(0)))), m(3)),
+            add(madd(rays.z, m(6), madd(rays.y, m(5), mul(rays.x, m(4)))), m(7)),
+            add(madd(rays.z, m(10), madd(rays.y, m(9), mul(rays.x, m(8)))), m(11)),
+            madd(rays.dz, m(2), madd(rays.dy, m(1), mul(rays.dx, m(0)))),
+            madd(rays.dz, m(6), madd(rays.dy, m(5), mul(rays.dx, m(4)))),
+            madd(rays.dz, m(10), madd(rays.dy, m(9), mul(rays.dx, m(8))))
+        };
+    }
+
+    struct PacketHit final {
+        simd::f32x4 t = simd::splat(NO_HIT);
+        __m128i object = _mm_setzero_si128();
+    };
+
+    template<class Kernel>
+    inline void nearest_hits(const TransformArrays& shapes, const LocalRay4& rays, PacketHit& hit, const Kernel& nearest) noexcept {
+        const auto t_min = _mm_setzero_ps();
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            const auto t = nearest(local_packet(shapes, i, rays), t_min);
+            const auto object = _mm_set1_epi32(static_cast<int>(shapes.object[i]));
+            const auto first_in_world = _mm_castsi128_ps(_mm_cmplt_epi32(object, hit.object));
+            const auto closer = _mm_or_ps(_mm_cmplt_ps(t, hit.t), _mm_and_ps(_mm_cmpeq_ps(t, hit.t), first_in_world)); //SceneHit::is_beaten_by
+            hit.t = _mm_blendv_ps(hit.t, t, closer);
+            hit.object = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(hit.object), _mm_castsi128_ps(object), closer));
+        }
+    }
+
+    //the rays of a packet as slab_ray makes them, one lane per ray.
+    struct SlabPacket final {
+        simd::f32x4 x, y, z;
+        simd::f32x4 inv_dx, inv_dy, inv_dz;
+    };
+
+    inline SlabPacket slab_packet(const RayPacket& rays) noexcept {
+        const std::array<SlabRay, RAY_PACKET_SIZE> s{ slab_ray(rays[0]), slab_ray(rays[1]), slab_ray(rays[2]), slab_ray(rays[3]) };
+        const auto lane = [&s](auto component) noexcept {
+            return _mm_setr_ps(component(s[0]), component(s[1]), component(s[2]), component(s[3]));
+        };
+        return SlabPacket{
+            lane([](const SlabRay& r) noexcept { return r.origin.x; }), lane([](const SlabRay& r) noexcept { return r.origin.y; }), lane([](const SlabRay& r) noexcept { return r.origin.z; }),
+            lane([](const SlabRay& r) noexcept { return r.inv_direction.x; }), lane([](const SlabRay& r) noexcept { return r.inv_direction.y; }), lane([](const SlabRay& r) noexcept { return r.inv_direction.z; })
+        };
+    }
+
+    //entry_distance for the 4 rays of a packet, each with a t_max of its own and a t_min of 0. Rays that miss get BOX_MISS.
+    inline simd::f32x4 entry_distances(const AABB& box, const SlabPacket& p, simd::f32x4 t_max) noexcept {
+        using namespace simd;
+        const auto slab = [](Real min, Real max, f32x4 origin, f32x4 inv_dir) noexcept {
+            const auto t0 = mul(sub(splat(min), origin), inv_dir);
+            const auto t1 = mul(sub(splat(max), origin), inv_dir);
+            return Slab4{ _mm_min_ps(t0, t1), _mm_max_ps(t0, t1) };
+        };
+        const auto x = slab(box.min.x, box.max.x, p.x, p.inv_dx);
+        const auto y = slab(box.min.y, box.max.y, p.y, p.inv_dy);
+        const auto z = slab(box.min.z, box.max.z, p.z, p.inv_dz);
+        const auto enter = _mm_max_ps(_mm_setzero_ps(), _mm_max_ps(_mm_max_ps(x.tmin, y.tmin), z.tmin));
+        const auto exit = _mm_min_ps(t_max, _mm_min_ps(_mm_min_ps(x.tmax, y.tmax), z.tmax));
+        return _mm_blendv_ps(splat(BOX_MISS), enter, _mm_cmple_ps(enter, exit));
+    }
+
+    //one bit per ray that enters the box no later than its nearest hit so far.
+    inline unsigned entering_rays(simd::f32x4 t_entry, simd::f32x4 t_max) noexcept {
+        const auto entered = _mm_and_ps(_mm_cmplt_ps(t_entry, simd::splat(BOX_MISS)), _mm_cmple_ps(t_entry, t_max));
+        return static_cast<unsigned>(_mm_movemask_ps(entered));
+    }
+
+    /*closest_hit(world, r) for the 4 rays of a packet, through the World's BVH, nearest box first.
+     A box is tested against every ray at once and skipped when no ray reaches it before its nearest
+     hit so far. Objects are tested one ray at a time, like nearest_hit(objects, bvh, ...), so each ray
+     keeps the same nearest hit and the same winner of a tie.*/
+    inline PacketHits closest_hits(const World& world, const RayPacket& rays) noexcept {
+        assert(world.is_built() && "closest_hits: the World's BVH is out of date");
+        const auto objects = world.objects();
+        const auto& bvh = world.bvh();
+        std::array<Intersection, RAY_PACKET_SIZE> best;
+        best.fill(Intersection{ nullptr, math::MAX });
+        const auto consider = [&objects, &rays, &best](size_t k, size_t i) noexcept {
+            const auto hit = ::nearest_hit(objects[i], rays[k], 0.0f, best[k].t);
+            if (hit && (!best[k] || hit.t < best[k].t || hit.objPtr < best[k].objPtr)) {
+                best[k] = hit;
+            }
+        };
+        const auto t_max = [&best]() noexcept {
+            return _mm_setr_ps(best[0].t, best[1].t, best[2].t, best[3].t);
+        };
+        for (const auto i : bvh.unbounded) {
+            for (size_t k = 0; k < RAY_PACKET_SIZE; ++k) {
+                consider(k, i);
+            }
+        }
+        if (!bvh.nodes.empty()) {
+            const auto packet = slab_packet(rays);
+            struct Entry { BVH::size_type node; simd::f32x4 t; };
+            std::array<Entry, BVH::MAX_DEPTH * 2> stack;
+            size_t top = 0;
+            stack[top++] = Entry{ 0, entry_distances(bvh.nodes[0].bounds, packet, t_max()) };
+            while (top > 0) {
+                const auto [node_index, t_entry] = stack[--top];
+                const auto rays_in = entering_rays(t_entry, t_max());
+                if (rays_in == 0) {
+                    continue; //missed, or behind every ray's nearest hit
+                }
+                const auto& node = bvh.nodes[node_index];
+                if (node.is_leaf()) {
+                    for (auto j = node.first; j < node.first + node.count; ++j) {
+                        for (auto lanes = rays_in; lanes != 0; lanes &= lanes - 1) {
+                            consider(static_cast<size_t>(std::countr_zero(lanes)), bvh.indices[j]);
+                        }
+                    }
+                    continue;
+                }
+                const auto current = t_max();
+                auto closer = Entry{ node.first, entry_distances(bvh.nodes[node.first].bounds, packet, current) };
+                auto farther = Entry{ node.first + 1, entry_distances(bvh.nodes[node.first + 1].bounds, packet, current) };
+                if (_mm_cvtss_f32(simd::min_lane(farther.t)) < _mm_cvtss_f32(simd::min_lane(closer.t))) {
+                    std::swap(closer, farther);
+                }
+                if (entering_rays(farther.t, current) != 0) {
+                    assert(top < stack.size() && "closest_hits: BVH traversal stack overflow");
+                    stack[top++] = farther;
+                }
+                if (entering_rays(closer.t, current) != 0) {
+                    assert(top < stack.size() && "closest_hits: BVH traversal stack overflow");
+                    stack[top++] = closer; //pushed last so it's popped first: front-to-back
+                }
+            }
+        }
+        PacketHits result{};
+        for (size_t k = 0; k < RAY_PACKET_SIZE; ++k) {
+            result[k] = closest_with_instances(world, rays[k], best[k] ? best[k] : Intersection{});
+        }
+        return result;
+    }
+#endif
+}
+
+inline PacketHits closest_hits(const CompiledScene& scene, const RayPacket& rays) noexcept {
+    assert(scene.world != nullptr && "closest_hits: the scene was not compiled from a World");
+    PacketHits result{};
+#if RTC_SIMD
+    if (scene.world->is_built() && scene.world->size() > PACKET_FLAT_LIMIT) {
+        return Detail::closest_hits(*scene.world, rays);
+    }
+    using namespace Detail;
+    const auto packet = load_packet(rays);
+    PacketHit simd_hit;
+    nearest_hits(scene.spheres, packet, simd_hit, SphereKernel{});
+    nearest_hits(scene.planes, packet, simd_hit, PlaneKernel{});
+    nearest_hits(scene.cubes, packet, simd_hit, CubeKernel{});
+    alignas(16) std::array<Real, RAY_PACKET_SIZE> ts;
+    alignas(16) std::array<uint32_t, RAY_PACKET_SIZE> objects;
+    _mm_store_ps(ts.data(), simd_hit.t);
+    _mm_store_si128(reinterpret_cast<__m128i*>(objects.data()), simd_hit.object);
+    for (size_t k = 0; k < RAY_PACKET_SIZE; ++k) { //the rest one ray at a time, in the same order as closest_hit
+        SceneHit hit{ ts[k], objects[k] };
+        nearest_scalar_hit(scene, rays[k], 0.0f, hit);
+        if (hit.t != NO_HIT) {
+            result[k] = resolve(scene, hit);
+        }
+    }
+#else
+    for (size_t k = 0; k < RAY_PACKET_SIZE; ++k) {
+        result[k] = closest_hit(*scene.world, rays[k]);
+    }
+#endif
+    return result;
+}
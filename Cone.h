@@ -3,9 +3,11 @@
 #include "Tuple.h"
 #include "Color.h"
 #include "Matrix.h"
+#include "Affine.h"
 #include "Material.h"
 #include "Ray.h"
-struct Group;
+#include "AABB.h"
+#include "InlineVector.h"
 
 struct Cone final {     
     Real minimum = math::MIN; //cone extents on the Y-axis. Up-to but not including this value.
@@ -13,55 +15,47 @@ struct Cone final {
     bool closed = false; 
     constexpr Cone() noexcept = default;    
     constexpr Cone(Real min, Real max, bool closed_ = false) noexcept : minimum(min), maximum(max), closed(closed_) {}
-    explicit constexpr Cone(Material m) noexcept : _surface(std::move(m)) {}
+    explicit constexpr Cone(MaterialId m) noexcept : _material(m) {}
     explicit constexpr Cone(Matrix4 transf) noexcept {
         set_transform(std::move(transf));
     }
-    constexpr Cone(Material m, Matrix4 transf) noexcept : _surface(std::move(m)) {
+    constexpr Cone(MaterialId m, Matrix4 transf) noexcept : _material(m) {
         set_transform(std::move(transf));
     }   
-    constexpr Cone(Real min, Real max, Material m, Matrix4 transform) noexcept : minimum(min), maximum(max), _surface(std::move(m)) {
+    constexpr Cone(Real min, Real max, MaterialId m, Matrix4 transform) noexcept : minimum(min), maximum(max), _material(m) {
         set_transform(std::move(transform));
     }
-    constexpr Cone(Real min, Real max, bool closed_, Material m, Matrix4 transform) noexcept : minimum(min), maximum(max), closed(closed_), _surface(std::move(m)) {
+    constexpr Cone(Real min, Real max, bool closed_, MaterialId m, Matrix4 transform) noexcept : minimum(min), maximum(max), closed(closed_), _material(m) {
         set_transform(std::move(transform));
     }
     constexpr auto operator==(const Cone& that) const noexcept {
-        return surface() == that.surface() && _transform == that._transform;
+        return _material == that._material && _transform == that._transform;
     }
-    constexpr const Matrix4& get_transform() const noexcept {
+    constexpr const Affine& get_transform() const noexcept {
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept {
+    constexpr const Affine& inv_transform() const noexcept {
         return _invTransform;
     }
+    constexpr const Matrix3& normal_transform() const noexcept {
+        return _normalTransform;
+    }
     constexpr void set_transform(Matrix4 mat) noexcept {
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
+        _normalTransform = normal_matrix(_invTransform);
     }
-    constexpr const Material& surface() const noexcept {
-        return _surface;
-    }
-    constexpr const Color& color() const noexcept{
-        return surface().color;
-    }
-    constexpr Material& surface() noexcept {
-        return _surface;
-    }
-    constexpr Color& color() noexcept{
-        return surface().color;
+    constexpr MaterialId material_id() const noexcept {
+        return _material;
     }
-    constexpr void set_parent(Group* g) noexcept{
-        _parent = g;
-    }
-    constexpr Group* get_parent() const noexcept{
-        return _parent;
+    constexpr void set_material(MaterialId m) noexcept {
+        _material = m;
     }
 private: 
-    Material _surface{ material() };   
-    Matrix4 _transform{ Matrix4Identity };
-    Matrix4 _invTransform{ Matrix4Identity };
-    Group* _parent = nullptr;
+    MaterialId _material = DEFAULT_MATERIAL_ID;
+    Affine _transform{ AffineIdentity };
+    Affine _invTransform{ AffineIdentity };
+    Matrix3 _normalTransform{ Matrix3Identity };
 };
 
 constexpr Cone cone() noexcept {
@@ -70,26 +64,23 @@ constexpr Cone cone() noexcept {
 constexpr Cone cone(Real min, Real max) noexcept {
     return {min, max};
 }
-constexpr Cone cone(Color col) noexcept {
-    return Cone( material(col) );    
-}
-constexpr Cone cone(Material m) noexcept {
-    return Cone( std::move(m) );    
+constexpr Cone cone(MaterialId m) noexcept {
+    return Cone(m);    
 }
 constexpr Cone sphconeere(Matrix4 transform) noexcept {
     return Cone(std::move(transform));    
 }
-constexpr Cone cone(Material m, Matrix4 transform) noexcept {
-    return Cone(std::move(m), std::move(transform));    
+constexpr Cone cone(MaterialId m, Matrix4 transform) noexcept {
+    return Cone(m, std::move(transform));    
 }
-constexpr Cone cone(Real min, Real max, Material m, Matrix4 transform) noexcept {
-    return Cone(min, max, std::move(m), std::move(transform));    
+constexpr Cone cone(Real min, Real max, MaterialId m, Matrix4 transform) noexcept {
+    return Cone(min, max, m, std::move(transform));    
 }
 constexpr Cone closed_cone(Real min, Real max) noexcept {
     return Cone(min, max, true);
 }
-constexpr Cone closed_cone(Real min, Real max, Material m, Matrix4 transform) noexcept {
-    return Cone(min, max, true, std::move(m), std::move(transform));    
+constexpr Cone closed_cone(Real min, Real max, MaterialId m, Matrix4 transform) noexcept {
+    return Cone(min, max, true, m, std::move(transform));    
 }
 
 constexpr Vector local_normal_at([[maybe_unused]]const Cone& c, const Point& p) noexcept {
@@ -110,6 +101,17 @@ constexpr Vector local_normal_at([[maybe_unused]]const Cone& c, const Point& p)
     return normal_vector(p.x, y, p.z);
 }
 
+//same as CylinderExtents: all local_intersect needs to know about a cone.
+struct ConeExtents final {
+    Real minimum = math::MIN;
+    Real maximum = math::MAX;
+    bool closed = false;
+};
+
+constexpr ConeExtents extents(const Cone& c) noexcept {
+    return ConeExtents{ c.minimum, c.maximum, c.closed };
+}
+
 constexpr bool is_bounded(const Cone& c) noexcept {
     return !(c.maximum == math::MAX && c.minimum == math::MIN);    
 }
@@ -117,6 +119,9 @@ constexpr bool is_bounded(const Cone& c) noexcept {
 constexpr bool is_closed(const Cone& c) noexcept {
     return c.closed;    
 }
+constexpr bool is_open(const ConeExtents& c) noexcept {
+    return !c.closed;
+}
 constexpr bool is_open(const Cone& c) noexcept {
     return !is_closed(c);    
 }
@@ -129,7 +134,7 @@ constexpr bool check_cap(const Ray& ray, Real t, Real y) noexcept {
     return (square(x) + square(z)) <= square(y);
 }
 
-constexpr void intersect_caps(const Cone& cone, const Ray& ray, std::vector<Real>& xs) noexcept {
+constexpr void intersect_caps(const ConeExtents& cone, const Ray& ray, LocalHits& xs) noexcept {
     if (is_open(cone) || math::is_zero(ray.dy())) {
         return; //caps only matter if the cone is closed and might possibly be intersected by the ray
     }
@@ -143,10 +148,20 @@ constexpr void intersect_caps(const Cone& cone, const Ray& ray, std::vector<Real
     }
 }
 
+//object space bounds: the cone's radius at any y is |y|, so the widest point is at whichever extent is furthest from the tip.
+//a cone missing either extent grows forever and gets an infinite box.
+constexpr AABB local_bounds(const Cone& c) noexcept {
+    if (c.minimum == math::MIN || c.maximum == math::MAX) {
+        return infinite_aabb();
+    }
+    const auto radius = std::max(math::abs(c.minimum), math::abs(c.maximum));
+    return aabb(point(-radius, c.minimum, -radius), point(radius, c.maximum, radius));
+}
+
 //TODO: refactor this overly long function.
-constexpr auto local_intersect([[maybe_unused]] const Cone& cone, const Ray& local_ray) noexcept {
+constexpr LocalHits local_intersect(const ConeExtents& cone, const Ray& local_ray) noexcept {
     using math::square, math::is_zero, math::sqrt, math::is_between, math::max, math::abs;
-    std::vector<Real> result;
+    LocalHits result;
     const auto a = square(local_ray.dx()) - square(local_ray.dy()) + square(local_ray.dz());   
     const auto b = 2 * ((local_ray.x() * local_ray.dx()) - (local_ray.y() * local_ray.dy()) + (local_ray.z() * local_ray.dz()));
     const auto c = square(local_ray.x()) - square(local_ray.y()) + square(local_ray.z());
@@ -156,7 +171,9 @@ constexpr auto local_intersect([[maybe_unused]] const Cone& cone, const Ray& loc
     if (is_zero(a)){  //In this case the ray will miss when both a and b are zero.
         if (!is_zero(b)) { //If a is zero but b isnt, calc the single point of intersection:
             const auto t = -c / (2.0f * b);
-            result.push_back(t);
+            if (is_between(local_ray.y() + t * local_ray.dy(), cone.minimum, cone.maximum)) {
+                result.push_back(t);
+            }
         }
     }    
     else {// a is non-zero
@@ -183,4 +200,8 @@ constexpr auto local_intersect([[maybe_unused]] const Cone& cone, const Ray& loc
     }
     intersect_caps(cone, local_ray, result);
     return result;
-};
\ No newline at end of file
+};
+
+constexpr LocalHits local_intersect(const Cone& cone, const Ray& local_ray) noexcept {
+    return local_intersect(extents(cone), local_ray);
+}
\ No newline at end of file
@@ -2,71 +2,62 @@
 #include "pch.h"
 #include "Tuple.h"
 #include "Matrix.h"
+#include "Affine.h"
 #include "Material.h"
 #include "Ray.h"
-struct Group;
+#include "AABB.h"
+#include "InlineVector.h"
 /*A unit AABB, always positioned at 0, 0, 0 and extending from -1 to +1f*/
 struct Cube final{
     constexpr Cube() noexcept = default;
-    explicit constexpr Cube(Material m) noexcept : _surface(std::move(m)){}
+    explicit constexpr Cube(MaterialId m) noexcept : _material(m){}
     explicit constexpr Cube(Matrix4 transf) noexcept{
         set_transform(std::move(transf));
     }
-    constexpr Cube(Material m, Matrix4 transf) noexcept : _surface(std::move(m)){
+    constexpr Cube(MaterialId m, Matrix4 transf) noexcept : _material(m){
         set_transform(std::move(transf));
     }
     constexpr auto operator==(const Cube& that) const noexcept{
-        return _surface == that._surface && _transform == that._transform;
+        return _material == that._material && _transform == that._transform;
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
+    constexpr const Matrix3& normal_transform() const noexcept{
+        return _normalTransform;
+    }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
+        _normalTransform = normal_matrix(_invTransform);
     }
-    constexpr const Material& surface() const noexcept{
-        return _surface;
-    }
-    constexpr const Color& color() const noexcept{
-        return surface().color;
-    }
-    constexpr Material& surface() noexcept{
-        return _surface;
-    }
-    constexpr Color& color() noexcept{
-        return surface().color;
+    constexpr MaterialId material_id() const noexcept{
+        return _material;
     }
-    constexpr void set_parent(Group* g) noexcept{
-        _parent = g;
-    }
-    constexpr Group* get_parent() const noexcept{
-        return _parent;
+    constexpr void set_material(MaterialId m) noexcept{
+        _material = m;
     }
 private:
-    Material _surface{material()};
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
-    Group* _parent = nullptr;
+    MaterialId _material = DEFAULT_MATERIAL_ID;
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
+    Matrix3 _normalTransform{Matrix3Identity};
 };
 
 constexpr Cube cube() noexcept{
     return {};
 }
-constexpr Cube cube(Color col) noexcept{
-    return Cube(material(col));
-}
-constexpr Cube cube(Material m) noexcept{
-    return Cube(std::move(m));
+constexpr Cube cube(MaterialId m) noexcept{
+    return Cube(m);
 }
 constexpr Cube cube(Matrix4 transform) noexcept{
     return Cube(std::move(transform));
 }
-constexpr Cube cube(Material m, Matrix4 transform) noexcept{
-    return Cube(std::move(m), std::move(transform));
+constexpr Cube cube(MaterialId m, Matrix4 transform) noexcept{
+    return Cube(m, std::move(transform));
 }
 
 constexpr Vector local_normal_at([[maybe_unused]] const Cube& c, const Point& p) noexcept{
@@ -95,12 +86,17 @@ constexpr std::pair<Real, Real> check_axis(Real origin, Real direction, Real min
     return (tmin > tmax) ? std::pair{tmax, tmin} : std::pair{tmin, tmax};
 }
 
-constexpr auto local_intersect([[maybe_unused]] const Cube& cube, const Ray& local_ray) noexcept{
+//object space bounds: the cube itself
+constexpr AABB local_bounds([[maybe_unused]] const Cube& c) noexcept{
+    return aabb(point(-1, -1, -1), point(1, 1, 1));
+}
+
+constexpr LocalHits local_intersect([[maybe_unused]] const Cube& cube, const Ray& local_ray) noexcept{
     const auto [xtmin, xtmax] = check_axis(local_ray.x(), local_ray.dx());
     const auto [ytmin, ytmax] = check_axis(local_ray.y(), local_ray.dy());
     const auto [ztmin, ztmax] = check_axis(local_ray.z(), local_ray.dz());
     const auto tmin = math::max(xtmin, ytmin, ztmin);
     const auto tmax = math::min(xtmax, ytmax, ztmax);
     if(tmin > tmax) return MISS;
-    return  std::vector{tmin, tmax};
+    return LocalHits{tmin, tmax};
 };
@@ -3,9 +3,11 @@
 #include "Tuple.h"
 #include "Color.h"
 #include "Matrix.h"
+#include "Affine.h"
 #include "Material.h"
 #include "Ray.h"
-struct Group;
+#include "AABB.h"
+#include "InlineVector.h"
 /* unit cylinder, always radius 1, positioned at 0, 0, 0 and extending to infinity on the y axis*/
 struct Cylinder final{
     Real minimum = math::MIN; //cylinder extents on the Y-axis. Up-to but not including this value.
@@ -13,55 +15,47 @@ struct Cylinder final{
     bool closed = false;
     constexpr Cylinder() noexcept = default;
     constexpr Cylinder(Real min, Real max, bool closed_ = false) noexcept : minimum(min), maximum(max), closed(closed_){}
-    explicit constexpr Cylinder(Material m) noexcept : _surface(std::move(m)){}
+    explicit constexpr Cylinder(MaterialId m) noexcept : _material(m){}
     explicit constexpr Cylinder(Matrix4 transf) noexcept{
         set_transform(std::move(transf));
     }
-    constexpr Cylinder(Material m, Matrix4 transf) noexcept : _surface(std::move(m)){
+    constexpr Cylinder(MaterialId m, Matrix4 transf) noexcept : _material(m){
         set_transform(std::move(transf));
     }
-    constexpr Cylinder(Real min, Real max, Material m, Matrix4 transform) noexcept : minimum(min), maximum(max), _surface(std::move(m)){
+    constexpr Cylinder(Real min, Real max, MaterialId m, Matrix4 transform) noexcept : minimum(min), maximum(max), _material(m){
         set_transform(std::move(transform));
     }
-    constexpr Cylinder(Real min, Real max, bool closed_, Material m, Matrix4 transform) noexcept : minimum(min), maximum(max), closed(closed_), _surface(std::move(m)){
+    constexpr Cylinder(Real min, Real max, bool closed_, MaterialId m, Matrix4 transform) noexcept : minimum(min), maximum(max), closed(closed_), _material(m){
         set_transform(std::move(transform));
     }
     constexpr auto operator==(const Cylinder& that) const noexcept{
-        return _surface == that._surface && _transform == that._transform;
+        return _material == that._material && _transform == that._transform;
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
+    constexpr const Matrix3& normal_transform() const noexcept{
+        return _normalTransform;
+    }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
+        _normalTransform = normal_matrix(_invTransform);
     }
-    constexpr const Material& surface() const noexcept{
-        return _surface;
-    }
-    constexpr const Color& color() const noexcept{
-        return surface().color;
-    }
-    constexpr Material& surface() noexcept{
-        return _surface;
+    constexpr MaterialId material_id() const noexcept{
+        return _material;
     }
-    constexpr Color& color() noexcept{
-        return surface().color;
-    }
-    constexpr void set_parent(Group* g) noexcept{
-        _parent = g;
-    }
-    constexpr Group* get_parent() const noexcept{
-        return _parent;
+    constexpr void set_material(MaterialId m) noexcept{
+        _material = m;
     }
 private:
-    Material _surface{material()};
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
-    Group* _parent = nullptr;
+    MaterialId _material = DEFAULT_MATERIAL_ID;
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
+    Matrix3 _normalTransform{Matrix3Identity};
 };
 
 constexpr Cylinder cylinder() noexcept{
@@ -70,26 +64,23 @@ constexpr Cylinder cylinder() noexcept{
 constexpr Cylinder cylinder(Real min, Real max) noexcept{
     return {min, max};
 }
-constexpr Cylinder cylinder(Color col) noexcept{
-    return Cylinder(material(col));
-}
-constexpr Cylinder cylinder(Material m) noexcept{
-    return Cylinder(std::move(m));
+constexpr Cylinder cylinder(MaterialId m) noexcept{
+    return Cylinder(m);
 }
 constexpr Cylinder sphcylinderere(Matrix4 transform) noexcept{
     return Cylinder(std::move(transform));
 }
-constexpr Cylinder cylinder(Material m, Matrix4 transform) noexcept{
-    return Cylinder(std::move(m), std::move(transform));
+constexpr Cylinder cylinder(MaterialId m, Matrix4 transform) noexcept{
+    return Cylinder(m, std::move(transform));
 }
-constexpr Cylinder cylinder(Real min, Real max, Material m, Matrix4 transform) noexcept{
-    return Cylinder(min, max, std::move(m), std::move(transform));
+constexpr Cylinder cylinder(Real min, Real max, MaterialId m, Matrix4 transform) noexcept{
+    return Cylinder(min, max, m, std::move(transform));
 }
 constexpr Cylinder closed_cylinder(Real min, Real max) noexcept{
     return Cylinder(min, max, true);
 }
-constexpr Cylinder closed_cylinder(Real min, Real max, Material m, Matrix4 transform) noexcept{
-    return Cylinder(min, max, true, std::move(m), std::move(transform));
+constexpr Cylinder closed_cylinder(Real min, Real max, MaterialId m, Matrix4 transform) noexcept{
+    return Cylinder(min, max, true, m, std::move(transform));
 }
 
 //helper to build Icosahedrons
@@ -115,13 +106,30 @@ constexpr Vector local_normal_at([[maybe_unused]] const Cylinder& c, const Point
     return normal_vector(p.x, 0, p.z);
 }
 
-constexpr bool is_bounded(const Cylinder& c) noexcept{
+//all local_intersect needs to know about a cylinder. Compact enough to store one per shape in flat arrays.
+struct CylinderExtents final{
+    Real minimum = math::MIN;
+    Real maximum = math::MAX;
+    bool closed = false;
+};
+
+constexpr CylinderExtents extents(const Cylinder& c) noexcept{
+    return CylinderExtents{c.minimum, c.maximum, c.closed};
+}
+
+constexpr bool is_bounded(const CylinderExtents& c) noexcept{
     return !(c.maximum == math::MAX && c.minimum == math::MIN);
 }
+constexpr bool is_bounded(const Cylinder& c) noexcept{
+    return is_bounded(extents(c));
+}
 
 constexpr bool is_closed(const Cylinder& c) noexcept{
     return c.closed;
 }
+constexpr bool is_open(const CylinderExtents& c) noexcept{
+    return !c.closed;
+}
 constexpr bool is_open(const Cylinder& c) noexcept{
     return !is_closed(c);
 }
@@ -133,7 +141,7 @@ constexpr bool check_cap(const Ray& ray, Real t) noexcept{
     return (square(x) + square(z)) <= 1.0f;
 }
 
-constexpr void intersect_caps(const Cylinder& cylinder, const Ray& ray, std::vector<Real>& xs) noexcept{
+constexpr void intersect_caps(const CylinderExtents& cylinder, const Ray& ray, LocalHits& xs) noexcept{
     if(is_open(cylinder) || math::is_zero(ray.dy())){
         return; //caps only matter if the cylinder is closed and might possibly be intersected by the ray
     }
@@ -147,10 +155,19 @@ constexpr void intersect_caps(const Cylinder& cylinder, const Ray& ray, std::vec
     }
 }
 
+//object space bounds: unit radius around the y-axis, between minimum and maximum.
+//a cylinder missing either end cap extent runs forever and gets an infinite box.
+constexpr AABB local_bounds(const Cylinder& c) noexcept{
+    if (c.minimum == math::MIN || c.maximum == math::MAX) {
+        return infinite_aabb(point(-1, c.minimum, -1), point(1, c.maximum, 1));
+    }
+    return aabb(point(-1, c.minimum, -1), point(1, c.maximum, 1));
+}
+
 //TODO: refactor this overly long function.
-constexpr auto local_intersect([[maybe_unused]] const Cylinder& cylinder, const Ray& local_ray) noexcept{
+constexpr LocalHits local_intersect(const CylinderExtents& cylinder, const Ray& local_ray) noexcept{
     using math::square, math::sqrt, math::is_between;
-    std::vector<Real> result;
+    LocalHits result;
     const auto a = 2 * (square(local_ray.dx()) + square(local_ray.dz()));
     if(!math::is_zero(a, math::BOOK_EPSILON * 2)){  //ray is not ~parallel to the Y axis so we can collide.    
         const auto b = 2.0f * (local_ray.x() * local_ray.dx() + local_ray.z() * local_ray.dz());
@@ -179,4 +196,8 @@ constexpr auto local_intersect([[maybe_unused]] const Cylinder& cylinder, const
     }
     intersect_caps(cylinder, local_ray, result);
     return result;
-};
\ No newline at end of file
+};
+
+constexpr LocalHits local_intersect(const Cylinder& cylinder, const Ray& local_ray) noexcept{
+    return local_intersect(extents(cylinder), local_ray);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "pch.h"
+#include <span>
 #include "Tuple.h"
 #include "Ray.h"
 #include "Material.h"
@@ -7,6 +8,7 @@
 #include "Intersection.h"
 struct HitState final {
     const Shapes* objectPtr = nullptr; //the object variant we hit    
+    const Instance* instancePtr = nullptr; //and the instance it belongs to, if any
     Point point{}; //the point in world-space where the intersection occurs
     Point over_point{}; //slightly nudged point to avoid intersection precision errors causing "acne"
     Point under_point{}; //sligthly nudged, for refraction and transparencies
@@ -16,11 +18,12 @@ struct HitState final {
     Real t{ 0 }; //distance to hit
     Real n1{ 1.0f }; //refractive index of the material we exited
     Real n2{ 1.0f }; //refractive index of the material we entered
+    MaterialId material = DEFAULT_MATERIAL_ID; //the hit surface's, in the World's material table
     bool inside = false;
 
     constexpr HitState(const Intersection& i, const Ray& r) noexcept
-        : objectPtr{ i.objPtr }, point{ position(r, i.t) }, eye_v{ -r.direction }, t{ i.t } {
-        normal = normal_at(object(), point);
+        : objectPtr{ i.objPtr }, instancePtr{ i.instance }, point{ position(r, i.t) }, eye_v{ -r.direction }, t{ i.t }, material{ i.material_id() } {
+        normal = normal_at(i, point);
         if (dot(normal, eye_v) < 0.0f) {
             inside = true;
             normal = -normal;
@@ -32,42 +35,36 @@ struct HitState final {
         reflectv = reflect(r.direction, normal);
     }
 
-    constexpr HitState(const Intersection& closest, const Ray& r, const Intersections& xs) : HitState(closest, r) {
-        std::vector<const Shapes*> containers;
+    //n1 and n2 come from the refractive indices of the objects along the ray, looked up in materials.
+    constexpr HitState(const Intersection& closest, const Ray& r, const Intersections& xs, std::span<const Material> materials) : HitState(closest, r) {
+        std::vector<Intersection> containers; //only the object and instance of each matter
         containers.reserve(2);
+        const auto same_object = [](const Intersection& a, const Intersection& b) noexcept {
+            return a.objPtr == b.objPtr && a.instance == b.instance;
+        };
         for (const auto& i : xs) {
             const auto is_the_hit = i == closest;
             if (is_the_hit) {
-                n1 = containers.empty() ? 1.0f : ::surface(*containers.back()).refractive_index;
+                n1 = containers.empty() ? 1.0f : materials[containers.back().material_id()].refractive_index;
             }
 
-            if (const auto iter = std::ranges::find(containers, i.objPtr); iter != containers.end()) {
+            if (const auto iter = std::ranges::find_if(containers, [&](const Intersection& c) noexcept { return same_object(c, i); }); iter != containers.end()) {
                 containers.erase(iter); //this intersection must be exiting the object, remove it from the lists
             }
             else {
-                containers.push_back(i.objPtr); //the intersection is entering the object, add it to the list
+                containers.push_back(i); //the intersection is entering the object, add it to the list
             }
 
             if (is_the_hit) {
-                n2 = containers.empty() ? 1.0f : ::surface(*containers.back()).refractive_index;
+                n2 = containers.empty() ? 1.0f : materials[containers.back().material_id()].refractive_index;
                 break; //terminate the loop
             }
         }        
     }
 
-    constexpr Real reflective() const noexcept {
-        return surface().reflective; //TODO: consider caching material properties in the hitstate object.
-    }
-    constexpr Real transparency() const noexcept {
-        return surface().transparency;
-    }
-
     explicit constexpr operator bool() const noexcept {
         return t != 0;
     }
-    constexpr const Material& surface() const noexcept {
-        return ::surface(object());
-    }
     constexpr const Shapes& object() const noexcept {
         assert(objectPtr && "HitState::object() called on empty HitState.");
         return *objectPtr;
@@ -78,6 +75,6 @@ constexpr HitState prepare_computations(const Intersection& i, const Ray& r) noe
     return HitState(i, r);
 };
 
-constexpr HitState prepare_computations(const Intersection& i, const Ray& r, const Intersections& xs)  noexcept {
-    return HitState(i, r, xs);
+constexpr HitState prepare_computations(const Intersection& i, const Ray& r, const Intersections& xs, std::span<const Material> materials)  noexcept {
+    return HitState(i, r, xs, materials);
 };
\ No newline at end of file
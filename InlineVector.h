@@ -0,0 +1,84 @@
+#pragma once
+#include "pch.h"
+#include <array>
+#include <initializer_list>
+
+/*A vector with a fixed capacity, stored inline. Never allocates.
+Used for the handful of t-values a primitive can produce per ray, where a std::vector
+meant one heap allocation (and free) per ray per object.*/
+template<class T, size_t CAPACITY>
+struct InlineVector final {
+    using size_type = uint8_t;
+    using value_type = T;
+    using container = std::array<T, CAPACITY>;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    static_assert(CAPACITY <= std::numeric_limits<size_type>::max(), "InlineVector capacity must fit in size_type");
+
+    constexpr InlineVector() noexcept = default;
+    constexpr InlineVector(std::initializer_list<value_type> values) noexcept {
+        assert(values.size() <= CAPACITY && "InlineVector: too many values for the capacity");
+        for (const auto& v : values) {
+            push_back(v);
+        }
+    }
+
+    constexpr const_reference operator[](size_type i) const noexcept {
+        assert(i < size() && "InlineVector::operator[i] index is out of bounds");
+        return _items[i];
+    }
+    constexpr reference operator[](size_type i) noexcept {
+        assert(i < size() && "InlineVector::operator[i] index is out of bounds");
+        return _items[i];
+    }
+    constexpr void push_back(value_type val) noexcept {
+        assert(_count < CAPACITY && "InlineVector::push_back on a full vector");
+        _items[_count++] = std::move(val);
+    }
+    constexpr void pop_back() noexcept {
+        assert(_count > 0 && "InlineVector::pop_back on an empty vector");
+        --_count;
+    }
+    constexpr void erase(const_iterator pos) noexcept {
+        assert(pos >= begin() && pos < end() && "InlineVector::erase iterator is out of bounds");
+        std::move(begin() + (pos - begin()) + 1, end(), begin() + (pos - begin()));
+        --_count;
+    }
+    constexpr void clear() noexcept { _count = 0; }
+    constexpr reference back() noexcept { assert(!empty()); return _items[_count - 1]; }
+    constexpr const_reference back() const noexcept { assert(!empty()); return _items[_count - 1]; }
+    constexpr pointer data() noexcept { return _items.data(); }
+    constexpr const_pointer data() const noexcept { return _items.data(); }
+    constexpr size_type size() const noexcept { return _count; }
+    static constexpr size_type capacity() noexcept { return CAPACITY; }
+    constexpr bool empty() const noexcept { return _count == 0; }
+    constexpr bool full() const noexcept { return _count == CAPACITY; }
+    constexpr iterator begin() noexcept { return _items.data(); }
+    constexpr iterator end() noexcept { return _items.data() + _count; }
+    constexpr const_iterator begin() const noexcept { return _items.data(); }
+    constexpr const_iterator end() const noexcept { return _items.data() + _count; }
+
+    constexpr bool operator==(const InlineVector& that) const noexcept {
+        return std::ranges::equal(*this, that);
+    }
+private:
+    container _items{};
+    size_type _count = 0;
+};
+
+using LocalHits = InlineVector<Real, 4>; //t-values from local_intersect. 4 is enough for a closed cone: two walls + two caps.
+static constexpr LocalHits MISS{};
+
+template<class T, size_t CAPACITY>
+std::ostream& operator<<(std::ostream& os, const InlineVector<T, CAPACITY>& v) {
+    os << "{"sv;
+    for (const auto& item : v) {
+        os << ' ' << item;
+    }
+    os << " }"sv;
+    return os;
+}
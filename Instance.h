@@ -0,0 +1,71 @@
+#pragma once
+#include "pch.h"
+#include <span>
+#include <vector>
+#include "Affine.h"
+#include "AABB.h"
+#include "BVH.h"
+#include "Material.h"
+#include "Shapes.h"
+
+/*
+ * Instancing, for scenes that repeat the same geometry many times.
+ *
+ * An Asset is the shared, bottom level structure: shapes in a space of their own, and a BVH over them.
+ * An Instance places an asset in the world. It's a small record: a transform and its inverse,
+ * the index of the asset, and optionally a material that replaces the materials of the asset's shapes.
+ * A World keeps a top level BVH over the world bounds of its instances, so a sphere placed 10,000
+ * times is one Sphere and 10,000 instances, not 10,000 entries in World::objects.
+ *
+ * A hit on an instance carries the shape inside the asset and the instance it was reached through;
+ * normals, materials and patterns go through both (see Intersection and HitState).
+ */
+using AssetId = uint32_t;
+
+struct Asset final {
+    std::vector<Shapes> shapes;
+    BVH bvh;
+    AABB bounds; //of all the shapes, in the asset's space
+};
+
+inline Asset asset(std::vector<Shapes> shapes) {
+    Asset a;
+    a.shapes = std::move(shapes);
+    a.bvh = build_bvh(a.shapes);
+    for (const auto& s : a.shapes) {
+        grow(a.bounds, bounds_of(s));
+    }
+    return a;
+}
+
+struct Instance final {
+    Affine transform{ AffineIdentity };
+    Affine inv_transform{ AffineIdentity };
+    AssetId asset = 0;
+    MaterialId material = DEFAULT_MATERIAL_ID; //the default: keep the materials of the asset's shapes
+};
+
+constexpr Instance instance(AssetId id, const Matrix4& transform, MaterialId material = DEFAULT_MATERIAL_ID) noexcept {
+    const auto a = affine(transform);
+    return Instance{ a, inverse(a), id, material };
+}
+
+//world space bounds of an instance of the asset a.
+constexpr AABB bounds_of(const Instance& inst, const Asset& a) noexcept {
+    return transform(a.bounds, inst.transform);
+}
+
+//the normal at a world space point on obj, a shape of the asset that inst places.
+template<has_point_normal T>
+constexpr Vector normal_at(const Instance& inst, const T& obj, const Point& world_point) noexcept {
+    const auto n = normal_at(obj, inst.inv_transform * world_point);
+    return normalize(normal_matrix(inst.inv_transform) * n);
+}
+
+//the material of obj, a shape of the asset that inst places (or of no instance at all, for nullptr).
+constexpr MaterialId material_id(const Instance* inst, const Shapes& obj) noexcept {
+    if (inst != nullptr && inst->material != DEFAULT_MATERIAL_ID) {
+        return inst->material;
+    }
+    return ::material_id(obj);
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "pch.h"
+#include <array>
+#include <span>
 #include "Ray.h"
 #include "Shapes.h"
 #include "World.h"
@@ -7,6 +9,10 @@
 struct Intersection final {
     const Shapes* objPtr = nullptr;
     Real t{ 0.0f };
+    Real u{ 0.0f }; //where on the face of a mesh the hit is. see TriangleHit
+    Real v{ 0.0f };
+    uint32_t face = 0; //which face of a mesh was hit
+    const Instance* instance = nullptr; //the instance the shape was reached through, if it belongs to an Asset
 
     explicit constexpr operator bool() const {
         return objPtr != nullptr;
@@ -15,77 +21,118 @@ struct Intersection final {
         assert(objPtr != nullptr);
         return *objPtr;
     }
-    constexpr const Material& surface() const noexcept {
-        return ::surface(object());
-        /*return std::visit([](const auto& obj) -> const Material& { 
-            return obj.surface();  
-        }, object());*/
+    //the hit surface's index into the World's material table.
+    constexpr MaterialId material_id() const noexcept {
+        return ::material_id(instance, object());
     }
     constexpr bool operator<(const Intersection& that) const noexcept {
         return t < that.t;
     }
     constexpr bool operator==(const Intersection& that) const noexcept {
-        return object() == that.object() && math::float_cmp(t, that.t);
+        return object() == that.object() && instance == that.instance && face == that.face && math::float_cmp(t, that.t);
     }
     constexpr auto operator<(Real time) const noexcept {
         return t < time;
     }
 };
 
+/*The intersections along a ray. The first INLINE_CAPACITY are stored inline, which covers
+nearly every ray through a BVH, so intersect -> Intersections -> closest never touches the heap.
+Larger sets spill over to a std::vector.*/
 struct Intersections final {
-    using size_type = uint8_t;
+    using size_type = uint32_t;
     using value_type = Intersection;
     using container = std::vector<value_type>;
-    using reference = container::reference;
-    using const_reference = container::const_reference;
-    using pointer = container::pointer;
-    using const_pointer = container::const_pointer;
-    using iterator = container::iterator;
-    using const_iterator = container::const_iterator;
-    container xs;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    static constexpr size_t INLINE_CAPACITY = 16;
 
+    constexpr Intersections() noexcept = default;
     explicit constexpr Intersections(size_t capacity) {
-        xs.reserve(capacity);
+        if (capacity > INLINE_CAPACITY) {
+            _overflow.reserve(capacity);
+        }
+    };
+    explicit constexpr Intersections(std::initializer_list<value_type> intersections) {
+        for (const auto& i : intersections) {
+            push_back(i);
+        }
     };
-    explicit constexpr Intersections(std::initializer_list<value_type> intersections) : xs(intersections) {};
 
     constexpr const_reference operator[](size_type i) const noexcept {
         assert(i < size() && "Intersection::operator[i] index is out of bounds");
-        return xs[i];
+        return data()[i];
     }
     constexpr reference operator[](size_type i) noexcept {
         assert(i < size() && "Intersection::operator[i] index is out of bounds");
-        return xs[i];
+        return data()[i];
     }
     explicit constexpr operator bool() const noexcept {
         return !empty();
     }
     constexpr void push_back(value_type val) {
-        xs.push_back(val);
+        if (_count < INLINE_CAPACITY) {
+            _inline_xs[_count++] = val;
+            return;
+        }
+        if (_count == INLINE_CAPACITY) { //spill: from here on the vector holds every intersection
+            _overflow.reserve(INLINE_CAPACITY * 2);
+            _overflow.assign(_inline_xs.begin(), _inline_xs.end());
+        }
+        _overflow.push_back(val);
+        ++_count;
     }
-    constexpr void push_back(Intersections val) {
-        xs.append_range(val);
+    constexpr void push_back(const Intersections& val) {
+        for (const auto& i : val) {
+            push_back(i);
+        }
     }
     constexpr const Shapes& object_at(size_type i) const {
         assert(i < size() && "Intersection::operator[i] index is out of bounds");
-        return xs[i].object();        
+        return data()[i].object();
     }
-    constexpr void sort() noexcept { std::ranges::sort(xs, std::less<value_type>{}); }
-    constexpr pointer data() noexcept { return xs.data(); }
-    constexpr const_pointer data() const noexcept { return xs.data(); }
-    constexpr size_type size() const noexcept { return narrow_cast<size_type>(xs.size()); }
+    constexpr void sort() noexcept { std::ranges::sort(*this, std::less<value_type>{}); }
+    constexpr pointer data() noexcept { return is_inline() ? _inline_xs.data() : _overflow.data(); }
+    constexpr const_pointer data() const noexcept { return is_inline() ? _inline_xs.data() : _overflow.data(); }
+    constexpr size_type size() const noexcept { return narrow_cast<size_type>(_count); }
     constexpr size_type count() const noexcept { return size(); }
-    constexpr bool empty() const noexcept { return xs.empty(); }
-    constexpr iterator begin() noexcept { return xs.begin(); }
-    constexpr iterator end() noexcept { return xs.end(); }
-    constexpr const_iterator begin() const noexcept { return xs.begin(); }
-    constexpr const_iterator end() const noexcept { return xs.end(); }
-    constexpr auto operator<=>(const Intersections& that) const noexcept = default;
+    constexpr bool empty() const noexcept { return _count == 0; }
+    constexpr bool is_inline() const noexcept { return _count <= INLINE_CAPACITY; }
+    constexpr iterator begin() noexcept { return data(); }
+    constexpr iterator end() noexcept { return data() + _count; }
+    constexpr const_iterator begin() const noexcept { return data(); }
+    constexpr const_iterator end() const noexcept { return data() + _count; }
+    constexpr bool operator==(const Intersections& that) const noexcept {
+        return std::ranges::equal(*this, that);
+    }
+private:
+    std::array<value_type, INLINE_CAPACITY> _inline_xs{};
+    container _overflow;
+    size_t _count = 0;
 };
 
 constexpr auto intersection(Real t, const Shapes& obj) noexcept {
     return Intersection{ &obj, t };
 };
+constexpr auto intersection_with_uv(Real t, const Shapes& obj, Real u, Real v, uint32_t face = 0) noexcept {
+    return Intersection{ &obj, t, u, v, face };
+};
+//the world space normal at the point of a hit: from the face that was hit for a mesh, and through the instance for a shape in an asset.
+constexpr Vector normal_at(const Intersection& hit, const Point& world_point) {
+    return std::visit([&hit, &world_point](const auto& obj) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(obj)>, Mesh>) {
+            const auto n = normal_at(obj, hit.face, hit.u, hit.v);
+            return hit.instance ? normalize(normal_matrix(hit.instance->inv_transform) * n) : n;
+        }
+        else {
+            return hit.instance ? normal_at(*hit.instance, obj, world_point) : normal_at(obj, world_point);
+        }
+    }, hit.object());
+}
 constexpr auto intersections() noexcept {
     return Intersections{};
 };
@@ -98,44 +145,314 @@ constexpr auto intersections(Intersection i1, Intersection i2) noexcept {
 constexpr auto intersections(std::initializer_list<Intersection> is) noexcept {
     return Intersections(is);
 };
-constexpr auto intersections(std::span<Real> ts, const Shapes& variant) noexcept {
-    auto xs = intersections(ts.size());
+constexpr auto intersections(const LocalHits& ts, const Shapes& variant) noexcept {
+    Intersections xs;
     for (auto t : ts) {
         xs.push_back(intersection(t, variant));
     }
     return xs;
 };
 
-constexpr auto intersect(const Shapes& variant, const Ray& r) {
-    std::vector<Real> ts = std::visit([&r](const auto& obj) {
-        if constexpr (std::is_same_v<std::decay_t<decltype(obj)>, Group*>) {
-            assert(obj != nullptr && "Null Group pointer encountered");
-            const auto local_ray = transform(r, obj->inv_transform());
-            return local_intersect(*obj, local_ray);
-        } else {
-            const auto local_ray = transform(r, obj.inv_transform());
-            return local_intersect(obj, local_ray);
-        }}, variant
+//the t-values at which a world space ray hits the shape, without building an Intersections.
+constexpr LocalHits hit_distances(const Shapes& variant, const Ray& r) noexcept {
+    return std::visit([&r](const auto& obj) noexcept {
+        const auto local_ray = transform(r, obj.inv_transform());
+        return local_intersect(obj, local_ray);
+        }, variant
     );
-    return intersections(ts, variant);
-    /*if (t1 != T_MISS) {
-        xs.push_back(intersection(t1, variant));
-    }
-    if (t2 != T_MISS) {
-        xs.push_back(intersection(t2, variant));
+};
+
+//a mesh reports a hit for every face the ray crosses, with the face and where on it.
+constexpr Intersections intersect(const Shapes& variant, const Ray& r) {
+    if (const auto m = std::get_if<Mesh>(&variant)) {
+        Intersections xs;
+        traverse_faces(m->data(), transform(r, m->inv_transform()), math::MIN, math::MAX, [&xs, &variant](size_t face, const TriangleHit& hit) {
+            xs.push_back(intersection_with_uv(hit.t, variant, hit.u, hit.v, narrow_cast<uint32_t>(face)));
+            return math::MAX;
+        });
+        xs.sort();
+        return xs;
     }
-    return xs;*/
+    return intersections(hit_distances(variant, r), variant);
 };
 
-constexpr auto intersect(const World& world, const Ray& r) {
-    Intersections result = intersections(world.size() * 2);//reserve space to store 2 intersections per object in the world
-    for (const auto& variant : world) {
-        result.push_back(intersect(variant, r));
+//is there any hit with 0 < t < max_t?
+constexpr bool occluded(const Shapes& variant, const Ray& r, Real max_t) noexcept {
+    if (const auto m = std::get_if<Mesh>(&variant)) { //not local_intersect: its one hit may be a face at t == 0, hiding the rest
+        constexpr auto JUST_ABOVE_ZERO = std::numeric_limits<Real>::denorm_min();
+        return any_face(m->data(), transform(r, m->inv_transform()), JUST_ABOVE_ZERO, max_t);
+    }
+    return std::ranges::any_of(hit_distances(variant, r), [max_t](Real t) noexcept { return t > 0.0f && t < max_t; });
+}
+
+//the nearest hit with t_min <= t <= t_max, or no hit.
+constexpr Intersection nearest_hit(const Shapes& variant, const Ray& r, Real t_min, Real t_max) noexcept {
+    if (const auto m = std::get_if<Mesh>(&variant)) {
+        const auto [face, hit] = nearest_face(m->data(), transform(r, m->inv_transform()), t_min, t_max);
+        return hit ? intersection_with_uv(hit.t, variant, hit.u, hit.v, face) : Intersection{};
+    }
+    Intersection best{};
+    for (const auto t : hit_distances(variant, r)) {
+        if (t >= t_min && t <= t_max && (!best || t < best.t)) {
+            best = intersection(t, variant);
+        }
+    }
+    return best;
+}
+
+/*The queries below work on a list of shapes and the BVH built over them: the objects of a World, or the
+ shapes of an Asset, with the ray in the asset's space. A BVH built for a different number of shapes is
+ out of date; it's ignored and every shape is tested.*/
+
+//collects the intersections of every shape whose bounds the ray enters within [t_min, t_max].
+//shapes straddling the range report all of their intersections, so callers must still filter on t.
+constexpr void intersect(std::span<const Shapes> shapes, const BVH& bvh, const Ray& r, Real t_min, Real t_max, Intersections& result) {
+    if (bvh.size() != shapes.size()) {
+        for (const auto& variant : shapes) {
+            result.push_back(intersect(variant, r));
+        }
+        return;
+    }
+    traverse(bvh, r, t_min, t_max, [&shapes, &r, &result, t_max](size_t i) {
+        result.push_back(intersect(shapes[i], r));
+        return t_max;
+    });
+}
+
+//the nearest hit among the shapes with t_min <= t <= t_max. keeps a running t_max, so every box behind
+//the nearest hit found so far is pruned. On a tie the shape that comes first wins, whatever order the BVH visits them in.
+constexpr Intersection nearest_hit(std::span<const Shapes> shapes, const BVH& bvh, const Ray& r, Real t_min, Real t_max) noexcept {
+    Intersection best{ nullptr, t_max };
+    const auto consider = [&r, &best, t_min](const Shapes& variant) noexcept {
+        const auto hit = nearest_hit(variant, r, t_min, best.t);
+        if (hit && (!best || hit.t < best.t || hit.objPtr < best.objPtr)) {
+            best = hit;
+        }
+    };
+    if (bvh.size() != shapes.size()) {
+        for (const auto& variant : shapes) {
+            consider(variant);
+        }
+    } else {
+        traverse(bvh, r, t_min, t_max, [&shapes, &best, &consider](size_t i) noexcept {
+            consider(shapes[i]);
+            return best.t;
+        });
+    }
+    return best ? best : Intersection{};
+}
+
+//is there anything among the shapes with 0 < t < max_t? stops at the first hit found, in no particular order.
+constexpr bool occluded(std::span<const Shapes> shapes, const BVH& bvh, const Ray& r, Real max_t) noexcept {
+    const auto blocks = [&r, max_t](const Shapes& variant) noexcept {
+        return occluded(variant, r, max_t);
+    };
+    if (bvh.size() != shapes.size()) {
+        return std::ranges::any_of(shapes, blocks);
+    }
+    bool hit = false;
+    traverse(bvh, r, 0.0f, max_t, [&shapes, &blocks, &hit, max_t](size_t i) noexcept {
+        hit = blocks(shapes[i]);
+        return hit ? TRAVERSAL_DONE : max_t;
+    });
+    return hit;
+}
+
+/*Queries on a scene graph, walking it from the root. A group whose world bounds the ray doesn't enter
+ within [t_min, t_max] is skipped with everything below it, for one box test. The hits are on the graph's
+ shapes, which carry the world transforms and materials of the groups above them.*/
+namespace Detail {
+    template<class Visitor>
+    constexpr Real traverse_group(const SceneGraph& graph, NodeId group, const SlabRay& sr, Real t_min, Real t_max, Visitor& visit) {
+        for (auto i = graph[group].first_child; i != NO_NODE && t_max >= t_min; i = graph[i].next_sibling) {
+            const auto& node = graph[i];
+            if (is_empty(node.world_bounds) || (!is_infinite(node.world_bounds) && entry_distance(node.world_bounds, sr, t_min, t_max) == BOX_MISS)) {
+                continue;
+            }
+            t_max = node.is_group() ? traverse_group(graph, i, sr, t_min, t_max, visit) : std::invoke(visit, size_t{ node.shape });
+        }
+        return t_max;
+    }
+}
+
+//visits the shapes whose bounds the ray enters within [t_min, t_max], and those of no group it misses. visit(shape index) works like a traverse visitor.
+template<class Visitor>
+constexpr void traverse_nodes(const SceneGraph& graph, const Ray& r, Real t_min, Real t_max, Visitor&& visit) {
+    assert(graph.is_current() && "traverse_nodes: call update() after changing the graph");
+    Detail::traverse_group(graph, ROOT_NODE, slab_ray(r), t_min, t_max, visit);
+}
+
+//every intersection with the graph's shapes, sorted. negative t's are kept, as for a World.
+constexpr Intersections intersect(const SceneGraph& graph, const Ray& r) {
+    Intersections xs;
+    traverse_nodes(graph, r, math::MIN, math::MAX, [&graph, &r, &xs](size_t i) {
+        xs.push_back(intersect(graph.shapes()[i], r));
+        return math::MAX;
+    });
+    xs.sort();
+    return xs;
+}
+
+//the nearest hit with t_min <= t <= t_max. On a tie the shape added first wins.
+constexpr Intersection nearest_hit(const SceneGraph& graph, const Ray& r, Real t_min, Real t_max) noexcept {
+    Intersection best{ nullptr, t_max };
+    traverse_nodes(graph, r, t_min, t_max, [&graph, &r, &best, t_min](size_t i) noexcept {
+        const auto hit = nearest_hit(graph.shapes()[i], r, t_min, best.t);
+        if (hit && (!best || hit.t < best.t || hit.objPtr < best.objPtr)) {
+            best = hit;
+        }
+        return best.t;
+    });
+    return best ? best : Intersection{};
+}
+
+constexpr Intersection closest_hit(const SceneGraph& graph, const Ray& r) noexcept {
+    return nearest_hit(graph, r, 0.0f, math::MAX);
+}
+
+//is there anything in the graph with 0 < t < max_t? stops at the first hit found.
+constexpr bool occluded(const SceneGraph& graph, const Ray& r, Real max_t) noexcept {
+    bool hit = false;
+    traverse_nodes(graph, r, 0.0f, max_t, [&graph, &r, &hit, max_t](size_t i) noexcept {
+        hit = occluded(graph.shapes()[i], r, max_t);
+        return hit ? TRAVERSAL_DONE : max_t;
+    });
+    return hit;
+}
+
+namespace Detail {
+    static inline const BVH OUT_OF_DATE_BVH{}; //built over nothing, so it matches no World with objects
+
+    //the World's BVH, or one the queries above will ignore if the World changed since its last build().
+    constexpr const BVH& objects_bvh(const World& world) noexcept {
+        return world.is_built() ? world.bvh() : OUT_OF_DATE_BVH;
+    }
+
+    /*nearest_hit over the World's objects. With AVX2 the spheres of each batched node of the BVH (see
+     SphereBatch) are tested 8 at a time, and the rest of the node's objects one by one. Same answer either way.*/
+    constexpr Intersection nearest_object_hit(const World& world, const Ray& r, Real t_min, Real t_max) noexcept {
+#if RTC_AVX2
+        if (!std::is_constant_evaluated() && world.is_built() && !world.sphere_batches().empty()) {
+            const auto shapes = world.objects();
+            const auto& bvh = world.bvh();
+            Intersection best{ nullptr, t_max };
+            const auto consider = [&best](const Intersection& hit) noexcept {
+                if (hit && (!best || hit.t < best.t || hit.objPtr < best.objPtr)) {
+                    best = hit;
+                }
+            };
+            const auto visit = [&shapes, &r, &best, &consider, t_min](size_t i) noexcept {
+                consider(nearest_hit(shapes[i], r, t_min, best.t));
+                return best.t;
+            };
+            const auto visit_batch = [&world, &shapes, &bvh, &r, &best, &consider, &visit, t_min](size_t node) noexcept {
+                const auto b = world.sphere_batch_of(node);
+                if (b == SphereBatch::NONE) {
+                    return std::optional<Real>{};
+                }
+                const auto first_lane = b * SphereBatch::SIZE;
+                const auto [t, lane] = nearest_sphere_hit8(world.sphere_lanes(), first_lane, r, t_min);
+                if (t != NO_HIT && t <= best.t) {
+                    consider(intersection(t, shapes[world.sphere_lanes().object[first_lane + lane]]));
+                }
+                const auto& batch = world.sphere_batches()[b];
+                for (auto i = batch.first; i < batch.first + batch.count; ++i) {
+                    if (!std::holds_alternative<Sphere>(shapes[bvh.indices[i]])) {
+                        visit(bvh.indices[i]);
+                    }
+                }
+                return std::optional<Real>{ best.t };
+            };
+            traverse(bvh, r, t_min, t_max, visit, visit_batch);
+            return best ? best : Intersection{};
+        }
+#endif
+        return nearest_hit(world.objects(), objects_bvh(world), r, t_min, t_max);
+    }
+}
+
+/*Visits the instances whose world bounds the ray enters within [t_min, t_max], through the top level BVH.
+ visit(instance, asset, ray in the asset's space) returns the (possibly shrunk) t_max, like a traverse visitor.*/
+template<class Visitor>
+constexpr void traverse_instances(const World& world, const Ray& r, Real t_min, Real t_max, Visitor&& visit) {
+    const auto visit_instance = [&world, &r, &visit](size_t i) {
+        const auto& inst = world.instances()[i];
+        return std::invoke(visit, inst, world.assets()[inst.asset], transform(r, inst.inv_transform));
+    };
+    if (!world.is_built()) { //out of date, test them all
+        for (size_t i = 0; i < world.instances().size() && t_max >= t_min; ++i) {
+            t_max = visit_instance(i);
+        }
+        return;
     }
+    traverse(world.instance_bvh(), r, t_min, t_max, visit_instance);
+}
+
+//the nearest hit on an instance with t_min <= t <= t_max. On a tie the instance added first wins.
+constexpr Intersection nearest_instance_hit(const World& world, const Ray& r, Real t_min, Real t_max) noexcept {
+    Intersection best{};
+    traverse_instances(world, r, t_min, t_max, [&best, t_min, t_max](const Instance& inst, const Asset& a, const Ray& local_ray) noexcept {
+        auto hit = nearest_hit(a.shapes, a.bvh, local_ray, t_min, best ? best.t : t_max);
+        if (hit && (!best || hit.t < best.t || &inst < best.instance)) {
+            hit.instance = &inst;
+            best = hit;
+        }
+        return best ? best.t : t_max;
+    });
+    return best;
+}
+
+//collects the intersections of every object and instance whose bounds the ray enters within [t_min, t_max], sorted.
+constexpr auto intersect(const World& world, const Ray& r, Real t_min, Real t_max) {
+    Intersections result;
+    intersect(world.objects(), Detail::objects_bvh(world), r, t_min, t_max, result);
+    traverse_instances(world, r, t_min, t_max, [&result, t_min, t_max](const Instance& inst, const Asset& a, const Ray& local_ray) {
+        Intersections xs;
+        intersect(a.shapes, a.bvh, local_ray, t_min, t_max, xs);
+        for (auto& x : xs) {
+            x.instance = &inst;
+        }
+        result.push_back(xs);
+        return t_max;
+    });
     result.sort();
     return result;
 };
 
+constexpr auto intersect(const World& world, const Ray& r) {
+    //negative t's are kept: HitState needs them to work out which objects the ray origin is inside of.
+    return intersect(world, r, math::MIN, math::MAX);
+};
+
+//best, the nearest hit among the World's objects, or a nearer hit on one of its instances.
+constexpr Intersection closest_with_instances(const World& world, const Ray& r, const Intersection& best) noexcept {
+    if (world.instances().empty()) {
+        return best;
+    }
+    const auto hit = nearest_instance_hit(world, r, 0.0f, best ? best.t : math::MAX);
+    return (hit && (!best || hit.t < best.t)) ? hit : best;
+}
+
+//closest-hit query: the nearest intersection with t >= 0, same as closest(intersect(world, r)).
+//on a tie the object that comes first in the World wins, and objects come before instances.
+constexpr Intersection closest_hit(const World& world, const Ray& r) noexcept {
+    return closest_with_instances(world, r, Detail::nearest_object_hit(world, r, 0.0f, math::MAX));
+};
+
+//any-hit query: is there anything along the ray with 0 < t < max_t?
+//stops at the first hit found, in no particular order. Nothing is sorted, collected or allocated.
+constexpr bool occluded(const World& world, const Ray& r, Real max_t) noexcept {
+    if (occluded(world.objects(), Detail::objects_bvh(world), r, max_t)) {
+        return true;
+    }
+    bool hit = false;
+    traverse_instances(world, r, 0.0f, max_t, [&hit, max_t](const Instance&, const Asset& a, const Ray& local_ray) noexcept {
+        hit = occluded(a.shapes, a.bvh, local_ray, max_t); //transforms keep t, so max_t holds in the asset's space too
+        return hit ? TRAVERSAL_DONE : max_t;
+    });
+    return hit;
+};
+
 //TODO: consider an alternative algorithm: remove + min_element
 constexpr auto closest(const Intersections& xs) noexcept {
     const auto iter = std::ranges::min_element(xs,
@@ -16,6 +16,12 @@ constexpr Color get_color_at(const Material& surface, const Shapes& obj, const P
     return has_pattern(surface) ? pattern_at(surface.pattern, obj, world_point) : surface.color;
 }
 
+//the color of the hit surface at a world space point. Patterns on a shape in an asset are placed in the asset's space.
+constexpr Color get_color_at(const Material& surface, const HitState& hit, const Point& world_point) noexcept {
+    const auto point = hit.instancePtr ? hit.instancePtr->inv_transform * world_point : world_point;
+    return get_color_at(surface, hit.object(), point);
+}
+
 constexpr Color lighting(const Color& color, const Material& surface, const Light& light, const Point& p, const Vector& eye, const Vector& normal, bool in_shadow = false) noexcept {
     const auto effective_color = color * light.intensity;
     const auto ambient = effective_color * surface.ambient;
@@ -73,53 +79,58 @@ constexpr bool is_shadowed(const World& w, const Point& p) noexcept {
     const auto distanceSq = magnitudeSq(v);
     const auto direction = normalize(v);
     const auto r = ray(p, direction); //ray from point towards light source
-    try {
-        const auto hit = closest(intersect(w, r)); //intersect allocates
-        return (hit && (hit.t * hit.t) < distanceSq); //something is between us and the light.
-    }
-    catch (...) {}
-    return false;
+    return occluded(w, r, math::sqrt(distanceSq)); //something is between us and the light.
 }
 
 constexpr Color reflected_color(const World& w, const HitState& state, int remaining) noexcept;
 constexpr Color refracted_color(const World& w, const HitState& state, int remaining) noexcept;
 
 constexpr Color shade_hit(const World& w, const HitState& hit, int remaining = 4) noexcept {
+    const auto& surface = w.material_at(hit.material);
     const auto shadowed = is_shadowed(w, hit.over_point);
-    const auto surface_c = lighting(hit.surface(), hit.object(), w.light, hit.over_point, hit.eye_v, hit.normal, shadowed);
+    const auto surface_c = lighting(get_color_at(surface, hit, hit.over_point), surface, w.light, hit.over_point, hit.eye_v, hit.normal, shadowed);
     const auto reflected_c = reflected_color(w, hit, remaining);
     const auto refracted_c = refracted_color(w, hit, remaining);
-    if (hit.reflective() > 0 && hit.transparency() > 0) {
+    if (surface.reflective > 0 && surface.transparency > 0) {
         const auto reflectance = schlick(hit);
         return surface_c + (reflected_c * reflectance) + (refracted_c * (1.0f - reflectance));
     }
     return surface_c + reflected_c + refracted_c;
 }
 
-constexpr Color color_at(const World& w, const Ray& r, int remaining = 4) noexcept {
-    try {
-        const auto xs = intersect(w, r); //allocates.
-        const auto closestHit = closest(xs);
-        if (closestHit) {
-            const auto calcs = prepare_computations(closestHit, r, xs);
-            return shade_hit(w, calcs, remaining);
-        }
+//color_at, for a caller that has already found the closest hit along r.
+constexpr Color color_at(const World& w, const Ray& r, const Intersection& closestHit, int remaining = 4) noexcept {
+    if (!closestHit) {
+        return BLACK;
+    }
+    if (w.material_at(closestHit.material_id()).transparency == 0) {
+        return shade_hit(w, prepare_computations(closestHit, r), remaining);
+    }
+    try { //refraction needs n1 and n2, which takes a walk over every intersection along the ray.
+        const auto xs = intersect(w, r);
+        return shade_hit(w, prepare_computations(closestHit, r, xs, w.materials()), remaining);
     }
     catch (...) {}
     return BLACK;
 }
 
+constexpr Color color_at(const World& w, const Ray& r, int remaining = 4) noexcept {
+    return color_at(w, r, closest_hit(w, r), remaining);
+}
+
 constexpr Color reflected_color(const World& w, const HitState& state, int remaining) noexcept {
-    if (remaining < 1 || state.reflective() == 0) {
+    const auto reflective = w.material_at(state.material).reflective;
+    if (remaining < 1 || reflective == 0) {
         return BLACK;
     }
     const auto reflect_ray = ray(state.over_point, state.reflectv);
     const auto c = color_at(w, reflect_ray, remaining - 1);
-    return c * state.reflective();
+    return c * reflective;
 }
 
 constexpr Color refracted_color(const World& w, const HitState& state, int remaining) noexcept {
-    if (remaining < 1 || state.transparency() == 0) {
+    const auto transparency = w.material_at(state.material).transparency;
+    if (remaining < 1 || transparency == 0) {
         return BLACK;
     }
     const auto n_ratio = state.n1 / state.n2;
@@ -131,5 +142,5 @@ constexpr Color refracted_color(const World& w, const HitState& state, int remai
     const auto cos_t = math::sqrt(1.0f - sin2_t);
     const auto direction = state.normal * (n_ratio * cos_i - cos_t) - state.eye_v * n_ratio;
     const auto refract_ray = ray(state.under_point, direction);
-    return color_at(w, refract_ray, remaining - 1) * state.transparency();
+    return color_at(w, refract_ray, remaining - 1) * transparency;
 }
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+#include "pch.h"
+#include <string>
+#include <stdexcept>
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+/*A read-only view of a whole file, mapped into memory instead of read into a buffer.
+ The operating system pages the file in on demand, and parsers can work straight on the
+ string_view without a copy. The view is valid for the lifetime of the MappedFile.*/
+class MappedFile final {
+public:
+    explicit MappedFile(std::string_view path) {
+        const std::string filename(path);
+#if defined(_WIN32)
+        _file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("MappedFile: unable to open " + filename);
+        }
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(_file, &size)) {
+            close();
+            throw std::runtime_error("MappedFile: unable to get the size of " + filename);
+        }
+        _size = narrow_cast<size_t>(size.QuadPart);
+        if (_size == 0) {
+            return; //can't map an empty file, but it's a valid (empty) view.
+        }
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping == nullptr) {
+            close();
+            throw std::runtime_error("MappedFile: unable to map " + filename);
+        }
+        _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        _file = ::open(filename.c_str(), O_RDONLY);
+        if (_file == -1) {
+            throw std::runtime_error("MappedFile: unable to open " + filename);
+        }
+        struct stat info {};
+        if (::fstat(_file, &info) == -1) {
+            close();
+            throw std::runtime_error("MappedFile: unable to get the size of " + filename);
+        }
+        _size = narrow_cast<size_t>(info.st_size);
+        if (_size == 0) {
+            return;
+        }
+        void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+        _data = (data == MAP_FAILED) ? nullptr : static_cast<const char*>(data);
+        if (_data) {
+            ::madvise(data, _size, MADV_SEQUENTIAL);
+        }
+#endif
+        if (_data == nullptr) {
+            close();
+            throw std::runtime_error("MappedFile: unable to map " + filename);
+        }
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        close();
+    }
+
+    std::string_view view() const noexcept {
+        return _data ? std::string_view(_data, _size) : std::string_view{};
+    }
+    size_t size() const noexcept {
+        return _size;
+    }
+
+private:
+    void close() noexcept {
+#if defined(_WIN32)
+        if (_data) { UnmapViewOfFile(_data); }
+        if (_mapping) { CloseHandle(_mapping); }
+        if (_file != INVALID_HANDLE_VALUE) { CloseHandle(_file); }
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_data) { ::munmap(const_cast<char*>(_data), _size); }
+        if (_file != -1) { ::close(_file); }
+        _file = -1;
+#endif
+        _data = nullptr;
+    }
+
+#if defined(_WIN32)
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#else
+    int _file = -1;
+#endif
+    const char* _data = nullptr;
+    size_t _size = 0;
+};
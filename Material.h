@@ -61,11 +61,23 @@ constexpr Material material(Patterns pattern) noexcept {
 
 //clone a material and append new transform
 constexpr Material material(Material mat, const Matrix4& texture_transform) noexcept {    
-    auto& current_transform = get_transform(mat.pattern);
+    const auto current_transform = to_matrix4(get_transform(mat.pattern));
     set_transform(mat.pattern, current_transform * texture_transform);
     return mat; 
 }
 
 constexpr bool has_pattern(const Material& mat) noexcept {
     return std::visit([](const auto& obj) noexcept -> bool { return static_cast<bool>(obj); }, mat.pattern);
-}
\ No newline at end of file
+}
+
+/*
+ * Shapes refer to their material by index, into the material table of the World they are in.
+ *
+ * A Material is several hundred bytes (a Patterns variant with transforms and a std::function),
+ * and shading is the only thing that reads it. Shapes hold a 4 byte MaterialId instead, so the
+ * intersection loop only pulls geometry and transforms through the cache. Shapes given the same
+ * id share one material.
+ * Every table starts out with material() as DEFAULT_MATERIAL_ID, for the shapes that weren't given one.
+ */
+using MaterialId = uint32_t;
+static constexpr MaterialId DEFAULT_MATERIAL_ID = 0;
@@ -88,10 +88,124 @@ using Matrix3 = Matrix<3, 3>;
 using Matrix2 = Matrix<2, 2>;
 using Matrix1 = Matrix<1, 1>; //to stop template deductions from breaking
 static constexpr auto Matrix4Identity = Matrix4::identity();
+static constexpr auto Matrix3Identity = Matrix3::identity();
 
 static_assert(is_matrix<Matrix4>, "Constraint test failed. Matrix4 should be identified as a Matrix");
 static_assert(!is_matrix<Vector>, "Constraint test failed. Vector shouldn't be identified as a Matrix.");
 
+#if RTC_SIMD
+/*SSE versions of the Matrix4 hot paths. Matrix4 is row major and may be unaligned, so rows are loaded with loadu.
+ multiply and transform add the terms in the same order as the scalar code, and give identical results.
+ inverse uses 2x2 block adjugates (not the cofactor expansion), and agrees with the scalar inverse to within a few ulps.*/
+namespace simd {
+    template<int X, int Y, int Z, int W>
+    inline f32x4 swizzle(f32x4 v) noexcept {
+        return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+    }
+    template<int X, int Y, int Z, int W>
+    inline f32x4 shuffle(f32x4 a, f32x4 b) noexcept { //X, Y from a. Z, W from b.
+        return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+    }
+
+    struct Rows4 final {
+        f32x4 r0, r1, r2, r3;
+    };
+    inline Rows4 load_rows(const Matrix4& m) noexcept {
+        return { _mm_loadu_ps(m.data()), _mm_loadu_ps(m.data() + 4), _mm_loadu_ps(m.data() + 8), _mm_loadu_ps(m.data() + 12) };
+    }
+    inline void store_rows(Matrix4& m, const Rows4& rows) noexcept {
+        _mm_storeu_ps(m.data(), rows.r0);
+        _mm_storeu_ps(m.data() + 4, rows.r1);
+        _mm_storeu_ps(m.data() + 8, rows.r2);
+        _mm_storeu_ps(m.data() + 12, rows.r3);
+    }
+    //the columns of m, for transforming several tuples by the same matrix.
+    inline Rows4 load_columns(const Matrix4& m) noexcept {
+        auto c = load_rows(m);
+        _MM_TRANSPOSE4_PS(c.r0, c.r1, c.r2, c.r3);
+        return c;
+    }
+
+    inline Matrix4 multiply(const Matrix4& lhs, const Matrix4& rhs) noexcept {
+        const auto b = load_rows(rhs);
+        const auto row = [&b](const Real* a) noexcept {
+            auto sum = mul(splat(a[0]), b.r0);
+            sum = madd(splat(a[1]), b.r1, sum);
+            sum = madd(splat(a[2]), b.r2, sum);
+            return madd(splat(a[3]), b.r3, sum);
+        };
+        Matrix4 result;
+        store_rows(result, { row(lhs.data()), row(lhs.data() + 4), row(lhs.data() + 8), row(lhs.data() + 12) });
+        return result;
+    }
+
+    //x*column0 + y*column1 + z*column2 (+ column3 for points), with the padding lane zeroed.
+    inline f32x4 transform_vector(const Rows4& columns, f32x4 v) noexcept {
+        auto sum = mul(swizzle<0, 0, 0, 0>(v), columns.r0);
+        sum = madd(swizzle<1, 1, 1, 1>(v), columns.r1, sum);
+        sum = madd(swizzle<2, 2, 2, 2>(v), columns.r2, sum);
+        return _mm_blend_ps(sum, _mm_setzero_ps(), 0b1000);
+    }
+    inline f32x4 transform_point(const Rows4& columns, f32x4 p) noexcept {
+        auto sum = mul(swizzle<0, 0, 0, 0>(p), columns.r0);
+        sum = madd(swizzle<1, 1, 1, 1>(p), columns.r1, sum);
+        sum = madd(swizzle<2, 2, 2, 2>(p), columns.r2, sum);
+        return _mm_blend_ps(add(sum, columns.r3), _mm_setzero_ps(), 0b1000);
+    }
+
+    //2x2 row major blocks: [a b c d] is the matrix (a b / c d).
+    inline f32x4 mat2_mul(f32x4 a, f32x4 b) noexcept { //a * b
+        return add(mul(a, swizzle<0, 3, 0, 3>(b)), mul(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+    }
+    inline f32x4 mat2_adj_mul(f32x4 a, f32x4 b) noexcept { //adjugate(a) * b
+        return sub(mul(swizzle<3, 3, 0, 0>(a), b), mul(swizzle<1, 1, 2, 2>(a), swizzle<2, 3, 0, 1>(b)));
+    }
+    inline f32x4 mat2_mul_adj(f32x4 a, f32x4 b) noexcept { //a * adjugate(b)
+        return sub(mul(a, swizzle<3, 0, 3, 0>(b)), mul(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+    }
+
+    /*Inverse through the 4x4 matrix's 2x2 blocks A B / C D:
+     |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C), and each inverse block is a short expression in
+     the adjugates of the others (see https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html).*/
+    inline Matrix4 inverse(const Matrix4& m) noexcept {
+        const auto rows = load_rows(m);
+        const auto A = _mm_movelh_ps(rows.r0, rows.r1);
+        const auto B = _mm_movehl_ps(rows.r1, rows.r0);
+        const auto C = _mm_movelh_ps(rows.r2, rows.r3);
+        const auto D = _mm_movehl_ps(rows.r3, rows.r2);
+        const auto block_dets = sub( //(|A|, |B|, |C|, |D|)
+            mul(shuffle<0, 2, 0, 2>(rows.r0, rows.r2), shuffle<1, 3, 1, 3>(rows.r1, rows.r3)),
+            mul(shuffle<1, 3, 1, 3>(rows.r0, rows.r2), shuffle<0, 2, 0, 2>(rows.r1, rows.r3)));
+        const auto det_A = swizzle<0, 0, 0, 0>(block_dets);
+        const auto det_B = swizzle<1, 1, 1, 1>(block_dets);
+        const auto det_C = swizzle<2, 2, 2, 2>(block_dets);
+        const auto det_D = swizzle<3, 3, 3, 3>(block_dets);
+
+        const auto D_C = mat2_adj_mul(D, C);
+        const auto A_B = mat2_adj_mul(A, B);
+        auto X = sub(mul(det_D, A), mat2_mul(B, D_C));
+        auto W = sub(mul(det_A, D), mat2_mul(C, A_B));
+        auto Y = sub(mul(det_B, C), mat2_mul_adj(D, A_B));
+        auto Z = sub(mul(det_C, B), mat2_mul_adj(A, D_C));
+
+        auto trace = mul(A_B, swizzle<0, 2, 1, 3>(D_C));
+        trace = _mm_hadd_ps(trace, trace);
+        trace = _mm_hadd_ps(trace, trace);
+        const auto det = sub(add(mul(det_A, det_D), mul(det_B, det_C)), trace);
+        assert(_mm_cvtss_f32(det) != 0 && "Matrix4 inverse called with non-invertible Matrix");
+        const auto inv_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+        X = mul(X, inv_det);
+        Y = mul(Y, inv_det);
+        Z = mul(Z, inv_det);
+        W = mul(W, inv_det);
+
+        Matrix4 result; //the blocks' adjugates, transposed into place
+        store_rows(result, { shuffle<3, 1, 3, 1>(X, Y), shuffle<2, 0, 2, 0>(X, Y), shuffle<3, 1, 3, 1>(Z, W), shuffle<2, 0, 2, 0>(Z, W) });
+        return result;
+    }
+}
+#endif
+
 
 template <class Matrix>
     requires (is_matrix<Matrix>)
@@ -155,24 +269,36 @@ constexpr Matrix3 operator*(const Matrix3& lhs, const Matrix3& rhs) noexcept {
     lhs[8] * rhs[2] + lhs[9] * rhs[6] + lhs[10] * rhs[10] };//(2, 2)    
 }
 
+namespace Detail {
+    //the scalar Matrix4 routines. Used for constant evaluation, and whenever RTC_SIMD is off.
+    constexpr Matrix4 multiply_scalar(const Matrix4& lhs, const Matrix4& rhs) noexcept {
+        return Matrix4{
+        lhs[0] * rhs[0] + lhs[1] * rhs[4] + lhs[2] * rhs[8] + lhs[3] * rhs[12], //0,0
+        lhs[0] * rhs[1] + lhs[1] * rhs[5] + lhs[2] * rhs[9] + lhs[3] * rhs[13], //0,1
+        lhs[0] * rhs[2] + lhs[1] * rhs[6] + lhs[2] * rhs[10] + lhs[3] * rhs[14], //0,2 
+        lhs[0] * rhs[3] + lhs[1] * rhs[7] + lhs[2] * rhs[11] + lhs[3] * rhs[15], //0,3
+        lhs[4] * rhs[0] + lhs[5] * rhs[4] + lhs[6] * rhs[8] + lhs[7] * rhs[12],
+        lhs[4] * rhs[1] + lhs[5] * rhs[5] + lhs[6] * rhs[9] + lhs[7] * rhs[13],
+        lhs[4] * rhs[2] + lhs[5] * rhs[6] + lhs[6] * rhs[10] + lhs[7] * rhs[14],
+        lhs[4] * rhs[3] + lhs[5] * rhs[7] + lhs[6] * rhs[11] + lhs[7] * rhs[15],
+        lhs[8] * rhs[0] + lhs[9] * rhs[4] + lhs[10] * rhs[8] + lhs[11] * rhs[12],
+        lhs[8] * rhs[1] + lhs[9] * rhs[5] + lhs[10] * rhs[9] + lhs[11] * rhs[13],
+        lhs[8] * rhs[2] + lhs[9] * rhs[6] + lhs[10] * rhs[10] + lhs[11] * rhs[14],
+        lhs[8] * rhs[3] + lhs[9] * rhs[7] + lhs[10] * rhs[11] + lhs[11] * rhs[15],
+        lhs[12] * rhs[0] + lhs[13] * rhs[4] + lhs[14] * rhs[8] + lhs[15] * rhs[12], //3,0
+        lhs[12] * rhs[1] + lhs[13] * rhs[5] + lhs[14] * rhs[9] + lhs[15] * rhs[13], //3,1
+        lhs[12] * rhs[2] + lhs[13] * rhs[6] + lhs[14] * rhs[10] + lhs[15] * rhs[14], //3,2
+        lhs[12] * rhs[3] + lhs[13] * rhs[7] + lhs[14] * rhs[11] + lhs[15] * rhs[15] };//3,3
+    }
+}
+
 constexpr Matrix4 operator*(const Matrix4& lhs, const Matrix4& rhs) noexcept {
-    return Matrix4{
-    lhs[0] * rhs[0] + lhs[1] * rhs[4] + lhs[2] * rhs[8] + lhs[3] * rhs[12], //0,0
-    lhs[0] * rhs[1] + lhs[1] * rhs[5] + lhs[2] * rhs[9] + lhs[3] * rhs[13], //0,1
-    lhs[0] * rhs[2] + lhs[1] * rhs[6] + lhs[2] * rhs[10] + lhs[3] * rhs[14], //0,2 
-    lhs[0] * rhs[3] + lhs[1] * rhs[7] + lhs[2] * rhs[11] + lhs[3] * rhs[15], //0,3
-    lhs[4] * rhs[0] + lhs[5] * rhs[4] + lhs[6] * rhs[8] + lhs[7] * rhs[12],
-    lhs[4] * rhs[1] + lhs[5] * rhs[5] + lhs[6] * rhs[9] + lhs[7] * rhs[13],
-    lhs[4] * rhs[2] + lhs[5] * rhs[6] + lhs[6] * rhs[10] + lhs[7] * rhs[14],
-    lhs[4] * rhs[3] + lhs[5] * rhs[7] + lhs[6] * rhs[11] + lhs[7] * rhs[15],
-    lhs[8] * rhs[0] + lhs[9] * rhs[4] + lhs[10] * rhs[8] + lhs[11] * rhs[12],
-    lhs[8] * rhs[1] + lhs[9] * rhs[5] + lhs[10] * rhs[9] + lhs[11] * rhs[13],
-    lhs[8] * rhs[2] + lhs[9] * rhs[6] + lhs[10] * rhs[10] + lhs[11] * rhs[14],
-    lhs[8] * rhs[3] + lhs[9] * rhs[7] + lhs[10] * rhs[11] + lhs[11] * rhs[15],
-    lhs[12] * rhs[0] + lhs[13] * rhs[4] + lhs[14] * rhs[8] + lhs[15] * rhs[12], //3,0
-    lhs[12] * rhs[1] + lhs[13] * rhs[5] + lhs[14] * rhs[9] + lhs[15] * rhs[13], //3,1
-    lhs[12] * rhs[2] + lhs[13] * rhs[6] + lhs[14] * rhs[10] + lhs[15] * rhs[14], //3,2
-    lhs[12] * rhs[3] + lhs[13] * rhs[7] + lhs[14] * rhs[11] + lhs[15] * rhs[15] };//3,3
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        return simd::multiply(lhs, rhs);
+    }
+#endif
+    return Detail::multiply_scalar(lhs, rhs);
 }
 
 template <class Matrix>
@@ -198,20 +324,44 @@ constexpr auto operator*(const Matrix& lhs, const Matrix& rhs) noexcept {
     return result;
 }
 
+namespace Detail {
+    constexpr Vector transform_scalar(const Matrix4& lhs, const Vector& rhs) noexcept {
+        const auto x = rhs.x * lhs[0] + rhs.y * lhs[1] + rhs.z * lhs[2] + 0 * lhs[3];
+        const auto y = rhs.x * lhs[4] + rhs.y * lhs[5] + rhs.z * lhs[6] + 0 * lhs[7];
+        const auto z = rhs.x * lhs[8] + rhs.y * lhs[9] + rhs.z * lhs[10] + 0 * lhs[11];
+        //const auto w = rhs.x * lhs[12] + rhs.y  * lhs[13]+ rhs.z * lhs[14] + rhs.w * lhs[15];
+        return Vector{ x, y, z };
+    }
+
+    constexpr Point transform_scalar(const Matrix4& lhs, const Point& rhs) noexcept {
+        const auto x = rhs.x * lhs[0] + rhs.y * lhs[1] + rhs.z * lhs[2] + 1 * lhs[3];
+        const auto y = rhs.x * lhs[4] + rhs.y * lhs[5] + rhs.z * lhs[6] + 1 * lhs[7];
+        const auto z = rhs.x * lhs[8] + rhs.y * lhs[9] + rhs.z * lhs[10] + 1 * lhs[11];
+        //const auto w = rhs.x * lhs[12] + rhs.y  * lhs[13]+ rhs.z * lhs[14] + 1 * lhs[15];
+        return Point{ x, y, z };
+    }
+}
+
 constexpr Vector operator*(const Matrix4& lhs, const Vector& rhs) noexcept {
-    const auto x = rhs.x * lhs[0] + rhs.y * lhs[1] + rhs.z * lhs[2] + 0 * lhs[3];
-    const auto y = rhs.x * lhs[4] + rhs.y * lhs[5] + rhs.z * lhs[6] + 0 * lhs[7];
-    const auto z = rhs.x * lhs[8] + rhs.y * lhs[9] + rhs.z * lhs[10] + 0 * lhs[11];
-    //const auto w = rhs.x * lhs[12] + rhs.y  * lhs[13]+ rhs.z * lhs[14] + rhs.w * lhs[15];
-    return Vector{ x, y, z };
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Vector result;
+        simd::store(&result.x, simd::transform_vector(simd::load_columns(lhs), simd::load(&rhs.x)));
+        return result;
+    }
+#endif
+    return Detail::transform_scalar(lhs, rhs);
 }
 
 constexpr Point operator*(const Matrix4& lhs, const Point& rhs) noexcept {
-    const auto x = rhs.x * lhs[0] + rhs.y * lhs[1] + rhs.z * lhs[2] + 1 * lhs[3];
-    const auto y = rhs.x * lhs[4] + rhs.y * lhs[5] + rhs.z * lhs[6] + 1 * lhs[7];
-    const auto z = rhs.x * lhs[8] + rhs.y * lhs[9] + rhs.z * lhs[10] + 1 * lhs[11];
-    //const auto w = rhs.x * lhs[12] + rhs.y  * lhs[13]+ rhs.z * lhs[14] + 1 * lhs[15];
-    return Point{ x, y, z };
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Point result;
+        simd::store(&result.x, simd::transform_point(simd::load_columns(lhs), simd::load(&rhs.x)));
+        return result;
+    }
+#endif
+    return Detail::transform_scalar(lhs, rhs);
 }
 
 constexpr Matrix4 operator*(const Matrix4& lhs, const Real& s) noexcept {
@@ -358,130 +508,141 @@ constexpr Matrix inverse(const Matrix& in) noexcept {
     return result;
 }
 
-//unrolled, borrowed from gluInvertMatrix
+namespace Detail {
+    //unrolled, borrowed from gluInvertMatrix
+    constexpr Matrix4 inverse_scalar(const Matrix4& m) noexcept {
+        Matrix4 inv;
+        inv[0] = m[5] * m[10] * m[15] -
+            m[5] * m[11] * m[14] -
+            m[9] * m[6] * m[15] +
+            m[9] * m[7] * m[14] +
+            m[13] * m[6] * m[11] -
+            m[13] * m[7] * m[10];
+
+        inv[4] = -m[4] * m[10] * m[15] +
+            m[4] * m[11] * m[14] +
+            m[8] * m[6] * m[15] -
+            m[8] * m[7] * m[14] -
+            m[12] * m[6] * m[11] +
+            m[12] * m[7] * m[10];
+
+        inv[8] = m[4] * m[9] * m[15] -
+            m[4] * m[11] * m[13] -
+            m[8] * m[5] * m[15] +
+            m[8] * m[7] * m[13] +
+            m[12] * m[5] * m[11] -
+            m[12] * m[7] * m[9];
+
+        inv[12] = -m[4] * m[9] * m[14] +
+            m[4] * m[10] * m[13] +
+            m[8] * m[5] * m[14] -
+            m[8] * m[6] * m[13] -
+            m[12] * m[5] * m[10] +
+            m[12] * m[6] * m[9];
+
+        inv[1] = -m[1] * m[10] * m[15] +
+            m[1] * m[11] * m[14] +
+            m[9] * m[2] * m[15] -
+            m[9] * m[3] * m[14] -
+            m[13] * m[2] * m[11] +
+            m[13] * m[3] * m[10];
+
+        inv[5] = m[0] * m[10] * m[15] -
+            m[0] * m[11] * m[14] -
+            m[8] * m[2] * m[15] +
+            m[8] * m[3] * m[14] +
+            m[12] * m[2] * m[11] -
+            m[12] * m[3] * m[10];
+
+        inv[9] = -m[0] * m[9] * m[15] +
+            m[0] * m[11] * m[13] +
+            m[8] * m[1] * m[15] -
+            m[8] * m[3] * m[13] -
+            m[12] * m[1] * m[11] +
+            m[12] * m[3] * m[9];
+
+        inv[13] = m[0] * m[9] * m[14] -
+            m[0] * m[10] * m[13] -
+            m[8] * m[1] * m[14] +
+            m[8] * m[2] * m[13] +
+            m[12] * m[1] * m[10] -
+            m[12] * m[2] * m[9];
+
+        inv[2] = m[1] * m[6] * m[15] -
+            m[1] * m[7] * m[14] -
+            m[5] * m[2] * m[15] +
+            m[5] * m[3] * m[14] +
+            m[13] * m[2] * m[7] -
+            m[13] * m[3] * m[6];
+
+        inv[6] = -m[0] * m[6] * m[15] +
+            m[0] * m[7] * m[14] +
+            m[4] * m[2] * m[15] -
+            m[4] * m[3] * m[14] -
+            m[12] * m[2] * m[7] +
+            m[12] * m[3] * m[6];
+
+        inv[10] = m[0] * m[5] * m[15] -
+            m[0] * m[7] * m[13] -
+            m[4] * m[1] * m[15] +
+            m[4] * m[3] * m[13] +
+            m[12] * m[1] * m[7] -
+            m[12] * m[3] * m[5];
+
+        inv[14] = -m[0] * m[5] * m[14] +
+            m[0] * m[6] * m[13] +
+            m[4] * m[1] * m[14] -
+            m[4] * m[2] * m[13] -
+            m[12] * m[1] * m[6] +
+            m[12] * m[2] * m[5];
+
+        inv[3] = -m[1] * m[6] * m[11] +
+            m[1] * m[7] * m[10] +
+            m[5] * m[2] * m[11] -
+            m[5] * m[3] * m[10] -
+            m[9] * m[2] * m[7] +
+            m[9] * m[3] * m[6];
+
+        inv[7] = m[0] * m[6] * m[11] -
+            m[0] * m[7] * m[10] -
+            m[4] * m[2] * m[11] +
+            m[4] * m[3] * m[10] +
+            m[8] * m[2] * m[7] -
+            m[8] * m[3] * m[6];
+
+        inv[11] = -m[0] * m[5] * m[11] +
+            m[0] * m[7] * m[9] +
+            m[4] * m[1] * m[11] -
+            m[4] * m[3] * m[9] -
+            m[8] * m[1] * m[7] +
+            m[8] * m[3] * m[5];
+
+        inv[15] = m[0] * m[5] * m[10] -
+            m[0] * m[6] * m[9] -
+            m[4] * m[1] * m[10] +
+            m[4] * m[2] * m[9] +
+            m[8] * m[1] * m[6] -
+            m[8] * m[2] * m[5];
+
+        auto det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+        assert(det != 0 && "Matrix4 inverse called with non-invertible Matrix");
+        det = 1.0f / det;
+        return {
+            inv[0] * det, inv[1] * det,inv[2] * det, inv[3] * det,
+            inv[4] * det, inv[5] * det,inv[6] * det, inv[7] * det,
+            inv[8] * det, inv[9] * det,inv[10] * det, inv[11] * det,
+            inv[12] * det, inv[13] * det,inv[14] * det, inv[15] * det,
+        };
+    }
+}
+
 constexpr Matrix4 inverse(const Matrix4& m) noexcept {
-    Matrix4 inv;
-    inv[0] = m[5] * m[10] * m[15] -
-        m[5] * m[11] * m[14] -
-        m[9] * m[6] * m[15] +
-        m[9] * m[7] * m[14] +
-        m[13] * m[6] * m[11] -
-        m[13] * m[7] * m[10];
-
-    inv[4] = -m[4] * m[10] * m[15] +
-        m[4] * m[11] * m[14] +
-        m[8] * m[6] * m[15] -
-        m[8] * m[7] * m[14] -
-        m[12] * m[6] * m[11] +
-        m[12] * m[7] * m[10];
-
-    inv[8] = m[4] * m[9] * m[15] -
-        m[4] * m[11] * m[13] -
-        m[8] * m[5] * m[15] +
-        m[8] * m[7] * m[13] +
-        m[12] * m[5] * m[11] -
-        m[12] * m[7] * m[9];
-
-    inv[12] = -m[4] * m[9] * m[14] +
-        m[4] * m[10] * m[13] +
-        m[8] * m[5] * m[14] -
-        m[8] * m[6] * m[13] -
-        m[12] * m[5] * m[10] +
-        m[12] * m[6] * m[9];
-
-    inv[1] = -m[1] * m[10] * m[15] +
-        m[1] * m[11] * m[14] +
-        m[9] * m[2] * m[15] -
-        m[9] * m[3] * m[14] -
-        m[13] * m[2] * m[11] +
-        m[13] * m[3] * m[10];
-
-    inv[5] = m[0] * m[10] * m[15] -
-        m[0] * m[11] * m[14] -
-        m[8] * m[2] * m[15] +
-        m[8] * m[3] * m[14] +
-        m[12] * m[2] * m[11] -
-        m[12] * m[3] * m[10];
-
-    inv[9] = -m[0] * m[9] * m[15] +
-        m[0] * m[11] * m[13] +
-        m[8] * m[1] * m[15] -
-        m[8] * m[3] * m[13] -
-        m[12] * m[1] * m[11] +
-        m[12] * m[3] * m[9];
-
-    inv[13] = m[0] * m[9] * m[14] -
-        m[0] * m[10] * m[13] -
-        m[8] * m[1] * m[14] +
-        m[8] * m[2] * m[13] +
-        m[12] * m[1] * m[10] -
-        m[12] * m[2] * m[9];
-
-    inv[2] = m[1] * m[6] * m[15] -
-        m[1] * m[7] * m[14] -
-        m[5] * m[2] * m[15] +
-        m[5] * m[3] * m[14] +
-        m[13] * m[2] * m[7] -
-        m[13] * m[3] * m[6];
-
-    inv[6] = -m[0] * m[6] * m[15] +
-        m[0] * m[7] * m[14] +
-        m[4] * m[2] * m[15] -
-        m[4] * m[3] * m[14] -
-        m[12] * m[2] * m[7] +
-        m[12] * m[3] * m[6];
-
-    inv[10] = m[0] * m[5] * m[15] -
-        m[0] * m[7] * m[13] -
-        m[4] * m[1] * m[15] +
-        m[4] * m[3] * m[13] +
-        m[12] * m[1] * m[7] -
-        m[12] * m[3] * m[5];
-
-    inv[14] = -m[0] * m[5] * m[14] +
-        m[0] * m[6] * m[13] +
-        m[4] * m[1] * m[14] -
-        m[4] * m[2] * m[13] -
-        m[12] * m[1] * m[6] +
-        m[12] * m[2] * m[5];
-
-    inv[3] = -m[1] * m[6] * m[11] +
-        m[1] * m[7] * m[10] +
-        m[5] * m[2] * m[11] -
-        m[5] * m[3] * m[10] -
-        m[9] * m[2] * m[7] +
-        m[9] * m[3] * m[6];
-
-    inv[7] = m[0] * m[6] * m[11] -
-        m[0] * m[7] * m[10] -
-        m[4] * m[2] * m[11] +
-        m[4] * m[3] * m[10] +
-        m[8] * m[2] * m[7] -
-        m[8] * m[3] * m[6];
-
-    inv[11] = -m[0] * m[5] * m[11] +
-        m[0] * m[7] * m[9] +
-        m[4] * m[1] * m[11] -
-        m[4] * m[3] * m[9] -
-        m[8] * m[1] * m[7] +
-        m[8] * m[3] * m[5];
-
-    inv[15] = m[0] * m[5] * m[10] -
-        m[0] * m[6] * m[9] -
-        m[4] * m[1] * m[10] +
-        m[4] * m[2] * m[9] +
-        m[8] * m[1] * m[6] -
-        m[8] * m[2] * m[5];
-
-    auto det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
-    assert(det != 0 && "Matrix4 inverse called with non-invertible Matrix");
-    det = 1.0f / det;
-    return {
-        inv[0] * det, inv[1] * det,inv[2] * det, inv[3] * det,
-        inv[4] * det, inv[5] * det,inv[6] * det, inv[7] * det,
-        inv[8] * det, inv[9] * det,inv[10] * det, inv[11] * det,
-        inv[12] * det, inv[13] * det,inv[14] * det, inv[15] * det,
-    };
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        return simd::inverse(m);
+    }
+#endif
+    return Detail::inverse_scalar(m);
 }
 
 constexpr Matrix4 translation(Real x, Real y, Real z) noexcept {
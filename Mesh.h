@@ -0,0 +1,195 @@
+#pragma once
+#include "pch.h"
+#include <span>
+#include <vector>
+#include "Tuple.h"
+#include "Matrix.h"
+#include "Affine.h"
+#include "Material.h"
+#include "SharedRef.h"
+#include "Ray.h"
+#include "AABB.h"
+#include "BVH.h"
+#include "InlineVector.h"
+#include "Triangle.h"
+
+/*
+ * Triangle meshes.
+ *
+ * MeshData is the geometry: a vertex buffer, a normal buffer, the faces indexing into them, and a BVH
+ * over the faces. Faces are numbered triangles first, then smooth triangles; a hit reports that number
+ * as its face. MeshData is shared through a handle, and is never copied or changed once it's
+ * built. A Mesh is the shape that places one in a World: a transform, a material id and a pointer to
+ * the MeshData, so a million-triangle asset is still one small, trivially copyable entry in the Shapes
+ * variant. The Mesh doesn't own the data: whoever places it keeps a MeshRef for as long as the shape
+ * is in use. World::add_mesh and SceneGraph::add_mesh keep one for their own shapes.
+ */
+struct MeshData final {
+    std::vector<Point> vertices;
+    std::vector<Vector> normals; //for the smooth triangles
+    std::vector<Triangle> triangles;
+    std::vector<SmoothTriangle> smooth_triangles;
+    BVH bvh; //over every face. built by build_mesh
+    AABB bounds; //of every vertex in use. computed by build_mesh
+
+    constexpr size_t size() const noexcept {
+        return triangles.size() + smooth_triangles.size();
+    }
+    //the corners of face i.
+    constexpr std::array<uint32_t, 3> corners(size_t i) const noexcept {
+        assert(i < size() && "MeshData::corners(i) face index is out of bounds");
+        return i < triangles.size() ? triangles[i].v : smooth_triangles[i - triangles.size()].v;
+    }
+};
+
+//a handle to a finished mesh. The MeshData is shared by every handle, and freed with the last one.
+//An empty handle is a mesh without faces. Meshes are never written once built.
+using MeshRef = SharedRef<MeshData>;
+
+//computes the bounds and the BVH of the mesh, for Mesh shapes to share.
+inline MeshRef build_mesh(MeshData m) {
+    assert(std::ranges::all_of(m.smooth_triangles, [&m](const SmoothTriangle& t) noexcept {
+        return std::ranges::all_of(t.n, [&m](uint32_t n) noexcept { return n < m.normals.size(); });
+        }) && "build_mesh: a smooth triangle refers to a missing normal");
+    std::vector<AABB> boxes;
+    boxes.reserve(m.size());
+    for (size_t i = 0; i < m.size(); ++i) {
+        const auto [a, b, c] = m.corners(i);
+        assert(a < m.vertices.size() && b < m.vertices.size() && c < m.vertices.size() && "build_mesh: a face refers to a missing vertex");
+        boxes.push_back(triangle_bounds(m.vertices[a], m.vertices[b], m.vertices[c]));
+        grow(m.bounds, boxes.back());
+    }
+    m.bvh = build_bvh(boxes);
+    return MeshRef(std::move(m));
+}
+
+struct Mesh final {
+    constexpr Mesh() noexcept = default;
+    explicit constexpr Mesh(const MeshRef& m) noexcept : _mesh(&*m) {}
+    constexpr Mesh(const MeshRef& mesh, MaterialId m) noexcept : _material(m), _mesh(&*mesh) {}
+    constexpr Mesh(const MeshRef& m, Matrix4 transf) noexcept : _mesh(&*m) {
+        set_transform(std::move(transf));
+    }
+    constexpr Mesh(const MeshRef& mesh, MaterialId m, Matrix4 transf) noexcept : _material(m), _mesh(&*mesh) {
+        set_transform(std::move(transf));
+    }
+    constexpr auto operator==(const Mesh& that) const noexcept {
+        return _mesh == that._mesh && _material == that._material && _transform == that._transform;
+    }
+    //the faces, which a MeshRef elsewhere keeps alive. a default constructed Mesh has none.
+    constexpr const MeshData& data() const noexcept {
+        return _mesh ? *_mesh : *MeshRef{};
+    }
+    constexpr const Affine& get_transform() const noexcept {
+        return _transform;
+    }
+    constexpr const Affine& inv_transform() const noexcept {
+        return _invTransform;
+    }
+    constexpr const Matrix3& normal_transform() const noexcept {
+        return _normalTransform;
+    }
+    constexpr void set_transform(Matrix4 mat) noexcept {
+        _transform = affine(mat);
+        _invTransform = inverse(_transform);
+        _normalTransform = normal_matrix(_invTransform);
+    }
+    constexpr MaterialId material_id() const noexcept {
+        return _material;
+    }
+    constexpr void set_material(MaterialId m) noexcept {
+        _material = m;
+    }
+private:
+    MaterialId _material = DEFAULT_MATERIAL_ID;
+    Affine _transform{ AffineIdentity };
+    Affine _invTransform{ AffineIdentity };
+    Matrix3 _normalTransform{ Matrix3Identity };
+    const MeshData* _mesh = nullptr; //last, so the 4 byte id packs with the matrices instead of padding
+};
+
+constexpr Mesh mesh(const MeshRef& m) noexcept {
+    return Mesh(m);
+}
+constexpr Mesh mesh(const MeshRef& mesh, MaterialId m) noexcept {
+    return Mesh(mesh, m);
+}
+constexpr Mesh mesh(const MeshRef& m, Matrix4 transform) noexcept {
+    return Mesh(m, std::move(transform));
+}
+constexpr Mesh mesh(const MeshRef& mesh, MaterialId m, Matrix4 transform) noexcept {
+    return Mesh(mesh, m, std::move(transform));
+}
+
+inline std::ostream& operator<<(std::ostream& os, const Mesh& t) {
+    os << std::format("Mesh({} faces, {})"sv, t.data().size(), t.get_transform());
+    return os;
+}
+
+//object space bounds: every vertex of the mesh.
+inline AABB local_bounds(const Mesh& m) noexcept {
+    return m.data().bounds;
+}
+
+/*Visits the faces the ray crosses within [t_min, t_max], through the mesh's BVH. The ray is in the
+ mesh's space. visit(face, hit) returns the (possibly shrunk) t_max, like a traverse visitor.*/
+template<class Visitor>
+constexpr void traverse_faces(const MeshData& m, const Ray& local_ray, Real t_min, Real t_max, Visitor&& visit) {
+    traverse(m.bvh, local_ray, t_min, t_max, [&m, &local_ray, &visit, &t_max, t_min](size_t face) {
+        const auto [a, b, c] = m.corners(face);
+        const auto hit = intersect_triangle(m.vertices[a], m.vertices[b], m.vertices[c], local_ray);
+        if (hit && hit.t >= t_min && hit.t <= t_max) {
+            t_max = std::invoke(visit, face, hit);
+        }
+        return t_max;
+    });
+}
+
+//the nearest face the ray crosses with t_min <= t <= t_max, and where. On a tie the lower face number wins.
+struct FaceHit final {
+    uint32_t face = 0;
+    TriangleHit hit{};
+};
+constexpr FaceHit nearest_face(const MeshData& m, const Ray& local_ray, Real t_min, Real t_max) noexcept {
+    FaceHit best;
+    traverse_faces(m, local_ray, t_min, t_max, [&best](size_t face, const TriangleHit& hit) noexcept {
+        if (hit.t < best.hit.t || (hit.t == best.hit.t && face < best.face)) {
+            best = FaceHit{ narrow_cast<uint32_t>(face), hit };
+        }
+        return best.hit.t;
+    });
+    return best;
+}
+
+//does the ray cross any face with t_min <= t < t_max? stops at the first one found, in no particular order.
+constexpr bool any_face(const MeshData& m, const Ray& local_ray, Real t_min, Real t_max) noexcept {
+    bool found = false;
+    traverse_faces(m, local_ray, t_min, t_max, [&found, t_max](size_t, const TriangleHit& hit) noexcept {
+        found = hit.t < t_max;
+        return found ? TRAVERSAL_DONE : t_max;
+    });
+    return found;
+}
+
+/*A mesh can be hit any number of times, so this is only the nearest hit with t >= 0: a face at t == 0
+ hides the ones behind it. Shadow rays use any_face instead, and intersect() and nearest_hit() in
+ Intersection.h report every face hit, with the face and its u and v.*/
+inline LocalHits local_intersect(const Mesh& m, const Ray& local_ray) noexcept {
+    const auto nearest = nearest_face(m.data(), local_ray, 0.0f, math::MAX);
+    return nearest.hit ? LocalHits{ nearest.hit.t } : MISS;
+}
+
+//the object space normal of a face, at the hit's u and v. Flat triangles ignore u and v.
+constexpr Vector local_normal_at(const MeshData& m, size_t face, Real u, Real v) noexcept {
+    const auto [a, b, c] = m.corners(face);
+    if (face < m.triangles.size()) {
+        return triangle_normal(m.vertices[a], m.vertices[b], m.vertices[c]);
+    }
+    const auto& n = m.smooth_triangles[face - m.triangles.size()].n;
+    return interpolate_normal(m.normals[n[0]], m.normals[n[1]], m.normals[n[2]], u, v);
+}
+
+//the world space normal of a face of a mesh, at the hit's u and v.
+inline Vector normal_at(const Mesh& m, size_t face, Real u, Real v) noexcept {
+    return normalize(m.normal_transform() * local_normal_at(m.data(), face, u, v));
+}
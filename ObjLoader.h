@@ -0,0 +1,340 @@
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "StringHelpers.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "SceneGraph.h"
+
+/*
+ * Wavefront OBJ files: https://paulbourke.net/dataformats/obj/
+ *
+ * Reads vertices (v), vertex normals (vn), faces (f) and groups (g). A face of more than three corners
+ * is fan triangulated around its first corner. A face whose corners name normals (f 1//3 or f 1/2/3)
+ * becomes a SmoothTriangle, any other a Triangle. Every other kind of line is counted and skipped.
+ *
+ * Files of hundreds of MB are mapped rather than read, and parsed in two parallel passes over chunks
+ * that start at line breaks. The first pass counts the records in each chunk, and a prefix sum over
+ * the counts tells every chunk where its vertices, normals, faces and groups go. The second parses
+ * each chunk with from_chars straight into arrays that were sized once, up front. The prefix sums
+ * also give each line the number of vertices before it, which is what negative indices count back from.
+ */
+static constexpr size_t OBJ_BYTES_PER_TASK = 256 * 1024; //OBJ text handed to each parse task
+
+class obj_parse_error : public std::runtime_error{
+public:
+    explicit obj_parse_error(std::string_view what) noexcept : std::runtime_error(what.data()){}
+};
+
+//a g line: the faces after it, up to the next g line, belong to the group.
+struct ObjGroup final {
+    std::string name;
+    uint32_t first_triangle = 0; //into MeshData::triangles
+    uint32_t triangle_count = 0;
+    uint32_t first_smooth_triangle = 0; //into MeshData::smooth_triangles
+    uint32_t smooth_triangle_count = 0;
+
+    constexpr size_t size() const noexcept {
+        return size_t{ triangle_count } + smooth_triangle_count;
+    }
+};
+
+struct ObjModel final {
+    MeshData mesh; //every face of the file, in file order. hand it to build_mesh for a single Mesh of the lot
+    std::vector<ObjGroup> groups; //groups[0] is the default group: the faces before the first g line
+    size_t ignored_lines = 0;
+};
+
+namespace Detail{
+    struct ObjCounts final {
+        size_t vertices = 0;
+        size_t normals = 0;
+        size_t triangles = 0;
+        size_t smooth_triangles = 0;
+        size_t groups = 0;
+        size_t ignored = 0;
+
+        constexpr ObjCounts operator+(const ObjCounts& that) const noexcept{
+            return { vertices + that.vertices, normals + that.normals, triangles + that.triangles,
+                smooth_triangles + that.smooth_triangles, groups + that.groups, ignored + that.ignored };
+        }
+    };
+
+    constexpr bool is_obj_space(char c) noexcept{
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    //splits the next whitespace separated token off the front of line. Empty at the end of the line.
+    constexpr std::string_view next_obj_token(std::string_view& line) noexcept{
+        size_t begin = 0;
+        while (begin < line.size() && is_obj_space(line[begin])) {
+            ++begin;
+        }
+        auto end = begin;
+        while (end < line.size() && !is_obj_space(line[end])) {
+            ++end;
+        }
+        const auto token = line.substr(begin, end - begin);
+        line.remove_prefix(end);
+        return token;
+    }
+
+    //calls on_line(line) for every line of text, without its line break or comment.
+    template<class Callable>
+    constexpr void for_each_obj_line(std::string_view text, Callable&& on_line) noexcept{
+        size_t offset = 0;
+        while (offset < text.size()) {
+            auto line_end = text.find('\n', offset);
+            if (line_end == std::string_view::npos) {
+                line_end = text.size();
+            }
+            auto line = text.substr(offset, line_end - offset);
+            if (const auto comment = line.find('#'); comment != std::string_view::npos) {
+                line = line.substr(0, comment);
+            }
+            on_line(line);
+            offset = line_end + 1;
+        }
+    }
+
+    //does a face corner (v, v/vt, v//vn or v/vt/vn) name a normal?
+    constexpr bool has_normal(std::string_view corner) noexcept{
+        const auto first = corner.find('/');
+        if (first == std::string_view::npos) {
+            return false;
+        }
+        const auto second = corner.find('/', first + 1);
+        return second != std::string_view::npos && second + 1 < corner.size();
+    }
+
+    constexpr ObjCounts count_obj_records(std::string_view text) noexcept{
+        ObjCounts counts;
+        for_each_obj_line(text, [&counts](std::string_view line) noexcept{
+            const auto keyword = next_obj_token(line);
+            if (keyword.empty()) {
+                return;
+            }
+            if (keyword == "v"sv) {
+                ++counts.vertices;
+            } else if (keyword == "vn"sv) {
+                ++counts.normals;
+            } else if (keyword == "g"sv) {
+                ++counts.groups;
+            } else if (keyword == "f"sv) {
+                const auto first = next_obj_token(line);
+                size_t corners = first.empty() ? 0 : 1;
+                while (!next_obj_token(line).empty()) {
+                    ++corners;
+                }
+                if (corners >= 3) {
+                    (has_normal(first) ? counts.smooth_triangles : counts.triangles) += corners - 2;
+                }
+            } else {
+                ++counts.ignored;
+            }
+        });
+        return counts;
+    }
+
+    /*An OBJ index into an array of count elements, zero based. Positive indices count from 1, negative
+     ones back from defined_so_far, the number of elements defined above the line. Returns count if the
+     index is malformed or out of range.*/
+    size_t resolve_obj_index(std::string_view index, size_t defined_so_far, size_t count) noexcept{
+        int64_t value{};
+        const auto [ptr, ec] = std::from_chars(index.data(), index.data() + index.size(), value);
+        if (ec != std::errc{} || ptr != index.data() + index.size() || value == 0) {
+            return count;
+        }
+        const auto resolved = value > 0 ? value - 1 : static_cast<int64_t>(defined_so_far) + value;
+        return (resolved < 0 || static_cast<size_t>(resolved) >= count) ? count : static_cast<size_t>(resolved);
+    }
+
+    //reads x, y and z off the front of line. Anything after them (a vertex's w) is ignored.
+    bool parse_obj_xyz(std::string_view line, Real& x, Real& y, Real& z) noexcept{
+        for (auto* value : { &x, &y, &z }) {
+            const auto token = next_obj_token(line);
+            const auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), *value);
+            if (token.empty() || ec != std::errc{} || ptr != token.data() + token.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*Parses a chunk into the model, starting at the offsets in at. A smooth face's corners must all
+     name a normal, since its counting decided on the first one alone. Returns false on a malformed record.*/
+    bool parse_obj_records(std::string_view text, ObjCounts at, ObjModel& model) noexcept{
+        auto& m = model.mesh;
+        bool ok = true;
+        for_each_obj_line(text, [&](std::string_view line) noexcept{
+            const auto keyword = next_obj_token(line);
+            if (!ok || keyword.empty()) {
+                return;
+            }
+            if (keyword == "v"sv) {
+                auto& p = m.vertices[at.vertices++];
+                ok = parse_obj_xyz(line, p.x, p.y, p.z);
+            } else if (keyword == "vn"sv) {
+                auto& n = m.normals[at.normals++];
+                ok = parse_obj_xyz(line, n.x, n.y, n.z);
+            } else if (keyword == "g"sv) {
+                const auto name_begin = line.find_first_not_of(" \t\r"sv);
+                const auto name = name_begin == std::string_view::npos ? std::string_view{} : line.substr(name_begin, line.find_last_not_of(" \t\r"sv) + 1 - name_begin);
+                model.groups[++at.groups] = ObjGroup{ std::string(name), narrow_cast<uint32_t>(at.triangles), 0, narrow_cast<uint32_t>(at.smooth_triangles), 0 };
+            } else if (keyword == "f"sv) {
+                std::array<uint32_t, 2> first{}; //the corner every triangle of the fan shares: vertex, normal
+                std::array<uint32_t, 2> previous{};
+                bool smooth = false;
+                for (size_t corner = 0; ok; ++corner) {
+                    const auto token = next_obj_token(line);
+                    if (token.empty()) {
+                        break;
+                    }
+                    if (corner == 0) {
+                        smooth = has_normal(token);
+                    }
+                    const auto slash = token.find('/');
+                    const auto v = resolve_obj_index(token.substr(0, slash), at.vertices, m.vertices.size());
+                    auto n = size_t{ 0 };
+                    if (smooth) {
+                        n = has_normal(token) ? resolve_obj_index(token.substr(token.rfind('/') + 1), at.normals, m.normals.size()) : m.normals.size();
+                        ok = n < m.normals.size();
+                    }
+                    ok = ok && v < m.vertices.size();
+                    const std::array<uint32_t, 2> current{ narrow_cast<uint32_t>(v), narrow_cast<uint32_t>(n) };
+                    if (ok && corner >= 2) {
+                        if (smooth) {
+                            m.smooth_triangles[at.smooth_triangles++] = SmoothTriangle{ { first[0], previous[0], current[0] }, { first[1], previous[1], current[1] } };
+                        } else {
+                            m.triangles[at.triangles++] = Triangle{ { first[0], previous[0], current[0] } };
+                        }
+                    }
+                    if (corner == 0) {
+                        first = current;
+                    }
+                    previous = current;
+                }
+            }
+        });
+        return ok;
+    }
+}
+
+/*Parses OBJ text. chunk_size is the text handed to each parse task.
+ Throws obj_parse_error for a malformed number, or an index to a vertex or normal that doesn't exist.*/
+ObjModel parse_obj(std::string_view obj, size_t chunk_size = OBJ_BYTES_PER_TASK) {
+    using Detail::ObjCounts;
+    const auto starts = line_chunk_starts(obj, chunk_size);
+    const auto chunk_count = starts.size() - 1;
+    const auto chunk = [&obj, &starts](size_t i) noexcept{ return obj.substr(starts[i], starts[i + 1] - starts[i]); };
+    std::vector<ObjCounts> first(chunk_count + 1);
+    parallel_for(chunk_count, 1, [&chunk, &first](size_t begin, size_t end) noexcept{
+        for (auto i = begin; i < end; ++i) {
+            first[i + 1] = Detail::count_obj_records(chunk(i));
+        }
+    });
+    std::partial_sum(first.begin(), first.end(), first.begin(), std::plus<>{});
+    const auto& total = first.back();
+    if (total.vertices > std::numeric_limits<uint32_t>::max() || total.normals > std::numeric_limits<uint32_t>::max()
+        || total.triangles > std::numeric_limits<uint32_t>::max() || total.smooth_triangles > std::numeric_limits<uint32_t>::max()) {
+        throw obj_parse_error("OBJ file is too large for 32 bit indices.");
+    }
+
+    ObjModel model;
+    model.mesh.vertices.resize(total.vertices);
+    model.mesh.normals.resize(total.normals);
+    model.mesh.triangles.resize(total.triangles);
+    model.mesh.smooth_triangles.resize(total.smooth_triangles);
+    model.groups.resize(total.groups + 1);
+    model.ignored_lines = total.ignored;
+    std::atomic<bool> malformed{ false };
+    parallel_for(chunk_count, 1, [&](size_t begin, size_t end) noexcept{
+        for (auto i = begin; i < end; ++i) {
+            if (!Detail::parse_obj_records(chunk(i), first[i], model)) {
+                malformed.store(true, std::memory_order_relaxed);
+            }
+        }
+    });
+    if (malformed.load()) throw obj_parse_error("Malformed OBJ record, or an index out of range.");
+
+    for (size_t g = 0; g < model.groups.size(); ++g) { //a group ends where the next begins
+        auto& group = model.groups[g];
+        const auto is_last = g + 1 == model.groups.size();
+        group.triangle_count = narrow_cast<uint32_t>((is_last ? total.triangles : model.groups[g + 1].first_triangle) - group.first_triangle);
+        group.smooth_triangle_count = narrow_cast<uint32_t>((is_last ? total.smooth_triangles : model.groups[g + 1].first_smooth_triangle) - group.first_smooth_triangle);
+    }
+    return model;
+}
+
+//memory maps the file and parses it in place, without reading it into a buffer first.
+ObjModel load_obj(std::string_view path) {
+    const MappedFile file(path);
+    return parse_obj(file.view());
+}
+
+/*The faces of one group as a mesh of their own, with only the vertices and normals they use.
+ The faces keep their order; the vertices keep their relative order.*/
+MeshData group_mesh(const ObjModel& model, size_t group) {
+    assert(group < model.groups.size() && "group_mesh: no such group");
+    const auto& g = model.groups[group];
+    const auto& source = model.mesh;
+    const auto triangles = std::span(source.triangles).subspan(g.first_triangle, g.triangle_count);
+    const auto smooth_triangles = std::span(source.smooth_triangles).subspan(g.first_smooth_triangle, g.smooth_triangle_count);
+    std::vector<uint32_t> vertices;
+    std::vector<uint32_t> normals;
+    for (const auto& t : triangles) {
+        vertices.insert(vertices.end(), t.v.begin(), t.v.end());
+    }
+    for (const auto& t : smooth_triangles) {
+        vertices.insert(vertices.end(), t.v.begin(), t.v.end());
+        normals.insert(normals.end(), t.n.begin(), t.n.end());
+    }
+    const auto sort_unique = [](std::vector<uint32_t>& v) {
+        std::ranges::sort(v);
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    };
+    sort_unique(vertices);
+    sort_unique(normals);
+    const auto remap = [](const std::vector<uint32_t>& used, std::array<uint32_t, 3> corners) noexcept{
+        for (auto& c : corners) {
+            c = narrow_cast<uint32_t>(std::ranges::lower_bound(used, c) - used.begin());
+        }
+        return corners;
+    };
+
+    MeshData m;
+    m.vertices.reserve(vertices.size());
+    for (const auto v : vertices) {
+        m.vertices.push_back(source.vertices[v]);
+    }
+    m.normals.reserve(normals.size());
+    for (const auto n : normals) {
+        m.normals.push_back(source.normals[n]);
+    }
+    m.triangles.reserve(triangles.size());
+    for (const auto& t : triangles) {
+        m.triangles.push_back(Triangle{ remap(vertices, t.v) });
+    }
+    m.smooth_triangles.reserve(smooth_triangles.size());
+    for (const auto& t : smooth_triangles) {
+        m.smooth_triangles.push_back(SmoothTriangle{ remap(vertices, t.v), remap(normals, t.n) });
+    }
+    return m;
+}
+
+/*Adds the model to a scene graph as a group under parent, with a Mesh child for every group of the
+ file that has faces. The meshes have no material of their own, so they wear the group's.
+ Returns the group's node.*/
+NodeId add_obj(SceneGraph& graph, NodeId parent, const ObjModel& model, const Matrix4& transform = Matrix4Identity, MaterialId material = DEFAULT_MATERIAL_ID) {
+    const auto node = graph.add_group(parent, transform, material);
+    for (size_t g = 0; g < model.groups.size(); ++g) {
+        if (model.groups[g].size() > 0) {
+            graph.add_shape(node, mesh(graph.add_mesh(build_mesh(group_mesh(model, g)))));
+        }
+    }
+    return node;
+}
@@ -3,6 +3,7 @@
 #include "Tuple.h"
 #include "Color.h"
 #include "Matrix.h"
+#include "Affine.h"
 //// uv stuff
 struct AlignCheck final{
     Color main;
@@ -86,27 +87,27 @@ struct NullPattern final{
     constexpr Color at([[maybe_unused]] const Point& p) const noexcept{ return MAGENTA; }
     explicit constexpr operator bool() const noexcept{ return false; }
     constexpr bool operator==(const NullPattern& that) const noexcept = default;
-    constexpr const Matrix4& get_transform() const noexcept{ return _transform; }
-    constexpr const Matrix4& inv_transform() const noexcept{ return _invTransform; }
-    constexpr void set_transform(Matrix4 mat) noexcept{ _transform = mat; }
+    constexpr const Affine& get_transform() const noexcept{ return _transform; }
+    constexpr const Affine& inv_transform() const noexcept{ return _invTransform; }
+    constexpr void set_transform(Matrix4 mat) noexcept{ _transform = affine(mat); }
 private:
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
 };
 
 struct TestPattern final{
     constexpr Color at([[maybe_unused]] const Point& p) const noexcept{ return color(p.x, p.y, p.z); }
     explicit constexpr operator bool() const noexcept{ return true; }
     constexpr bool operator==(const TestPattern& that) const noexcept = default;
-    constexpr const Matrix4& get_transform() const noexcept{ return _transform; }
-    constexpr const Matrix4& inv_transform() const noexcept{ return _invTransform; }
+    constexpr const Affine& get_transform() const noexcept{ return _transform; }
+    constexpr const Affine& inv_transform() const noexcept{ return _invTransform; }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
     }
 private:
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
 };
 
 struct StripePattern final{
@@ -117,20 +118,20 @@ struct StripePattern final{
         return (math::int_floor(p.x) % 2 == 0) ? a : b;
     }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
     explicit constexpr operator bool() const noexcept{ return true; }
     constexpr bool operator==(const StripePattern& that) const noexcept = default;
 private:
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
     Color a{};
     Color b{};
 };
@@ -144,20 +145,20 @@ struct GradientPattern final{
         return lerp(a, b, dx);
     }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
     explicit constexpr operator bool() const noexcept{ return true; }
     constexpr bool operator==(const GradientPattern& that) const noexcept = default;
 private:
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
     Color a{};
     Color b{};
 };
@@ -171,20 +172,20 @@ struct RadialGradientPattern final{
         return lerp(a, b, fraction);
     }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
     explicit constexpr operator bool() const noexcept{ return true; }
     constexpr bool operator==(const RadialGradientPattern& that) const noexcept = default;
 private:
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
     Color a{};
     Color b{};
 };
@@ -193,7 +194,7 @@ struct RingPattern final{
         set_transform(std::move(mat));
     }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
     }
     constexpr Color at(const Point& p) const noexcept{
@@ -201,17 +202,17 @@ struct RingPattern final{
         const auto mod = math::int_floor(distance_from_center) % 2;
         return mod == 0 ? a : b;
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
     explicit constexpr operator bool() const noexcept{ return true; }
     constexpr bool operator==(const RingPattern& that) const noexcept = default;
 private:
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
     Color a{};
     Color b{};
 };
@@ -224,20 +225,20 @@ struct CheckersPattern final{
         return (val % 2 == 0) ? a : b;
     }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
     explicit constexpr operator bool() const noexcept{ return true; }
     constexpr bool operator==(const CheckersPattern& that) const noexcept = default;
 private:
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
     Color a{};
     Color b{};
 };
@@ -267,13 +268,13 @@ struct TextureMap final{
         return uv_pattern.at(texCoords);
     }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
     explicit constexpr operator bool() const noexcept{ return true; }
@@ -286,8 +287,8 @@ struct TextureMap final{
             "Pattern"-structure */
     }
 private:
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
     Texture uv_pattern;
     Callable uv_map;
 };
@@ -331,13 +332,13 @@ struct CubeMap final{
         return uv_pattern_at(faces[i], uvCoords);
     }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
     explicit constexpr operator bool() const noexcept{ return true; }
@@ -345,8 +346,8 @@ struct CubeMap final{
         return true;
     }
 private:
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
     Faces faces;
 };
 
@@ -409,13 +410,13 @@ constexpr void set_transform(Patterns& variant, const Matrix4& newTransform) noe
         return pattern.set_transform(newTransform);
         }, variant);
 };
-constexpr const Matrix4& get_transform(const Patterns& variant) noexcept{
-    return std::visit([](const auto& pattern) noexcept -> const Matrix4&{
+constexpr const Affine& get_transform(const Patterns& variant) noexcept{
+    return std::visit([](const auto& pattern) noexcept -> const Affine&{
         return pattern.get_transform();
         }, variant);
 };
-constexpr const Matrix4& get_inverse_transform(const Patterns& variant) noexcept{
-    return std::visit([](const auto& pattern) noexcept -> const Matrix4&{
+constexpr const Affine& get_inverse_transform(const Patterns& variant) noexcept{
+    return std::visit([](const auto& pattern) noexcept -> const Affine&{
         return pattern.inv_transform();
         }, variant);
 };
@@ -19,6 +19,15 @@ constexpr Ray ray(Point p, Vector dir) noexcept {
 }
 
 constexpr Ray operator*(const Matrix4& m, const Ray& r) noexcept {    
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) { //transpose the matrix once, for both the origin and the direction
+        const auto columns = simd::load_columns(m);
+        Ray result;
+        simd::store(&result.origin.x, simd::transform_point(columns, simd::load(&r.origin.x)));
+        simd::store(&result.direction.x, simd::transform_vector(columns, simd::load(&r.direction.x)));
+        return result;
+    }
+#endif
     return Ray{ m * r.origin, m * r.direction };
 }
 
@@ -27,7 +36,7 @@ constexpr Ray operator*(const Ray& r, const Matrix4& m) noexcept {
 }
 
 constexpr Point position(const Ray& r, Real time) noexcept {    
-    return r.origin + r.direction * time;
+    return madd(r.direction, time, r.origin); //origin + direction * time
 }
 
 constexpr Ray transform(const Ray& r, const Matrix4& m) noexcept {    
@@ -0,0 +1,178 @@
+#pragma once
+#include "pch.h"
+#include <span>
+#include <vector>
+#include "Affine.h"
+#include "AABB.h"
+#include "Material.h"
+#include "Shapes.h"
+
+/*
+ * A scene graph: shapes in groups, groups in other groups, each with a transform relative to its parent.
+ *
+ * The nodes live in one array and refer to their parent by index (a NodeId), never by pointer, so a
+ * SceneGraph copies and moves like any vector of values, and threads can share a const one freely.
+ * A node is always added after its parent, so a single pass in array order computes every world
+ * transform, parents first. The world transform is cached per node, and so are the world bounds: a
+ * group's cover everything below it, so a query can skip a whole subtree with one box test (see the
+ * SceneGraph queries in Intersection.h). A group links its children by index, first_child to next_sibling.
+ *
+ * The renderers don't walk the hierarchy. Every shape node owns a copy of its shape with the world
+ * transform baked in, and with the material of the nearest group above it if it has none of its own.
+ * shapes() hands those to a World (see World::add_scene). To animate, change transforms with set_transform,
+ * call update() and hand the shapes over again with World::replace_scene. update() only recomputes from the
+ * first changed node on.
+ */
+using NodeId = uint32_t;
+static constexpr NodeId ROOT_NODE = 0; //every graph starts with an identity group, the root of the rest
+static constexpr NodeId NO_NODE = std::numeric_limits<NodeId>::max();
+static constexpr uint32_t NO_SHAPE = std::numeric_limits<uint32_t>::max();
+
+struct SceneNode final {
+    Affine transform{ AffineIdentity }; //relative to the parent
+    Affine world_transform{ AffineIdentity }; //cached: the parent's world transform * transform
+    Affine world_inverse{ AffineIdentity }; //cached: the inverse of world_transform
+    NodeId parent = NO_NODE;
+    MaterialId material = DEFAULT_MATERIAL_ID; //the node's own, or DEFAULT_MATERIAL_ID for none
+    MaterialId world_material = DEFAULT_MATERIAL_ID; //cached: material, or else the nearest one above it
+    uint32_t shape = NO_SHAPE; //the index of the node's shape in shapes(), or NO_SHAPE for a group
+    AABB world_bounds{}; //cached: of the node's shape, or of everything below a group. empty for an empty group
+    NodeId first_child = NO_NODE; //the latest child of a group
+    NodeId next_sibling = NO_NODE; //the child of the same parent added before this one
+
+    constexpr bool is_group() const noexcept {
+        return shape == NO_SHAPE;
+    }
+};
+static_assert(std::is_trivially_copyable_v<SceneNode>);
+
+class SceneGraph final {
+public:
+    SceneGraph() : _nodes(1) {} //ROOT_NODE
+
+    NodeId add_group(NodeId parent, const Matrix4& transform = Matrix4Identity, MaterialId material = DEFAULT_MATERIAL_ID) {
+        assert(parent < size() && "SceneGraph::add_group: no such parent");
+        assert(_nodes[parent].is_group() && "SceneGraph::add_group: shapes can't have children");
+        return add(SceneNode{ .transform = affine(transform), .parent = parent, .material = material });
+    }
+    //the shape's own transform and material are taken as its node's.
+    NodeId add_shape(NodeId parent, Shapes shape) {
+        assert(parent < size() && "SceneGraph::add_shape: no such parent");
+        assert(_nodes[parent].is_group() && "SceneGraph::add_shape: shapes can't have children");
+        const auto node = SceneNode{ .transform = get_transform(shape), .parent = parent, .material = ::material_id(shape), .shape = narrow_cast<uint32_t>(_shapes.size()) };
+        _shapes.push_back(std::move(shape));
+        return add(node);
+    }
+
+    //keeps the mesh alive as long as the graph, and the Worlds its shapes are added to, for the Mesh shapes that place it.
+    MeshRef add_mesh(MeshRef m) {
+        _meshes.push_back(std::move(m));
+        return _meshes.back();
+    }
+    constexpr std::span<const MeshRef> meshes() const noexcept {
+        return _meshes;
+    }
+
+    constexpr void set_transform(NodeId id, const Matrix4& transform) noexcept {
+        assert(id < size() && "SceneGraph::set_transform: no such node");
+        _nodes[id].transform = affine(transform);
+        _dirty = std::min(_dirty, size_t{ id });
+    }
+    constexpr void set_material(NodeId id, MaterialId material) noexcept {
+        assert(id < size() && "SceneGraph::set_material: no such node");
+        _nodes[id].material = material;
+        _dirty = std::min(_dirty, size_t{ id });
+    }
+    //recomputes the world transforms, materials and shapes of every node changed since the last update, and of the nodes
+    //below them. Then the bounds of every group, since a change anywhere below a group can move its bounds.
+    constexpr void update() noexcept {
+        if (is_current()) {
+            return;
+        }
+        for (; _dirty < size(); ++_dirty) {
+            refresh(_dirty);
+        }
+        refresh_bounds();
+    }
+    constexpr bool is_current() const noexcept {
+        return _dirty == size();
+    }
+
+    constexpr size_t size() const noexcept {
+        return _nodes.size();
+    }
+    constexpr const SceneNode& operator[](NodeId id) const noexcept {
+        assert(id < size() && "SceneGraph::operator[id] id is out of bounds");
+        return _nodes[id];
+    }
+    //every shape in the graph in world space, in the order they were added.
+    constexpr std::span<const Shapes> shapes() const noexcept {
+        assert(is_current() && "SceneGraph::shapes: call update() after changing the graph");
+        return _shapes;
+    }
+    constexpr const Shapes& shape(NodeId id) const noexcept {
+        assert(!(*this)[id].is_group() && "SceneGraph::shape: the node is a group");
+        return shapes()[_nodes[id].shape];
+    }
+    //a world space point in the space of a node: a group's, or a shape's object space.
+    constexpr Point world_to_object(NodeId id, const Point& p) const noexcept {
+        assert(is_current() && "SceneGraph::world_to_object: call update() after changing the graph");
+        return (*this)[id].world_inverse * p;
+    }
+    //a normal in the space of a node, in world space.
+    constexpr Vector normal_to_world(NodeId id, const Vector& normal) const noexcept {
+        assert(is_current() && "SceneGraph::normal_to_world: call update() after changing the graph");
+        return normalize(normal_matrix((*this)[id].world_inverse) * normal);
+    }
+
+private:
+    NodeId add(const SceneNode& node) {
+        const auto id = narrow_cast<NodeId>(_nodes.size());
+        const auto was_current = is_current();
+        _nodes.push_back(node);
+        auto& parent = _nodes[node.parent];
+        _nodes[id].next_sibling = std::exchange(parent.first_child, id);
+        if (was_current) { //the parent is up to date, so the new node can be too, and only the groups above it grow
+            refresh(id);
+            _dirty = size();
+            for (auto p = node.parent; p != NO_NODE; p = _nodes[p].parent) {
+                grow(_nodes[p].world_bounds, _nodes[id].world_bounds);
+            }
+        }
+        return id;
+    }
+    constexpr void refresh(size_t i) noexcept {
+        auto& node = _nodes[i];
+        if (node.parent == NO_NODE) {
+            node.world_transform = node.transform;
+            node.world_material = node.material;
+        } else {
+            const auto& parent = _nodes[node.parent];
+            node.world_transform = parent.world_transform * node.transform;
+            node.world_material = node.material != DEFAULT_MATERIAL_ID ? node.material : parent.world_material;
+        }
+        node.world_inverse = inverse(node.world_transform);
+        if (!node.is_group()) {
+            auto& s = _shapes[node.shape];
+            ::set_transform(s, to_matrix4(node.world_transform));
+            ::set_material(s, node.world_material);
+            node.world_bounds = bounds_of(s);
+        }
+    }
+    //children come after their parents, so a pass from the back has every child done before it grows its parent.
+    constexpr void refresh_bounds() noexcept {
+        for (auto& node : _nodes) {
+            if (node.is_group()) {
+                node.world_bounds = AABB{};
+            }
+        }
+        for (auto i = size() - 1; i > ROOT_NODE; --i) {
+            grow(_nodes[_nodes[i].parent].world_bounds, _nodes[i].world_bounds);
+        }
+    }
+
+    std::vector<SceneNode> _nodes;
+    std::vector<Shapes> _shapes; //one per shape node, in world space
+    std::vector<MeshRef> _meshes; //the data of the graph's meshes
+    size_t _dirty = 1; //the first node whose cached values are out of date. the root starts out current.
+};
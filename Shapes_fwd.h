@@ -6,33 +6,21 @@
 #include "Cube.h"
 #include "Cylinder.h"
 #include "Cone.h"
+#include "Mesh.h"
 
 /*
  * About this header:
  *
- * We split the shape system into a small forward header to break a circular
- * dependency introduced by the design choice to model all shapes as concrete
- * value types inside a std::variant, while also allowing Group to behave as a
- * shape and to contain other shapes.
+ * Shapes is the variant of the concrete shape types, and is_shape is the concept that matches them.
+ * It used to be split out to break a circular dependency: Group was a shape that contained shapes,
+ * and every shape kept a pointer to its parent Group, so Group was forward declared here and stored
+ * by pointer in the variant.
  *
- * In other words:
- *   - Group must be usable anywhere a Shape is.
- *   - Shapes must be able to contain Groups (for parent/child relationships).
- *
- * This creates a recursive type relationship that cannot be represented unless
- * we forward-declare Group here and only store it as a pointer inside the
- * variant.
- *
- * A cleaner architecture (and one I would use if starting over) is to store all
- * concrete shapes inside a World, and let Groups contain lightweight handles
- * (IDs) into that world. That avoids the need for forward declarations and keeps
- * ownership and hierarchy cleanly separated.
+ * Groups are gone from the variant. Hierarchy now lives in a SceneGraph (SceneGraph.h): nodes in one
+ * array that refer to each other by index, which hands the World plain shapes with the groups'
+ * transforms baked in. The shapes know nothing about groups, and a Shapes is a plain value again.
  */
 
-struct Group;
-
-using Shapes = std::variant<Sphere, Plane, Cube, Cylinder, Cone, Group*>;
+using Shapes = std::variant<Sphere, Plane, Cube, Cylinder, Cone, Mesh>;
 template<typename T>
-concept is_shape = std::is_same_v<Sphere, T> || std::is_same_v<Plane, T> || std::is_same_v<Cube, T> || std::is_same_v<Cylinder, T> || std::is_same_v<Cone, T>;
-
-inline constexpr void set_parent(Shapes& variant, Group* g) noexcept;
\ No newline at end of file
+concept is_shape = std::is_same_v<Sphere, T> || std::is_same_v<Plane, T> || std::is_same_v<Cube, T> || std::is_same_v<Cylinder, T> || std::is_same_v<Cone, T> || std::is_same_v<Mesh, T>;
@@ -0,0 +1,66 @@
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <utility>
+
+/*A reference counted handle to a T on the heap, for the large data many shapes share, like meshes.
+A handle is one pointer. Copies share the T, and the last one to go frees it, so the data lives exactly as long
+as the shapes (and the World) that use it. An empty handle stands for a default T, which every empty handle
+shares: default constructed shapes allocate nothing, and empty handles are constexpr to create, copy and destroy.
+The count is atomic, so handles may be copied and dropped from several threads. The T is not locked: only
+write() it while no other thread reads it.*/
+template<class T>
+class SharedRef final {
+public:
+    using value_type = T;
+
+    constexpr SharedRef() noexcept = default;
+    explicit SharedRef(T value) : _node(new Node{ std::move(value) }) {}
+    constexpr SharedRef(const SharedRef& that) noexcept : _node(that._node) {
+        if (_node) {
+            _node->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    constexpr SharedRef(SharedRef&& that) noexcept : _node(std::exchange(that._node, nullptr)) {}
+    constexpr SharedRef& operator=(SharedRef that) noexcept {
+        std::swap(_node, that._node);
+        return *this;
+    }
+    constexpr ~SharedRef() {
+        if (_node && _node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete _node;
+        }
+    }
+
+    constexpr const T& operator*() const noexcept {
+        return _node ? _node->value : EMPTY;
+    }
+    constexpr const T* operator->() const noexcept {
+        return &**this;
+    }
+    //the T to edit. A T shared with other handles (or the empty default) is copied first, so the edit stays with this handle.
+    T& write() {
+        if (!_node || _node->refs.load(std::memory_order_acquire) != 1) {
+            *this = SharedRef(**this);
+        }
+        return _node->value;
+    }
+    //false for the empty handle.
+    constexpr explicit operator bool() const noexcept {
+        return _node != nullptr;
+    }
+    //the number of handles sharing the T, or 0 for the empty handle.
+    uint32_t use_count() const noexcept {
+        return _node ? _node->refs.load(std::memory_order_relaxed) : 0;
+    }
+    //true when both handles share the same T. Handles to equal, separately allocated Ts are not the same.
+    constexpr bool operator==(const SharedRef& that) const noexcept = default;
+
+private:
+    struct Node final {
+        T value;
+        std::atomic<uint32_t> refs{ 1 };
+    };
+    static inline const T EMPTY{};
+    Node* _node = nullptr;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include "pch.h"
+/*
+ * 4-wide SSE kernels for the 3-component types (Point, Vector, Color).
+ *
+ * With RTC_SIMD on, those types are padded to 16 bytes and 16-byte aligned, so each one is a
+ * single aligned load. The padding lane is always 0 and every kernel keeps it that way.
+ * The kernels do the same operations in the same order as the scalar code (no FMA; the project
+ * builds with a strict floating point model), so both paths give bit-identical results.
+ * Constant evaluation always takes the scalar path, which keeps the math constexpr.
+ * With RTC_AVX2 there are 8 lane versions of the basic arithmetic too, for kernels that work across shapes.
+ */
+#if RTC_SIMD
+#include <immintrin.h>
+
+namespace simd {
+    using f32x4 = __m128;
+
+    inline f32x4 load(const Real* xyzw) noexcept {
+        return _mm_load_ps(xyzw);
+    }
+    inline void store(Real* xyzw, f32x4 v) noexcept {
+        _mm_store_ps(xyzw, v);
+    }
+    inline f32x4 splat(Real s) noexcept {
+        return _mm_set1_ps(s);
+    }
+    inline f32x4 add(f32x4 a, f32x4 b) noexcept {
+        return _mm_add_ps(a, b);
+    }
+    inline f32x4 sub(f32x4 a, f32x4 b) noexcept {
+        return _mm_sub_ps(a, b);
+    }
+    inline f32x4 mul(f32x4 a, f32x4 b) noexcept {
+        return _mm_mul_ps(a, b);
+    }
+    //a * b + c, rounded twice like the scalar code.
+    inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) noexcept {
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+    }
+    //(x*x' + y*y') + z*z', the scalar summation order. The padding lane is left out.
+    inline Real dot3(f32x4 a, f32x4 b) noexcept {
+        return _mm_cvtss_f32(_mm_dp_ps(a, b, 0x71));
+    }
+    inline f32x4 cross3(f32x4 a, f32x4 b) noexcept {
+        const auto a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        const auto b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        const auto c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+        return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+    //the length of a 3 component vector, or 0. sqrt is correctly rounded on both paths.
+    inline Real length3(f32x4 v) noexcept {
+        return _mm_cvtss_f32(_mm_sqrt_ss(_mm_dp_ps(v, v, 0x71)));
+    }
+    //the smallest lane, broadcast to every lane.
+    inline f32x4 min_lane(f32x4 v) noexcept {
+        const auto m = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+
+#if RTC_AVX2
+    //8 lanes of the same, for kernels that work on 8 independent values at a time.
+    using f32x8 = __m256;
+
+    inline f32x8 splat8(Real s) noexcept {
+        return _mm256_set1_ps(s);
+    }
+    inline f32x8 add(f32x8 a, f32x8 b) noexcept {
+        return _mm256_add_ps(a, b);
+    }
+    inline f32x8 sub(f32x8 a, f32x8 b) noexcept {
+        return _mm256_sub_ps(a, b);
+    }
+    inline f32x8 mul(f32x8 a, f32x8 b) noexcept {
+        return _mm256_mul_ps(a, b);
+    }
+    inline f32x8 madd(f32x8 a, f32x8 b, f32x8 c) noexcept {
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+    }
+    //the smallest lane, broadcast to every lane.
+    inline f32x8 min_lane(f32x8 v) noexcept {
+        auto m = _mm256_min_ps(v, _mm256_permute2f128_ps(v, v, 1));
+        m = _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+#endif
+}
+#endif
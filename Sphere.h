@@ -2,72 +2,63 @@
 #include "pch.h"
 #include "Tuple.h"
 #include "Matrix.h"
+#include "Affine.h"
 #include "Material.h"
 #include "Ray.h"
-struct Group;
+#include "AABB.h"
+#include "InlineVector.h"
 
 /*A unit Sphere, always positioned at 0, 0, 0 and with a radius of 1.0f*/
 struct Sphere final{
     constexpr Sphere() noexcept = default;
-    explicit constexpr Sphere(Material m) noexcept : _surface(std::move(m)){}
+    explicit constexpr Sphere(MaterialId m) noexcept : _material(m){}
     explicit constexpr Sphere(Matrix4 transf) noexcept{
         set_transform(std::move(transf));
     }
-    constexpr Sphere(Material m, Matrix4 transf) noexcept : _surface(std::move(m)){
+    constexpr Sphere(MaterialId m, Matrix4 transf) noexcept : _material(m){
         set_transform(std::move(transf));
     }
     constexpr auto operator==(const Sphere& that) const noexcept{
-        return _surface == that._surface && _transform == that._transform;
+        return _material == that._material && _transform == that._transform;
     }
-    constexpr const Matrix4& get_transform() const noexcept{
+    constexpr const Affine& get_transform() const noexcept{
         return _transform;
     }
-    constexpr const Matrix4& inv_transform() const noexcept{
+    constexpr const Affine& inv_transform() const noexcept{
         return _invTransform;
     }
+    constexpr const Matrix3& normal_transform() const noexcept{
+        return _normalTransform;
+    }
     constexpr void set_transform(Matrix4 mat) noexcept{
-        _transform = std::move(mat);
+        _transform = affine(mat);
         _invTransform = inverse(_transform);
+        _normalTransform = normal_matrix(_invTransform);
     }
-    constexpr const Material& surface() const noexcept{
-        return _surface;
-    }
-    constexpr const Color& color() const noexcept{
-        return surface().color;
-    }
-    constexpr Material& surface() noexcept{
-        return _surface;
-    }
-    constexpr Color& color() noexcept{
-        return surface().color;
+    constexpr MaterialId material_id() const noexcept{
+        return _material;
     }
-    constexpr void set_parent(Group* g) noexcept{
-        _parent = g;
-    }
-    constexpr Group* get_parent() const noexcept{
-        return _parent;
+    constexpr void set_material(MaterialId m) noexcept{
+        _material = m;
     }
 private:
-    Material _surface{material()};
-    Matrix4 _transform{Matrix4Identity};
-    Matrix4 _invTransform{Matrix4Identity};
-    Group* _parent = nullptr;
+    MaterialId _material = DEFAULT_MATERIAL_ID;
+    Affine _transform{AffineIdentity};
+    Affine _invTransform{AffineIdentity};
+    Matrix3 _normalTransform{Matrix3Identity};
 };
 
 constexpr Sphere sphere() noexcept{
     return Sphere{};
 }
-constexpr Sphere sphere(Color col) noexcept{
-    return Sphere(material(col));
-}
-constexpr Sphere sphere(Material m) noexcept{
-    return Sphere(std::move(m));
+constexpr Sphere sphere(MaterialId m) noexcept{
+    return Sphere(m);
 }
 constexpr Sphere sphere(Matrix4 transform) noexcept{
     return Sphere(std::move(transform));
 }
-constexpr Sphere sphere(Material m, Matrix4 transform) noexcept{
-    return Sphere(std::move(m), std::move(transform));
+constexpr Sphere sphere(MaterialId m, Matrix4 transform) noexcept{
+    return Sphere(m, std::move(transform));
 }
 
 #pragma warning(push)
@@ -82,8 +73,13 @@ constexpr Vector local_normal_at([[maybe_unused]] const Sphere& s, const Point&
     return normalize(vector(object_space_point)); /*imagine object_space_point - s.position, but s position is always 0*/
 }
 
+//object space bounds: the unit sphere
+constexpr AABB local_bounds([[maybe_unused]] const Sphere& s) noexcept{
+    return aabb(point(-1, -1, -1), point(1, 1, 1));
+}
+
 //https://www.scratchapixel.com/lessons/3d-basic-rendering/minimal-ray-tracer-rendering-simple-shapes/ray-sphere-intersection.html
-constexpr auto local_intersect([[maybe_unused]] const Sphere& s, const Ray& local_ray){
+constexpr LocalHits local_intersect([[maybe_unused]] const Sphere& s, const Ray& local_ray) noexcept{
     using math::square, math::sqrt;
     constexpr Real SPHERE_RADIUS = 1.0f; //unit sphere, always at 0, 0, 0 and radius 1. 
     const auto  a = 2 * (square(local_ray.dx()) + square(local_ray.dy()) + square(local_ray.dz()));
@@ -97,5 +93,5 @@ constexpr auto local_intersect([[maybe_unused]] const Sphere& s, const Ray& loca
     const auto sqrtDet = sqrt(discriminant) / a;
     const auto t1 = x1 - sqrtDet;
     const auto t2 = x1 + sqrtDet;
-    return std::vector{t1, t2};
+    return LocalHits{t1, t2};
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <cassert>
 #include <ranges>
 #include <span>
 #include <stdexcept>
@@ -93,6 +94,24 @@ template<typename Number>
     return value;
 }
 
+/*Splits text into chunks of roughly chunk_size for parallel parsing. Every chunk but the first starts
+ right after a newline, so a parser that works line by line can take each chunk on its own.
+ Text without line breaks simply ends up in fewer, longer chunks.
+ Returns the chunk start offsets, followed by text.size().*/
+std::vector<size_t> line_chunk_starts(std::string_view text, size_t chunk_size) {
+    assert(chunk_size > 0 && "line_chunk_starts: chunk_size must be non-zero");
+    std::vector<size_t> starts{ 0 };
+    for (auto guess = chunk_size; guess < text.size(); guess = starts.back() + chunk_size) {
+        const auto line_end = text.find('\n', guess);
+        if (line_end == std::string_view::npos || line_end + 1 >= text.size()) {
+            break;
+        }
+        starts.push_back(line_end + 1);
+    }
+    starts.push_back(text.size());
+    return starts;
+}
+
 constexpr std::string_view get_line(std::string_view sv, size_t n, std::string_view line_ending = "\n"sv) noexcept {
     size_t line_start = 0;
     size_t line_end = 0;
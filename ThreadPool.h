@@ -0,0 +1,158 @@
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*
+ * A persistent pool of worker threads, sized at runtime to the machine (or explicitly).
+ *
+ * Workers are started once and sleep between jobs, so a parallel_for costs a wake-up instead of
+ * thread creation. Jobs are not wrapped in std::function: parallel_for publishes a pointer to the
+ * caller's callable and a matching trampoline, and blocks until every chunk is done, which keeps
+ * the callable alive for as long as any worker may touch it.
+ *
+ * The calling thread works on the job too. One job runs at a time; a parallel_for issued from
+ * inside a job (nested parallelism) runs inline on the thread that issued it instead of deadlocking.
+ */
+class ThreadPool final {
+public:
+    using size_type = size_t;
+
+    static size_type default_thread_count() noexcept {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    //the process-wide pool shared by the renderers and the image encoders.
+    static ThreadPool& shared() {
+        static ThreadPool pool(RUN_SEQUENTIAL ? 1 : default_thread_count());
+        return pool;
+    }
+
+    //thread_count includes the calling thread, so a pool of 1 starts no workers and runs everything inline.
+    explicit ThreadPool(size_type thread_count = default_thread_count()) {
+        assert(thread_count > 0 && "ThreadPool needs at least one thread");
+        _workers.reserve(thread_count - 1);
+        for (size_type i = 1; i < thread_count; ++i) {
+            _workers.emplace_back([this]() noexcept { work(); });
+        }
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool() {
+        {
+            std::scoped_lock lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    size_type thread_count() const noexcept {
+        return _workers.size() + 1;
+    }
+
+    /*Calls process(begin, end) for consecutive ranges covering [0, count), each at most grain items long.
+     Ranges are handed out dynamically, so uneven work balances out as long as there are a few
+     ranges per thread. Returns once every range has been processed. process must not throw.*/
+    template<class Callable>
+    void parallel_for(size_type count, size_type grain, Callable&& process) {
+        grain = std::max(grain, size_type{ 1 });
+        if (count == 0) {
+            return;
+        }
+        if (_workers.empty() || count <= grain || _inside_job) {
+            for (size_type begin = 0; begin < count; begin += grain) {
+                std::invoke(process, begin, std::min(begin + grain, count));
+            }
+            return;
+        }
+        using F = std::remove_reference_t<Callable>;
+        std::scoped_lock one_job_at_a_time(_submit);
+        const Job job{
+            const_cast<void*>(static_cast<const void*>(std::addressof(process))),
+            [](void* context, size_type begin, size_type end) noexcept {
+                std::invoke(*static_cast<F*>(context), begin, end);
+            },
+            count, grain
+        };
+        {
+            std::unique_lock lock(_mutex);
+            //a worker that overslept the previous job may still hold it, and would pick chunks from the reset counter.
+            _done.wait(lock, [this]() noexcept { return _busy == 0; });
+            _job = job;
+            _next.store(0, std::memory_order_relaxed);
+            ++_generation;
+        }
+        _wake.notify_all();
+        _inside_job = true;
+        run(job);
+        _inside_job = false;
+        std::unique_lock lock(_mutex);
+        _done.wait(lock, [this]() noexcept { return _busy == 0; });
+    }
+
+private:
+    struct Job final {
+        void* context = nullptr;
+        void (*invoke)(void*, size_type, size_type) noexcept = nullptr;
+        size_type count = 0;
+        size_type grain = 1;
+    };
+
+    void run(const Job& job) noexcept {
+        for (;;) {
+            const auto begin = _next.fetch_add(job.grain, std::memory_order_relaxed);
+            if (begin >= job.count) {
+                return;
+            }
+            job.invoke(job.context, begin, std::min(begin + job.grain, job.count));
+        }
+    }
+
+    void work() noexcept {
+        _inside_job = true;
+        uint64_t seen = 0;
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock lock(_mutex);
+                _wake.wait(lock, [this, seen]() noexcept { return _stop || _generation != seen; });
+                if (_stop) {
+                    return;
+                }
+                seen = _generation;
+                job = _job;
+                ++_busy; //taken under the same lock as the job, so the caller can't return (and free the callable) while we hold it
+            }
+            run(job);
+            {
+                std::scoped_lock lock(_mutex);
+                if (--_busy == 0) {
+                    _done.notify_all();
+                }
+            }
+        }
+    }
+
+    std::vector<std::thread> _workers;
+    std::mutex _submit;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    Job _job;
+    uint64_t _generation = 0;
+    size_type _busy = 0;
+    bool _stop = false;
+    std::atomic<size_type> _next{ 0 };
+    static inline thread_local bool _inside_job = false; //true on workers, and on a caller while it helps out with its job
+};
+
+//parallel_for on the shared pool.
+template<class Callable>
+void parallel_for(size_t count, size_t grain, Callable&& process) {
+    ThreadPool::shared().parallel_for(count, grain, std::forward<Callable>(process));
+}
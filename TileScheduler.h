@@ -0,0 +1,193 @@
+#pragma once
+#include "pch.h"
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include "ThreadPool.h"
+
+/*
+ * Splits an image into square tiles and renders them on the thread pool with work stealing.
+ *
+ * Each thread starts with its own deque holding a contiguous run of tiles (neighbouring tiles
+ * tend to cost about the same and touch the same parts of the scene). A thread works through
+ * its own deque front to back and, once it runs dry, steals from the back of the others. Threads
+ * that drew sky finish their share quickly and then help out with the glass and mirrors, instead
+ * of idling while one thread grinds through the expensive part of the frame.
+ */
+
+static constexpr size_t RENDER_TILE_SIZE = 16; //pixels along each side of a render tile
+
+struct Tile final {
+    size_t x = 0; //top left corner, in pixels
+    size_t y = 0;
+    size_t width = 0; //tiles along the right and bottom edge of the image may be cut short
+    size_t height = 0;
+    constexpr bool operator==(const Tile& that) const noexcept = default;
+};
+
+struct Pixel final {
+    size_t x = 0;
+    size_t y = 0;
+    constexpr bool operator==(const Pixel& that) const noexcept = default;
+};
+
+/*Walks the pixels of a tile in scanline order: left to right, top to bottom.
+ The renderers iterate through this instead of turning flat indices back into x and y,
+ so there is no width/height mixup to get wrong.*/
+class PixelIterator final {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Pixel;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Pixel*;
+    using reference = Pixel;
+
+    constexpr PixelIterator() noexcept = default;
+    constexpr PixelIterator(const Tile& tile, Pixel start) noexcept : _tile(tile), _pixel(start) {}
+
+    constexpr Pixel operator*() const noexcept { return _pixel; }
+    constexpr PixelIterator& operator++() noexcept {
+        if (++_pixel.x == _tile.x + _tile.width) {
+            _pixel.x = _tile.x;
+            ++_pixel.y;
+        }
+        return *this;
+    }
+    constexpr PixelIterator operator++(int) noexcept {
+        auto old = *this;
+        ++*this;
+        return old;
+    }
+    constexpr bool operator==(const PixelIterator& that) const noexcept { return _pixel == that._pixel; }
+private:
+    Tile _tile;
+    Pixel _pixel;
+};
+
+struct PixelRange final {
+    Tile tile;
+    constexpr PixelIterator begin() const noexcept {
+        return tile.width && tile.height ? PixelIterator(tile, Pixel{ tile.x, tile.y }) : end();
+    }
+    constexpr PixelIterator end() const noexcept {
+        return PixelIterator(tile, Pixel{ tile.x, tile.y + tile.height });
+    }
+    constexpr size_t size() const noexcept { return tile.width * tile.height; }
+};
+
+constexpr PixelRange pixels(const Tile& tile) noexcept {
+    return PixelRange{ tile };
+}
+//the whole image as a single tile.
+constexpr Tile image_tile(size_t image_width, size_t image_height) noexcept {
+    return Tile{ 0, 0, image_width, image_height };
+}
+//one row of the image as a tile.
+constexpr Tile scanline(size_t y, size_t image_width) noexcept {
+    return Tile{ 0, y, image_width, 1 };
+}
+
+struct TileGrid final {
+    size_t image_width = 0;
+    size_t image_height = 0;
+    size_t tile_size = RENDER_TILE_SIZE;
+
+    constexpr size_t columns() const noexcept { return (image_width + tile_size - 1) / tile_size; }
+    constexpr size_t rows() const noexcept { return (image_height + tile_size - 1) / tile_size; }
+    constexpr size_t size() const noexcept { return columns() * rows(); }
+
+    //tiles are numbered in scanline order.
+    constexpr Tile operator[](size_t i) const noexcept {
+        assert(i < size() && "TileGrid::operator[i] index is out of bounds");
+        const auto x = index_to_column(i, columns()) * tile_size;
+        const auto y = index_to_row(i, columns()) * tile_size;
+        return Tile{ x, y, std::min(tile_size, image_width - x), std::min(tile_size, image_height - y) };
+    }
+};
+
+constexpr TileGrid tile_grid(size_t image_width, size_t image_height, size_t tile_size = RENDER_TILE_SIZE) noexcept {
+    assert(tile_size > 0 && "tile_grid: tile_size must be non-zero");
+    return TileGrid{ image_width, image_height, tile_size };
+}
+
+//a double ended queue where the owning thread takes work from the front and other threads steal from the back.
+//tiles are coarse (hundreds of pixels each), so a plain lock per deque costs nothing measurable.
+template<class T>
+class WorkStealingDeque final {
+public:
+    void push_back(T item) {
+        std::scoped_lock lock(_mutex);
+        _items.push_back(std::move(item));
+    }
+    //for the owner
+    std::optional<T> pop_front() {
+        std::scoped_lock lock(_mutex);
+        if (_items.empty()) {
+            return std::nullopt;
+        }
+        auto item = std::move(_items.front());
+        _items.pop_front();
+        return item;
+    }
+    //for everyone else
+    std::optional<T> steal() {
+        std::scoped_lock lock(_mutex);
+        if (_items.empty()) {
+            return std::nullopt;
+        }
+        auto item = std::move(_items.back());
+        _items.pop_back();
+        return item;
+    }
+    size_t size() const {
+        std::scoped_lock lock(_mutex);
+        return _items.size();
+    }
+private:
+    mutable std::mutex _mutex;
+    std::deque<T> _items;
+};
+
+/*Calls process(tile) once for every tile of the grid, spread over the pool's threads.
+ process must be safe to call concurrently for different tiles, and must not throw.*/
+template<class Callable>
+void for_each_tile(ThreadPool& pool, const TileGrid& grid, Callable&& process) {
+    const auto tile_count = grid.size();
+    const auto slots = std::min(pool.thread_count(), tile_count);
+    if (slots == 0) {
+        return;
+    }
+    std::vector<WorkStealingDeque<size_t>> queues(slots);
+    for (size_t slot = 0; slot < slots; ++slot) { //deal out contiguous runs of tiles
+        const auto begin = tile_count * slot / slots;
+        const auto end = tile_count * (slot + 1) / slots;
+        for (auto i = begin; i < end; ++i) {
+            queues[slot].push_back(i);
+        }
+    }
+    const auto steal = [&queues, slots](size_t thief) -> std::optional<size_t> {
+        for (size_t offset = 1; offset < slots; ++offset) {
+            if (auto tile = queues[(thief + offset) % slots].steal()) {
+                return tile;
+            }
+        }
+        return std::nullopt;
+    };
+    pool.parallel_for(slots, 1, [&queues, &steal, &grid, &process](size_t begin, size_t end) noexcept {
+        for (auto slot = begin; slot < end; ++slot) {
+            while (auto tile = queues[slot].pop_front()) {
+                std::invoke(process, grid[*tile]);
+            }
+            while (auto tile = steal(slot)) {
+                std::invoke(process, grid[*tile]);
+            }
+        }
+    });
+}
+
+//for_each_tile on the shared pool.
+template<class Callable>
+void for_each_tile(const TileGrid& grid, Callable&& process) {
+    for_each_tile(ThreadPool::shared(), grid, std::forward<Callable>(process));
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "pch.h"
+#include <array>
+#include <bit>
+#include <vector>
+#include "Affine.h"
+#include "Ray.h"
+
+/*
+ * The inverse transforms of a run of shapes as a structure of arrays: 12 parallel arrays, one per matrix
+ * element, so a kernel can load the same element of several shapes at once. CompiledScene keeps one per
+ * type of shape. A World keeps the spheres of the small nodes of its BVH in one, 8 to a node, for
+ * nearest_sphere_hit8 (see World::build).
+ */
+
+//the inverse transforms of some shapes, and the index of each shape in the World.
+struct TransformArrays final {
+    static constexpr size_t ELEMENTS = Affine::ROWS * Affine::COLUMNS;
+    std::array<std::vector<Real>, ELEMENTS> inv;
+    std::vector<uint32_t> object;
+
+    constexpr void push_back(const Affine& inv_transform, size_t object_index) {
+        for (size_t e = 0; e < ELEMENTS; ++e) {
+            inv[e].push_back(inv_transform[narrow_cast<uint8_t>(e)]);
+        }
+        object.push_back(narrow_cast<uint32_t>(object_index));
+    }
+    constexpr size_t size() const noexcept { return object.size(); }
+    constexpr bool empty() const noexcept { return object.empty(); }
+};
+
+namespace Detail {
+    static constexpr Real NO_HIT = math::MAX;
+
+#if RTC_AVX2
+    struct NearestLane final {
+        Real t = NO_HIT;
+        size_t lane = 0;
+    };
+
+    /*One ray against 8 unit spheres at once: spheres first to first + 7 of the arrays, inverse transforms
+     included. Returns the nearest t >= t_min and which of the 8 it belongs to (the lowest lane on a tie,
+     like the scalar loop), or NO_HIT. Lane for lane the same arithmetic as local_intersect(Sphere).*/
+    inline NearestLane nearest_sphere_hit8(const TransformArrays& spheres, size_t first, const Ray& r, Real t_min) noexcept {
+        using namespace simd;
+        assert(first + 8 <= spheres.size() && "nearest_sphere_hit8: needs 8 spheres");
+        const auto m = [&spheres, first](size_t e) noexcept { return _mm256_loadu_ps(spheres.inv[e].data() + first); };
+        const auto ox = splat8(r.x()), oy = splat8(r.y()), oz = splat8(r.z());
+        const auto odx = splat8(r.dx()), ody = splat8(r.dy()), odz = splat8(r.dz());
+        const auto x = add(madd(oz, m(2), madd(oy, m(1), mul(ox, m(0)))), m(3));
+        const auto y = add(madd(oz, m(6), madd(oy, m(5), mul(ox, m(4)))), m(7));
+        const auto z = add(madd(oz, m(10), madd(oy, m(9), mul(ox, m(8)))), m(11));
+        const auto dx = madd(odz, m(2), madd(ody, m(1), mul(odx, m(0))));
+        const auto dy = madd(odz, m(6), madd(ody, m(5), mul(odx, m(4))));
+        const auto dz = madd(odz, m(10), madd(ody, m(9), mul(odx, m(8))));
+
+        const auto zero = _mm256_setzero_ps();
+        const auto two = splat8(2.0f);
+        const auto a = mul(two, add(add(mul(dx, dx), mul(dy, dy)), mul(dz, dz)));
+        const auto b = mul(two, add(add(mul(dx, x), mul(dy, y)), mul(dz, z)));
+        const auto c = sub(add(add(mul(x, x), mul(y, y)), mul(z, z)), splat8(1.0f));
+        const auto discriminant = sub(mul(b, b), mul(mul(two, a), c));
+        const auto x1 = _mm256_div_ps(_mm256_xor_ps(b, splat8(-0.0f)), a);
+        const auto sqrt_det = _mm256_div_ps(_mm256_sqrt_ps(_mm256_max_ps(discriminant, zero)), a);
+        const auto t1 = sub(x1, sqrt_det);
+        const auto t2 = add(x1, sqrt_det);
+        const auto tm = splat8(t_min);
+        const auto no_hit = splat8(NO_HIT);
+        auto t = _mm256_blendv_ps(no_hit, t2, _mm256_cmp_ps(t2, tm, _CMP_GE_OQ));
+        t = _mm256_blendv_ps(t, t1, _mm256_cmp_ps(t1, tm, _CMP_GE_OQ));
+        t = _mm256_blendv_ps(t, no_hit, _mm256_cmp_ps(discriminant, zero, _CMP_LT_OQ));
+
+        const auto nearest = min_lane(t);
+        const auto lanes = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(t, nearest, _CMP_EQ_OQ)));
+        return NearestLane{ _mm256_cvtss_f32(nearest), static_cast<size_t>(std::countr_zero(lanes)) };
+    }
+#endif
+}
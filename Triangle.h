@@ -0,0 +1,78 @@
+#pragma once
+#include "pch.h"
+#include <array>
+#include "Tuple.h"
+#include "Ray.h"
+#include "AABB.h"
+
+/*
+ * Triangles, the faces of a Mesh (see Mesh.h).
+ *
+ * A triangle doesn't hold its points. It holds three indices into the vertex buffer of the mesh it
+ * belongs to, so a vertex shared by six faces is stored once. A Triangle is flat: its normal is the
+ * normal of its plane. A SmoothTriangle also indexes the mesh's normal buffer, one normal per corner,
+ * and its normal is interpolated across the face from the hit's u and v.
+ */
+struct Triangle final {
+    std::array<uint32_t, 3> v{}; //p1, p2, p3
+    constexpr bool operator==(const Triangle& that) const noexcept = default;
+};
+
+struct SmoothTriangle final {
+    std::array<uint32_t, 3> v{}; //p1, p2, p3
+    std::array<uint32_t, 3> n{}; //n1, n2, n3: the normals at p1, p2, p3
+    constexpr bool operator==(const SmoothTriangle& that) const noexcept = default;
+};
+
+//where a ray crosses a triangle: t along the ray, and u and v, the weights of p2 and p3 (p1's is 1 - u - v).
+struct TriangleHit final {
+    Real t = math::MAX;
+    Real u = 0.0f;
+    Real v = 0.0f;
+    explicit constexpr operator bool() const noexcept {
+        return t != math::MAX;
+    }
+};
+static constexpr TriangleHit TRIANGLE_MISS{};
+
+/*Moller-Trumbore: solves for t, u and v directly, without the triangle's plane.
+ https://www.scratchapixel.com/lessons/3d-basic-rendering/ray-tracing-rendering-a-triangle/moller-trumbore-ray-triangle-intersection.html */
+constexpr TriangleHit intersect_triangle(const Point& p1, const Point& p2, const Point& p3, const Ray& r) noexcept {
+    const auto e1 = p2 - p1;
+    const auto e2 = p3 - p1;
+    const auto dir_cross_e2 = cross(r.direction, e2);
+    const auto det = dot(e1, dir_cross_e2);
+    if (det == 0.0f) { //the ray is parallel to the triangle. an epsilon here would also miss every triangle of a small, finely tesselated mesh.
+        return TRIANGLE_MISS;
+    }
+    const auto f = 1.0f / det;
+    const auto p1_to_origin = r.origin - p1;
+    const auto u = f * dot(p1_to_origin, dir_cross_e2);
+    if (u < 0.0f || u > 1.0f) {
+        return TRIANGLE_MISS;
+    }
+    const auto origin_cross_e1 = cross(p1_to_origin, e1);
+    const auto v = f * dot(r.direction, origin_cross_e1);
+    if (v < 0.0f || (u + v) > 1.0f) {
+        return TRIANGLE_MISS;
+    }
+    return TriangleHit{ f * dot(e2, origin_cross_e1), u, v };
+}
+
+//the normal of the triangle's plane, facing the side from which p1, p2, p3 wind clockwise.
+constexpr Vector triangle_normal(const Point& p1, const Point& p2, const Point& p3) noexcept {
+    return normalize(cross(p3 - p1, p2 - p1));
+}
+
+//n1, n2 and n3 blended at the hit: u of n2, v of n3 and the rest of n1. Not normalized.
+constexpr Vector interpolate_normal(const Vector& n1, const Vector& n2, const Vector& n3, Real u, Real v) noexcept {
+    return n2 * u + n3 * v + n1 * (1.0f - u - v);
+}
+
+constexpr AABB triangle_bounds(const Point& p1, const Point& p2, const Point& p3) noexcept {
+    AABB box;
+    grow(box, p1);
+    grow(box, p2);
+    grow(box, p3);
+    return box;
+}
@@ -1,17 +1,25 @@
 #pragma once
 #include "pch.h"
 #include "Math.h"
+#include "Simd.h"
 
-struct Point final {
+struct alignas(TUPLE_ALIGNMENT) Point final {
     Real x{};
     Real y{};
     Real z{};
+#if RTC_SIMD
+    Real padding{}; //the 4th SIMD lane. always 0.
+#endif
 };
-struct Vector final {
+struct alignas(TUPLE_ALIGNMENT) Vector final {
     Real x{};
     Real y{};
     Real z{};
+#if RTC_SIMD
+    Real padding{};
+#endif
 };
+static_assert(!USE_SIMD || (sizeof(Point) == 16 && sizeof(Vector) == 16));
 struct UVCoords final {
     Real u{};
     Real v{};
@@ -86,6 +94,11 @@ constexpr Real magnitudeSq(const Vector& t) noexcept {
     return ((t.x * t.x) + (t.y * t.y) + (t.z * t.z));
 }
 constexpr Real magnitude(const Vector& t) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        return simd::length3(simd::load(&t.x));
+    }
+#endif
     //std::hypot(t.x, t.y, t.z); 
     return math::sqrt((t.x * t.x) + (t.y * t.y) + (t.z * t.z));
 }
@@ -95,6 +108,13 @@ constexpr Vector normalize(const Vector& t) noexcept {
         return t;
     }
     const auto inv_length = 1.0f / length;
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Vector result;
+        simd::store(&result.x, simd::mul(simd::load(&t.x), simd::splat(inv_length)));
+        return result;
+    }
+#endif
     return t * inv_length;
 }
 constexpr Vector normalize(const Vector& t, const Vector& fallback) noexcept {
@@ -103,6 +123,13 @@ constexpr Vector normalize(const Vector& t, const Vector& fallback) noexcept {
         return fallback;
     }
     const auto inv_length = 1.0f / length;
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Vector result;
+        simd::store(&result.x, simd::mul(simd::load(&t.x), simd::splat(inv_length)));
+        return result;
+    }
+#endif
     return t * inv_length;
 }
 constexpr bool is_normalized(const Vector& v, Real tolerance = math::BRAZZY_EPSILON) noexcept {
@@ -117,14 +144,38 @@ constexpr bool is_zero(const Vector& v, Real tolerance = math::BRAZZY_EPSILON) n
 constexpr Real dot(const Vector& a, const Vector& b) noexcept {
     /* the smaller the dot product, the larger the angle between the vector. if the two
     vectors are unit vectors, the dot product is the cosine of the angle between them */
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        return simd::dot3(simd::load(&a.x), simd::load(&b.x));
+    }
+#endif
     return a.x * b.x + a.y * b.y + a.z * b.z;
 }
 constexpr Vector cross(const Vector& a, const Vector& b) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Vector result;
+        simd::store(&result.x, simd::cross3(simd::load(&a.x), simd::load(&b.x)));
+        return result;
+    }
+#endif
     return vector(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
 }
 
+//v * scale + offset
+constexpr Vector madd(const Vector& v, Real scale, const Vector& offset) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Vector result;
+        simd::store(&result.x, simd::madd(simd::load(&v.x), simd::splat(scale), simd::load(&offset.x)));
+        return result;
+    }
+#endif
+    return Vector{ v.x * scale + offset.x, v.y * scale + offset.y, v.z * scale + offset.z };
+}
+
 constexpr Vector reflect(const Vector& v, const Vector& normal) noexcept {
-    return v - normal * 2 * dot(v, normal);
+    return madd(normal, -2 * dot(v, normal), v); //v - normal * 2 * dot(v, normal)
 }
 
 constexpr Vector hadamard_product(const Vector& lhs, const Vector& rhs) noexcept {
@@ -160,6 +211,17 @@ constexpr void operator+=(Point& lhs, const Vector& rhs) noexcept {
     lhs.y += rhs.y;
     lhs.z += rhs.z;
 };
+//p + v * scale
+constexpr Point madd(const Vector& v, Real scale, const Point& p) noexcept {
+#if RTC_SIMD
+    if (!std::is_constant_evaluated()) {
+        Point result;
+        simd::store(&result.x, simd::madd(simd::load(&v.x), simd::splat(scale), simd::load(&p.x)));
+        return result;
+    }
+#endif
+    return Point{ v.x * scale + p.x, v.y * scale + p.y, v.z * scale + p.z };
+}
 constexpr Vector operator-(const Point& lhs, const Point& rhs)  noexcept {
     return Vector{ lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z };
 }
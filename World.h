@@ -3,7 +3,26 @@
 #include "Matrix.h"
 #include "Lights.h"
 #include "Shapes.h"
+#include "BVH.h"
 #include "Material.h"
+#include "Instance.h"
+#include "SceneGraph.h"
+#include "TransformArrays.h"
+
+//the objects of a World that World::add_scene added a scene graph's shapes as.
+struct SceneRange final {
+    size_t first = 0;
+    size_t count = 0;
+};
+
+/*A node of the World's BVH with at most 8 objects below it, 2 or more of them spheres. The spheres of
+ batch b are lanes 8 * b to 8 * b + 7 of World::sphere_lanes().*/
+struct SphereBatch final {
+    static constexpr size_t SIZE = 8; //the lanes of nearest_sphere_hit8
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    uint32_t first = 0; //the objects below the node: bvh().indices[first] to [first + count - 1]
+    uint32_t count = 0;
+};
 
 struct World final {
     static constexpr auto DEFAULT_MATERIAL = material(color(0.8f, 1.0f, 0.6f), 0.1f, 0.7f, 0.2f);   
@@ -18,71 +37,236 @@ struct World final {
     using const_iterator = container::const_iterator;
     using size_type = container::size_type;
     
-    container objects;    
-    Light light = DEFAULT_LIGHT;    
-    
-    constexpr World() {                                      
-        objects.emplace_back(sphere(DEFAULT_MATERIAL));
-        objects.emplace_back(sphere(scaling(0.5f, 0.5f, 0.5f)));        
+    Light light = DEFAULT_LIGHT;
+
+    World() {
+        _objects.emplace_back(sphere(add_material(DEFAULT_MATERIAL)));
+        _objects.emplace_back(sphere(scaling(0.5f, 0.5f, 0.5f)));
+        build();
     }
-    explicit constexpr World(Light l) : World() {                
+    explicit World(Light l) : World() {
         light = std::move(l);
     }
-    explicit constexpr World(std::initializer_list<value_type> list) {        
-        objects.append_range(list);        
+    explicit constexpr World(std::initializer_list<value_type> list) {
+        _objects.insert(_objects.end(), list.begin(), list.end());
+        build();
     }
-    explicit constexpr World(std::initializer_list<value_type> list, Light l) : World(list) {        
+    explicit constexpr World(std::initializer_list<value_type> list, Light l) : World(list) {
         light = std::move(l);
     }
-    constexpr void push_back(std::initializer_list<value_type> list) {        
-        objects.append_range(list);        
+
+    /*Everything that adds, moves or reshapes objects or instances only marks the World as changed. Queries
+     on a changed World test every object (see Intersection.h); build() brings the BVHs up to date, once,
+     after a batch of changes. The renderers build a copy when they're handed a changed World.*/
+    constexpr void push_back(std::initializer_list<value_type> list) {
+        _objects.insert(_objects.end(), list.begin(), list.end());
+        _built = false;
+    }
+    constexpr void push_back(value_type shape) {
+        _objects.push_back(std::move(shape));
+        _built = false;
+    }
+    //adds copies of the world space shapes of a scene graph, and returns where they went for replace_scene.
+    SceneRange add_scene(const SceneGraph& scene) {
+        const auto shapes = scene.shapes();
+        const auto range = SceneRange{ _objects.size(), shapes.size() };
+        _objects.insert(_objects.end(), shapes.begin(), shapes.end());
+        _meshes.insert(_meshes.end(), scene.meshes().begin(), scene.meshes().end());
+        _built = false;
+        return range;
+    }
+    /*overwrites the objects add_scene added for a graph with its shapes as they are now: after set_transform or
+     set_material and update() on the graph, to animate it. The graph must have as many shapes as it had then.*/
+    constexpr void replace_scene(SceneRange range, const SceneGraph& scene) noexcept {
+        const auto shapes = scene.shapes();
+        assert(range.first + range.count <= size() && "World::replace_scene: the range is out of bounds");
+        assert(shapes.size() == range.count && "World::replace_scene: the graph has a different number of shapes");
+        std::ranges::copy(shapes, _objects.begin() + static_cast<std::ptrdiff_t>(range.first));
+        _built = false;
+    }
+    //keeps the mesh alive as long as the World and its copies, for the Mesh shapes that place it.
+    MeshRef add_mesh(MeshRef m) {
+        _meshes.push_back(std::move(m));
+        return _meshes.back();
+    }
+    AssetId add_asset(std::vector<Shapes> shapes) {
+        _assets.push_back(asset(std::move(shapes)));
+        return narrow_cast<AssetId>(_assets.size() - 1);
+    }
+    constexpr void add_instance(const Instance& i) {
+        add_instances(std::span(&i, 1));
+    }
+    constexpr void add_instances(std::span<const Instance> list) {
+        assert(std::ranges::all_of(list, [this](const Instance& i) noexcept { return i.asset < _assets.size(); }) && "World::add_instances: no such asset");
+        _instances.insert(_instances.end(), list.begin(), list.end());
+        _built = false;
+    }
+    //rebuilds the BVH over the objects and the top level BVH over the instances, if anything changed since the last build.
+    constexpr void build() {
+        if (_built) {
+            return;
+        }
+        _bvh = build_bvh(_objects);
+        std::vector<AABB> boxes;
+        boxes.reserve(_instances.size());
+        for (const auto& i : _instances) {
+            boxes.push_back(bounds_of(i, _assets[i.asset]));
+        }
+        _instance_bvh = build_bvh(boxes);
+#if RTC_AVX2
+        batch_spheres();
+#endif
+        _built = true;
+    }
+    constexpr bool is_built() const noexcept {
+        return _built;
     }
-    constexpr void push_back(value_type shape) {        
-        objects.push_back(std::move(shape));
+    constexpr std::span<const value_type> objects() const noexcept {
+        return _objects;
+    }
+    constexpr const BVH& bvh() const noexcept {
+        return _bvh;
+    }
+    constexpr std::span<const Asset> assets() const noexcept { //geometry shared by the instances
+        return _assets;
+    }
+    constexpr std::span<const Instance> instances() const noexcept {
+        return _instances;
+    }
+    constexpr const BVH& instance_bvh() const noexcept { //the top level hierarchy, over the world bounds of the instances
+        return _instance_bvh;
+    }
+    //the spheres of the small nodes of the BVH, to test 8 at a time. build() only makes them with AVX2.
+    constexpr const TransformArrays& sphere_lanes() const noexcept {
+        return _sphere_lanes;
+    }
+    constexpr std::span<const SphereBatch> sphere_batches() const noexcept {
+        return _sphere_batches;
+    }
+    //the batch of a node of the BVH, or SphereBatch::NONE.
+    constexpr uint32_t sphere_batch_of(size_t node) const noexcept {
+        return node < _node_batches.size() ? _node_batches[node] : SphereBatch::NONE;
+    }
+    /*The material table. Shapes, instances and scene graphs refer to materials by the id add_material
+     returned, and every table starts with material() at DEFAULT_MATERIAL_ID.*/
+    MaterialId add_material(Material m) {
+        _materials.push_back(std::move(m));
+        return narrow_cast<MaterialId>(_materials.size() - 1);
+    }
+    constexpr std::span<const Material> materials() const noexcept {
+        return _materials;
+    }
+    constexpr const Material& material_at(MaterialId id) const noexcept {
+        assert(id < _materials.size() && "World::material_at(id) id is out of bounds");
+        return _materials[id];
+    }
+    //a material, to edit. Every shape that refers to it changes with it. Materials don't change bounds, so this leaves the World built.
+    constexpr Material& edit_material(MaterialId id) noexcept {
+        assert(id < _materials.size() && "World::edit_material(id) id is out of bounds");
+        return _materials[id];
     }
     constexpr bool contains(const value_type& object) const noexcept {               
-        return std::ranges::find(objects, object) != objects.end();        
+        return std::ranges::find(_objects, object) != _objects.end();        
     }   
     constexpr const_reference operator[](size_type i) const noexcept {
         assert(i < size() && "World::operator[i] index is out of bounds");
-        return objects[i];
+        return _objects[i];
     }
+    //mutable access to the objects may move them, so it marks the World as changed.
     constexpr reference operator[](size_type i) noexcept {
         assert(i < size() && "World::operator[i] index is out of bounds");
-        return objects[i];
+        _built = false;
+        return _objects[i];
     }  
     explicit constexpr operator bool() const noexcept {
         return !empty();
     }
-    constexpr pointer data() noexcept { return objects.data(); }
-    constexpr const_pointer data() const noexcept { return objects.data(); }
-    constexpr size_type size() const noexcept { return objects.size(); }
+    constexpr pointer data() noexcept { _built = false; return _objects.data(); }
+    constexpr const_pointer data() const noexcept { return _objects.data(); }
+    constexpr size_type size() const noexcept { return _objects.size(); }
     constexpr size_type count() const noexcept { return size(); }
-    constexpr bool empty() const noexcept { return objects.empty(); }
-    constexpr iterator begin() noexcept { return objects.begin(); }
-    constexpr iterator end() noexcept { return objects.end(); }
-    constexpr const_iterator begin() const noexcept { return objects.begin(); }
-    constexpr const_iterator end() const noexcept { return objects.end(); }
+    constexpr bool empty() const noexcept { return _objects.empty(); }
+    constexpr iterator begin() noexcept { _built = false; return _objects.begin(); }
+    constexpr iterator end() noexcept { _built = false; return _objects.end(); }
+    constexpr const_iterator begin() const noexcept { return _objects.begin(); }
+    constexpr const_iterator end() const noexcept { return _objects.end(); }
     constexpr const_reference back() const noexcept {
         assert(!empty() && "World::back() on empty world is undefined behavior!");
-        return objects[size()-1];
+        return _objects[size()-1];
     }
     constexpr reference back() noexcept {
         assert(!empty() && "World::back() on empty world is undefined behavior!");
-        return objects[size()-1];
+        _built = false;
+        return _objects[size()-1];
     }  
+private:
+    constexpr void batch_spheres() {
+        _sphere_lanes = TransformArrays{};
+        _sphere_batches.clear();
+        _node_batches.assign(_bvh.nodes.size(), SphereBatch::NONE);
+        if (!_bvh.nodes.empty()) {
+            batch_spheres(0);
+        }
+    }
+    //batches the spheres below node n if it's a leaf or the parent of two leaves, or looks further down.
+    constexpr void batch_spheres(BVH::size_type n) {
+        static_assert(2 * BVH::MAX_LEAF_SIZE <= SphereBatch::SIZE, "World: the objects of a parent of two leaves must fit in a batch");
+        const auto& node = _bvh.nodes[n];
+        if (!node.is_leaf() && !(_bvh.nodes[node.first].is_leaf() && _bvh.nodes[node.first + 1].is_leaf())) {
+            batch_spheres(node.first);
+            batch_spheres(node.first + 1);
+            return;
+        }
+        const auto& left = node.is_leaf() ? node : _bvh.nodes[node.first];
+        const auto count = node.is_leaf() ? node.count : left.count + _bvh.nodes[node.first + 1].count;
+        assert((node.is_leaf() || left.first + left.count == _bvh.nodes[node.first + 1].first) && "World::batch_spheres: sibling leaves should be next to each other");
+        std::array<uint32_t, SphereBatch::SIZE> spheres{};
+        size_t found = 0;
+        for (auto i = left.first; i < left.first + count; ++i) {
+            if (std::holds_alternative<Sphere>(_objects[_bvh.indices[i]])) {
+                spheres[found++] = _bvh.indices[i];
+            }
+        }
+        if (found < 2) {
+            return;
+        }
+        std::sort(spheres.begin(), spheres.begin() + static_cast<std::ptrdiff_t>(found)); //the lowest lane wins a tie, so they go in World order
+        for (size_t lane = 0; lane < SphereBatch::SIZE; ++lane) {
+            const auto i = spheres[std::min(lane, found - 1)]; //a short batch repeats its last sphere
+            _sphere_lanes.push_back(std::get<Sphere>(_objects[i]).inv_transform(), i);
+        }
+        _node_batches[n] = narrow_cast<uint32_t>(_sphere_batches.size());
+        _sphere_batches.push_back(SphereBatch{ left.first, count });
+    }
+
+    container _objects;
+    std::vector<Material> _materials{ material() }; //DEFAULT_MATERIAL_ID
+    std::vector<MeshRef> _meshes; //the data of the Mesh shapes added through add_mesh or add_scene
+    BVH _bvh;
+    std::vector<Asset> _assets;
+    std::vector<Instance> _instances;
+    BVH _instance_bvh;
+    TransformArrays _sphere_lanes;
+    std::vector<SphereBatch> _sphere_batches;
+    std::vector<uint32_t> _node_batches; //per node of _bvh
+    bool _built = false;
 };
 
-constexpr Material& get_material(World& w, size_t i) noexcept{    
-    return ::surface(w[i]);
-    //return std::visit([](auto& obj) noexcept -> Material& {return obj.surface();  }, w[i]);
+//w, or a built copy of w if it changed since its last build().
+inline World built(World w) {
+    w.build();
+    return w;
+}
+
+//the material of object i, to edit. Every object that shares it changes with it.
+constexpr Material& get_material(World& w, size_t i) noexcept {    
+    return w.edit_material(material_id(std::as_const(w)[i]));
 }
 constexpr const Material& get_material(const World& w, size_t i) noexcept{   
-    return ::surface(w[i]);
-    //return std::visit([](const auto& obj) noexcept -> const Material& {return obj.surface();  }, w[i]);
+    return w.material_at(material_id(w[i]));
 }
 
-constexpr const Matrix4& get_transform(const World& w, size_t i) noexcept{   
+constexpr const Affine& get_transform(const World& w, size_t i) noexcept{   
     return ::get_transform(w[i]);
     //return std::visit([](const auto& obj) noexcept -> const Matrix4& {return obj.get_transform();  }, w[i]);
 }
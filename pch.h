@@ -30,13 +30,32 @@
 using namespace std::string_view_literals;
 using Real = float;
 //static constexpr auto T_MISS = std::numeric_limits<Real>::max(); //magic value to denote an invalid t for intersections
-static const std::vector<Real> MISS = {};// std::pair<Real, Real>(T_MISS, T_MISS);
 static constexpr auto PPM_VERSION = "P3"sv;
+static constexpr auto PPM_BINARY_VERSION = "P6"sv;
 static constexpr auto PPM_COMMENT = "#"sv;
 static constexpr uint16_t PPM_MAX_LINE_LENGTH = 70;
 static constexpr uint16_t PPM_MAX_BYTE_VALUE = 255; //max value of color components in PPM file. 
 static constexpr bool RUN_SEQUENTIAL = false;
-static constexpr unsigned SUGGESTED_THREAD_COUNT = 8; //only applicable is RUN_SEQUENTIAL = false. 
+
+//SIMD kernels for Point, Vector and Color (see Simd.h). On whenever the compiler targets SSE4.1 or better
+//(the project builds with /arch:AVX2). Define RTC_SIMD as 0 to force the scalar code.
+#ifndef RTC_SIMD
+    #if defined(__AVX__) || defined(__SSE4_1__)
+        #define RTC_SIMD 1
+    #else
+        #define RTC_SIMD 0
+    #endif
+#endif
+static constexpr bool USE_SIMD = RTC_SIMD;
+//the 8 wide kernels (see CompiledScene.h) also need AVX2.
+#ifndef RTC_AVX2
+    #if RTC_SIMD && defined(__AVX2__)
+        #define RTC_AVX2 1
+    #else
+        #define RTC_AVX2 0
+    #endif
+#endif
+static constexpr size_t TUPLE_ALIGNMENT = USE_SIMD ? 16 : alignof(Real);
 
 [[nodiscard]] bool empty(auto begin, auto end) noexcept {
   return std::distance(begin, end) == 0;
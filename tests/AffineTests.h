@@ -0,0 +1,89 @@
+#pragma once
+#include "../pch.h"
+#include "../Affine.h"
+#include "../Shapes.h"
+#include "TestHelpers.h"
+#include <random>
+
+DISABLE_WARNINGS_FROM_GTEST
+
+TEST(Affine, isTheTopThreeRowsOfAMatrix4) {
+    const auto m = translation(1, 2, 3) * scaling(4, 5, 6);
+    const auto a = affine(m);
+    static_assert(sizeof(Affine) == 12 * sizeof(Real));
+    for (uint8_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i], m[i]);
+    }
+    EXPECT_EQ(to_matrix4(a), m);
+    EXPECT_EQ(to_matrix4(AffineIdentity), Matrix4Identity);
+}
+
+TEST(Affine, transformsLikeTheEquivalentMatrix4) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<Real> coord(-50.0f, 50.0f);
+    for (int i = 0; i < 1000; ++i) {
+        const auto m = random_transform(rng);
+        const auto a = affine(m);
+        const auto p = point(coord(rng), coord(rng), coord(rng));
+        const auto v = vector(coord(rng), coord(rng), coord(rng));
+        const auto ap = a * p;
+        const auto mp = m * p;
+        ASSERT_EQ(ap.x, mp.x); //the same operations in the same order
+        ASSERT_EQ(ap.y, mp.y);
+        ASSERT_EQ(ap.z, mp.z);
+        ASSERT_EQ(a * v, m * v);
+        const auto r = transform(ray(p, v), a);
+        ASSERT_EQ(r.origin, mp);
+        ASSERT_EQ(r.direction, m * v);
+    }
+}
+
+TEST(Affine, composesLikeMatrix4) {
+    std::mt19937 rng(5);
+    for (int i = 0; i < 100; ++i) {
+        const auto m1 = random_transform(rng);
+        const auto m2 = random_transform(rng);
+        ASSERT_EQ(to_matrix4(affine(m1) * affine(m2)), m1 * m2);
+    }
+}
+
+TEST(Affine, inverseUndoesTheTransform) {
+    std::mt19937 rng(9);
+    for (int i = 0; i < 1000; ++i) {
+        const auto m = random_transform(rng);
+        const auto inv = inverse(affine(m));
+        const auto expected = inverse(m);
+        for (uint8_t j = 0; j < inv.size(); ++j) {
+            ASSERT_NEAR(inv[j], expected[j], 1e-5f * std::max(1.0f, math::abs(expected[j])));
+        }
+        ASSERT_EQ(to_matrix4(affine(m) * inv), Matrix4Identity);
+    }
+    static_assert(inverse(affine(translation(1, 2, 3)))[3] == -1.0f);
+}
+
+TEST(Affine, normalMatrixIsTheInverseTranspose) {
+    const auto m = scaling(1, 0.5f, 1) * rotation_z(math::PI / 5);
+    const auto inv = inverse(affine(m));
+    const auto n = vector(0, math::sqrt(2.0f) / 2, -math::sqrt(2.0f) / 2);
+    EXPECT_EQ(normal_matrix(inv) * n, transpose(inverse(m)) * n);
+}
+
+TEST(Affine, shapesCacheTheirNormalMatrix) {
+    const auto m = translation(1, 2, 3) * rotation_y(math::PI / 3) * scaling(2, 1, 0.5f);
+    auto s = sphere(m);
+    EXPECT_EQ(s.normal_transform(), normal_matrix(s.inv_transform()));
+    s.set_transform(Matrix4Identity);
+    EXPECT_EQ(s.normal_transform(), Matrix3Identity);
+    const auto c = cube(m);
+    const auto n = vector(0, 1, 0);
+    EXPECT_EQ(c.normal_transform() * n, transpose(inverse(m)) * n);
+}
+
+TEST(Affine, shapesStoreAffineTransforms) {
+    auto s = sphere(translation(2, 3, 4));
+    EXPECT_EQ(s.get_transform(), affine(translation(2, 3, 4)));
+    EXPECT_EQ(s.inv_transform(), affine(translation(-2, -3, -4)));
+    static_assert(sizeof(Affine) < sizeof(Matrix4));
+}
+
+RESTORE_WARNINGS
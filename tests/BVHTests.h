@@ -0,0 +1,224 @@
+#pragma once
+#include "../pch.h"
+#include <random>
+#include "../AABB.h"
+#include "../BVH.h"
+#include "../World.h"
+#include "../Intersection.h"
+
+DISABLE_WARNINGS_FROM_GTEST
+
+TEST(AABB, defaultBoxIsEmpty) {
+    auto box = aabb();
+    EXPECT_TRUE(is_empty(box));
+    grow(box, point(1, 2, 3));
+    EXPECT_FALSE(is_empty(box));
+    EXPECT_EQ(box.min, point(1, 2, 3));
+    EXPECT_EQ(box.max, point(1, 2, 3));
+}
+
+TEST(AABB, canBeMerged) {
+    const auto a = aabb(point(-5, -2, 0), point(7, 4, 4));
+    const auto b = aabb(point(8, -7, -2), point(14, 2, 8));
+    const auto box = merge(a, b);
+    EXPECT_EQ(box.min, point(-5, -7, -2));
+    EXPECT_EQ(box.max, point(14, 4, 8));
+}
+
+TEST(AABB, transformingABoundingBox) {
+    const auto box = aabb(point(-1, -1, -1), point(1, 1, 1));
+    const auto m = rotation_x(math::PI / 4) * rotation_y(math::PI / 4);
+    const auto box2 = transform(box, m);
+    EXPECT_EQ(box2.min, point(-1.41421f, -1.70711f, -1.70711f));
+    EXPECT_EQ(box2.max, point(1.41421f, 1.70711f, 1.70711f));
+}
+
+TEST(AABB, intersectingARayWithACubicBoundingBox) {
+    const auto box = aabb(point(5, -2, 0), point(11, 4, 7));
+    const std::vector<std::pair<Ray, bool>> cases{
+        {ray(point(15, 1, 2), normal_vector(-1, 0, 0)), true},
+        {ray(point(-5, -1, 4), normal_vector(1, 0, 0)), true},
+        {ray(point(7, 6, 5), normal_vector(0, -1, 0)), true},
+        {ray(point(9, -5, 6), normal_vector(0, 1, 0)), true},
+        {ray(point(8, 2, 12), normal_vector(0, 0, -1)), true},
+        {ray(point(6, 0, -5), normal_vector(0, 0, 1)), true},
+        {ray(point(8, 1, 3.5f), normal_vector(0, 0, 1)), true},
+        {ray(point(9, -1, -8), normal_vector(2, 4, 6)), false},
+        {ray(point(8, 3, -4), normal_vector(6, 2, 4)), false},
+        {ray(point(9, -1, -2), normal_vector(4, 6, 2)), false},
+        {ray(point(4, 0, 9), normal_vector(0, 0, -1)), false},
+        {ray(point(8, 6, -1), normal_vector(0, -1, 0)), false},
+        {ray(point(12, 5, 4), normal_vector(-1, 0, 0)), false}
+    };
+    for (const auto& [r, expected] : cases) {
+        EXPECT_EQ(intersects(box, r), expected);
+    }
+}
+
+TEST(AABB, boxBehindTheRayIsCulledByTMin) {
+    const auto box = aabb(point(-1, -1, -1), point(1, 1, 1));
+    const auto r = ray(point(0, 0, 5), vector(0, 0, 1));
+    EXPECT_TRUE(intersects(box, r));
+    EXPECT_FALSE(intersects(box, r, 0.0f));
+}
+
+TEST(AABB, boundsOfATransformedShape) {
+    const Shapes s = sphere(translation(1, -3, 5) * scaling(0.5f, 2, 4));
+    const auto b = bounds_of(s);
+    EXPECT_EQ(b.min, point(0.5f, -5, 1));
+    EXPECT_EQ(b.max, point(1.5f, -1, 9));
+}
+
+TEST(AABB, infiniteShapesStayInfiniteWhenTransformed) {
+    const Shapes p = plane(rotation_x(math::PI / 4));
+    EXPECT_TRUE(is_infinite(bounds_of(p)));
+    const Shapes c = cylinder(DEFAULT_MATERIAL_ID, translation(0, 5, 0));
+    EXPECT_TRUE(is_infinite(bounds_of(c)));
+}
+
+TEST(AABB, mergingAnInfiniteBoxIsInfinite) {
+    const auto box = merge(aabb(point(-1, -1, -1), point(1, 1, 1)), infinite_aabb());
+    EXPECT_TRUE(is_infinite(box));
+}
+
+TEST(BVH, unboundedShapesAreKeptOutOfTheTree) {
+    const auto w = World({ plane(), sphere(), cylinder(), cube(translation(3, 0, 0)) });
+    ASSERT_EQ(w.bvh().size(), w.size());
+    EXPECT_EQ(w.bvh().unbounded.size(), 2);
+    EXPECT_EQ(w.bvh().indices.size(), 2);
+}
+
+TEST(BVH, everyBoundedObjectIsReferencedExactlyOnce) {
+    World w({});
+    for (auto i = 0; i < 100; ++i) {
+        w.push_back(sphere(translation(static_cast<Real>(i % 10) * 3.0f, 0, static_cast<Real>(i / 10) * 3.0f)));
+    }
+    w.build();
+    auto indices = w.bvh().indices;
+    std::ranges::sort(indices);
+    ASSERT_EQ(indices.size(), w.size());
+    for (BVH::size_type i = 0; i < indices.size(); ++i) {
+        EXPECT_EQ(indices[i], i);
+    }
+    for (const auto& node : w.bvh().nodes) {
+        if (node.is_leaf()) {
+            EXPECT_LE(node.count, BVH::MAX_LEAF_SIZE);
+        }
+    }
+}
+
+TEST(BVH, traversalVisitsNearestBoxFirst) {
+    const auto w = World({ sphere(translation(0, 0, 30)), sphere(translation(0, 0, 10)), sphere(translation(0, 0, 20)) });
+    std::vector<size_t> order;
+    traverse(w.bvh(), ray(point(0, 0, -5), vector(0, 0, 1)), 0.0f, math::MAX, [&order](size_t i) {
+        order.push_back(i);
+        return math::MAX;
+    });
+    EXPECT_EQ(order, (std::vector<size_t>{ 1, 2, 0 }));
+}
+
+TEST(BVH, intersectMatchesBruteForce) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<Real> pos(-20.0f, 20.0f);
+    std::uniform_real_distribution<Real> size(0.2f, 2.0f);
+    World w({ plane(translation(0, -25, 0)) });
+    for (auto i = 0; i < 200; ++i) {
+        const auto transf = translation(pos(rng), pos(rng), pos(rng)) * scaling(size(rng), size(rng), size(rng));
+        switch (i % 4) {
+        case 0: w.push_back(sphere(transf)); break;
+        case 1: w.push_back(cube(transf)); break;
+        case 2: w.push_back(closed_cylinder(-1.0f, 1.0f, DEFAULT_MATERIAL_ID, transf)); break;
+        default: w.push_back(cone(-1.0f, 0.0f, DEFAULT_MATERIAL_ID, transf)); break;
+        }
+    }
+    for (auto i = 0; i < 500; ++i) {
+        const auto r = ray(point(pos(rng), pos(rng), -30.0f), normalize(vector(pos(rng), pos(rng), 30.0f)));
+        auto expected = intersections(w.size() * 2);
+        for (const auto& object : w) {
+            expected.push_back(intersect(object, r));
+        }
+        expected.sort();
+        const auto xs = intersect(w, r);
+        ASSERT_EQ(xs.size(), expected.size());
+        for (Intersections::size_type j = 0; j < xs.size(); ++j) {
+            EXPECT_EQ(xs[j].t, expected[j].t);
+        }
+        EXPECT_EQ(closest(xs).objPtr, closest(expected).objPtr);
+        EXPECT_EQ(closest_hit(w, r).objPtr, closest(expected).objPtr);
+    }
+}
+
+#if RTC_AVX2
+TEST(BVH, eightSpheresAtOnceMatchOneAtATime) {
+    std::mt19937 rng(80);
+    std::uniform_real_distribution<Real> pos(-10.0f, 10.0f);
+    std::uniform_real_distribution<Real> size(0.5f, 3.0f);
+    std::vector<Shapes> shapes;
+    TransformArrays spheres;
+    for (size_t i = 0; i < 8; ++i) {
+        const auto s = sphere(translation(pos(rng), pos(rng), pos(rng)) * scaling(size(rng), size(rng), size(rng)));
+        shapes.push_back(s);
+        spheres.push_back(s.inv_transform(), i);
+    }
+    auto hits = 0;
+    for (auto i = 0; i < 5000; ++i) {
+        const auto r = ray(point(pos(rng), pos(rng), pos(rng)), normalize(vector(pos(rng), pos(rng), pos(rng))));
+        Detail::NearestLane expected;
+        for (size_t lane = 0; lane < 8; ++lane) {
+            const auto hit = nearest_hit(shapes[lane], r, 0.0f, math::MAX);
+            if (hit && hit.t < expected.t) {
+                expected = Detail::NearestLane{ hit.t, lane };
+            }
+        }
+        const auto [t, lane] = Detail::nearest_sphere_hit8(spheres, 0, r, 0.0f);
+        ASSERT_EQ(t, expected.t);
+        if (t != Detail::NO_HIT) {
+            ASSERT_EQ(lane, expected.lane);
+            ++hits;
+        }
+    }
+    EXPECT_GT(hits, 200); //enough rays hit something for the comparison to mean something
+}
+
+TEST(BVH, closestHitTestsTheSpheresOfSmallNodes8AtATime) {
+    std::mt19937 rng(19);
+    std::uniform_real_distribution<Real> pos(-20.0f, 20.0f);
+    std::uniform_real_distribution<Real> size(0.2f, 2.0f);
+    World w({ plane(translation(0, -25, 0)) });
+    for (auto i = 0; i < 200; ++i) {
+        const auto transf = translation(pos(rng), pos(rng), pos(rng)) * scaling(size(rng), size(rng), size(rng));
+        w.push_back(i % 3 == 0 ? Shapes{ cube(transf) } : Shapes{ sphere(transf) });
+    }
+    w.build();
+    ASSERT_FALSE(w.sphere_batches().empty());
+    for (size_t b = 0; b < w.sphere_batches().size(); ++b) {
+        const auto& batch = w.sphere_batches()[b];
+        const auto below = std::span(w.bvh().indices).subspan(batch.first, batch.count);
+        for (size_t lane = 0; lane < SphereBatch::SIZE; ++lane) {
+            const auto i = w.sphere_lanes().object[b * SphereBatch::SIZE + lane];
+            EXPECT_TRUE(std::holds_alternative<Sphere>(w[i]));
+            EXPECT_NE(std::ranges::find(below, i), below.end()); //only spheres of the node itself
+        }
+    }
+    auto hits = 0;
+    for (auto i = 0; i < 2000; ++i) {
+        const auto r = ray(point(pos(rng), pos(rng), -30.0f), normalize(vector(pos(rng), pos(rng), 30.0f)));
+        const auto expected = nearest_hit(w.objects(), BVH{}, r, 0.0f, math::MAX); //every object, one at a time
+        const auto actual = closest_hit(w, r);
+        ASSERT_EQ(actual.objPtr, expected.objPtr);
+        ASSERT_EQ(actual.t, expected.t);
+        hits += expected ? 1 : 0;
+    }
+    EXPECT_GT(hits, 200);
+}
+
+TEST(BVH, batchedSpheresBreakTiesInWorldOrder) {
+    const auto w = World({ cube(translation(0, 3, 0)), sphere(translation(0, 0, 4)), sphere(translation(0, 0, 4)) });
+    ASSERT_EQ(w.sphere_batches().size(), 1u);
+    const auto hit = closest_hit(w, ray(point(0, 0, -5), vector(0, 0, 1)));
+    EXPECT_EQ(hit.objPtr, &w[1]);
+    EXPECT_FLOAT_EQ(hit.t, 8.0f);
+}
+#endif
+
+RESTORE_WARNINGS
@@ -64,4 +64,98 @@ TEST(Camera, renderWorldWithCamera) {
     EXPECT_EQ(img.get(5, 5), color(0.38054222f, 0.4756778f, 0.28540668f));
 }
 
-RESTORE_WARNINGS
\ No newline at end of file
+TEST(Camera, multiThreadedRenderMatchesSingleThreadedForAllAspectRatios) {
+    auto glass = material();
+    glass.transparency = 0.9f;
+    glass.reflective = 0.9f;
+    glass.refractive_index = 1.5f;
+    auto w = World();
+    w.push_back(plane(translation(0, -1, 0)));
+    w.push_back(sphere(w.add_material(glass), translation(0.5f, 0.5f, -2.0f) * scaling(0.5f, 0.5f, 0.5f)));
+    const auto view = view_transform(point(0, 1.5f, -5), ORIGO, vector(0, 1, 0));
+    const std::vector<std::pair<size_t, size_t>> sizes{ {1, 1}, {16, 16}, {40, 9}, {9, 40}, {33, 17}, {17, 33}, {1, 50}, {50, 1} };
+    for (const auto [width, height] : sizes) {
+        const auto c = Camera(width, height, math::PI / 3.0f, view);
+        const auto expected = render_single_threaded(c, w);
+        const auto actual = render_multi_threaded(c, w);
+        ASSERT_EQ(actual.width(), expected.width());
+        ASSERT_EQ(actual.height(), expected.height());
+        for (size_t i = 0; i < expected.size(); ++i) { //bit-identical, not just within Color's tolerance
+            ASSERT_EQ(actual[i].r, expected[i].r) << width << "x" << height << " at pixel " << i;
+            ASSERT_EQ(actual[i].g, expected[i].g) << width << "x" << height << " at pixel " << i;
+            ASSERT_EQ(actual[i].b, expected[i].b) << width << "x" << height << " at pixel " << i;
+        }
+    }
+}
+
+static void expect_bit_identical(const Canvas& actual, const Canvas& expected) {
+    ASSERT_EQ(actual.width(), expected.width());
+    ASSERT_EQ(actual.height(), expected.height());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(actual[i].r, expected[i].r) << "at pixel " << i;
+        ASSERT_EQ(actual[i].g, expected[i].g) << "at pixel " << i;
+        ASSERT_EQ(actual[i].b, expected[i].b) << "at pixel " << i;
+    }
+}
+
+TEST(Camera, packetRenderMatchesSingleThreadedOnTheChapterScenes) {
+    auto wallSurface = material(color(1, 0.9f, 0.9f));
+    wallSurface.specular = 0;
+    auto glassSurface = material();
+    glassSurface.transparency = 0.9f;
+    glassSurface.reflective = 0.9f;
+    glassSurface.refractive_index = 1.5f;
+    auto mirrorSurface = material(color(0.2f, 0.2f, 0.3f));
+    mirrorSurface.reflective = 0.7f;
+    const auto light = point_light(point(-10, 10, -10), color(1, 1, 1));
+    constexpr MaterialId wall = 1, glass = 2, mirror = 3; //every scene adds the three materials, in this order
+    const auto scene = [&](std::initializer_list<Shapes> shapes) {
+        auto w = World(shapes, light);
+        EXPECT_EQ(w.add_material(wallSurface), wall);
+        EXPECT_EQ(w.add_material(glassSurface), glass);
+        EXPECT_EQ(w.add_material(mirrorSurface), mirror);
+        return w;
+    };
+    const std::vector<World> scenes{
+        scene({ sphere(wall, scaling(10, 0.01f, 10)), //chapter 7 and 8: spheres squashed into walls
+            sphere(wall, translation(0, 0, 5) * rotation_y(-math::PI / 4.0f) * rotation_x(math::PI / 2) * scaling(10.0f, 0.01f, 10.0f)),
+            sphere(wall, translation(0, 0, 5) * rotation_y(math::PI / 4.0f) * rotation_x(math::PI / 2) * scaling(10.0f, 0.01f, 10.0f)),
+            sphere(translation(-1.5f, 0.33f, -0.75f) * scaling(0.33f, 0.33f, 0.33f)), sphere(translation(-0.5f, 1, 0.5f)),
+            sphere(translation(1.5f, 0.5f, -0.5f) * scaling(0.5f, 0.5f, 0.5f)) }),
+        scene({ plane(wall), plane(wall, translation(0, 0, 5) * rotation_x(math::HALF_PI)), //chapter 9 and 11
+            sphere(glass, translation(-0.5f, 1, 0.5f)), sphere(mirror, translation(1.5f, 0.5f, -0.5f) * scaling(0.5f, 0.5f, 0.5f)) }),
+        scene({ plane(), cube(mirror, translation(-1, 1, 1) * rotation_y(0.5f)), cube(glass, translation(1.5f, 0.5f, -0.5f) * scaling(0.5f, 0.5f, 0.5f)) }), //chapter 12
+        scene({ plane(), cylinder(0.0f, 4.0f, mirror, rotation(0, 0, 22 * math::TO_RAD) * translation(-4, 0, 0)), cylinder(), //chapter 13
+            closed_cylinder(0.0f, 3.0f, glass, translation(3, 0, 0)), cone(0.0f, 3.0f, DEFAULT_MATERIAL_ID, translation(-3, 0, 3)), closed_cone(-1.0f, 0.0f, mirror, translation(0, 3, 2)) })
+    };
+    const std::vector<Matrix4> views{ //the cameras of chapters 7 to 9, and 10 to 13
+        view_transform(point(0, 1.5f, -5), point(0, 1, 0), vector(0, 1, 0)),
+        view_transform(point(0, 5, -10), point(0, 1, 0), vector(0, 1, 0))
+    };
+    for (const auto [width, height] : std::vector<std::pair<size_t, size_t>>{ {37, 21}, {1, 1}, {3, 7} }) { //rows that don't fill a packet
+        for (const auto& view : views) {
+            const auto c = Camera(width, height, math::PI / 3.0f, view);
+            for (const auto& w : scenes) {
+                expect_bit_identical(render_packets(c, w), render_single_threaded(c, w));
+            }
+        }
+    }
+}
+
+TEST(Camera, packetRenderMatchesSingleThreadedAboveTheFlatLimit) {
+    auto w = World({ plane() }, point_light(point(-10, 10, -10), color(1, 1, 1)));
+    for (auto x = -5; x < 5; ++x) {
+        for (auto z = 0; z < 10; ++z) {
+            const auto place = translation(Real(x), 0.3f, Real(z)) * scaling(0.3f, 0.3f, 0.3f);
+            const auto mat = w.add_material(material(color(Real(x + 5) / 10.0f, 0.5f, Real(z) / 10.0f)));
+            w.push_back((x + z) % 2 == 0 ? Shapes{ sphere(mat, place) } : Shapes{ cube(mat, place) });
+        }
+    }
+    ASSERT_GT(w.size(), PACKET_FLAT_LIMIT);
+    for (const auto [width, height] : std::vector<std::pair<size_t, size_t>>{ {37, 21}, {3, 7} }) {
+        const auto c = Camera(width, height, math::PI / 3.0f, view_transform(point(0, 4, -6), point(0, 0, 4), vector(0, 1, 0)));
+        expect_bit_identical(render_packets(c, w), render_single_threaded(c, w));
+    }
+}
+
+RESTORE_WARNINGS
@@ -3,6 +3,8 @@
 #include "../Tuple.h"
 #include "../Canvas.h"
 #include "../StringHelpers.h"
+#include <sstream>
+#include <filesystem>
 
 DISABLE_WARNINGS_FROM_GTEST
 
@@ -105,6 +107,58 @@ TEST(Canvas, PPMIsTerminatedByNewline) {
 }
 
 
+TEST(Canvas, LUTEncoderIsByteIdenticalToFormattedPPM) {
+  const std::vector<std::pair<size_t, size_t>> sizes{ {1, 1}, {1, 7}, {2, 3}, {4, 4}, {5, 3}, {6, 5}, {10, 2}, {17, 9}, {97, 61} }; //the last one spans several chunks
+  for (const auto [width, height] : sizes) {
+    auto canvas = Canvas(width, height);
+    for (size_t i = 0; i < canvas.size(); ++i) {
+      const auto v = static_cast<Real>(i % 301) / 250.0f - 0.1f; //includes out of range values on both ends
+      canvas.set(i, color(v, 1.0f - v, static_cast<Real>(i % 3) * 0.5f));
+    }
+    auto expected = to_ppm_seq({ canvas.data(), canvas.size() }, width, height);
+    ppm_add_linebreaks(expected, std::min(width * SPACES_PER_PIXEL, MAX_SPACES_PER_LINE));
+    EXPECT_EQ(canvas.to_ppm(), expected) << width << "x" << height;
+  }
+}
+
+TEST(Canvas, DigitTableHoldsTheDecimalTextOfEveryByte) {
+  for (uint16_t value = 0; value <= PPM_MAX_BYTE_VALUE; ++value) {
+    const auto& digits = PPM_DIGIT_TABLE[value];
+    EXPECT_EQ(std::string_view(digits.text.data(), digits.length), std::to_string(value));
+  }
+}
+
+TEST(Canvas, P6HasHeaderAndRawSRGBBytes) {
+  auto c = Canvas(2, 1);
+  c.set(0, 0, color(1.5f, 0.0f, 0.5f));
+  c.set(1, 0, color(0.0f, 1.0f, -0.5f));
+  std::ostringstream os(std::ios::binary);
+  write_ppm_p6(os, c);
+  const auto expected = "P6\n2 1\n255\n"s + std::string{ '\xFE', '\x00', '\xBB', '\x00', '\xFE', '\x00' };
+  EXPECT_EQ(os.str(), expected);
+}
+
+TEST(Canvas, P6StreamsLargeCanvasesInChunks) {
+  auto c = Canvas(300, 300); //more pixels than a single chunk
+  ASSERT_GT(c.size(), P6_PIXELS_PER_WRITE);
+  for (size_t i = 0; i < c.size(); ++i) {
+    c.set(i, color(static_cast<Real>(i % 256) / 255.0f, static_cast<Real>(i % 7) / 7.0f, 0.25f));
+  }
+  std::ostringstream os(std::ios::binary);
+  write_ppm_p6(os, c);
+  const auto out = os.str();
+  const auto header = "P6\n300 300\n255\n"s;
+  ASSERT_EQ(out.size(), header.size() + c.size() * 3);
+  EXPECT_EQ(out.substr(0, header.size()), header);
+  for (size_t i = 0; i < c.size(); ++i) {
+    const auto expected = ByteColor_sRGB(c[i]);
+    const auto* px = reinterpret_cast<const uint8_t*>(out.data() + header.size() + i * 3);
+    ASSERT_EQ(px[0], expected.r) << "pixel " << i;
+    ASSERT_EQ(px[1], expected.g) << "pixel " << i;
+    ASSERT_EQ(px[2], expected.b) << "pixel " << i;
+  }
+}
+
 TEST(DISABLED_Canvas, FromPPMThrowsForBadMagicNumber) {
   auto ppm = 
 R"(P32
@@ -209,4 +263,94 @@ R"(P3
   EXPECT_EQ(result.get(0, 1), color(0.75f, 0.5f, 0.25f));  
 }
 
+TEST(Canvas, FromPPMReadsP6) {
+  const auto ppm = "P6\n# binary, this time\n2 1\n255\n"s + std::string{ '\xFF', '\x0A', '\x00', '\x20', '\x7F', '\xFF' };
+  const auto result = canvas_from_ppm(ppm);
+  EXPECT_EQ(result.width(), 2);
+  EXPECT_EQ(result.height(), 1);
+  EXPECT_EQ(result.get(0, 0), color(1.0f, 10 / 255.0f, 0.0f)); //0x0A and 0x20 are pixel data, not whitespace
+  EXPECT_EQ(result.get(1, 0), color(32 / 255.0f, 0.498f, 1.0f));
+}
+
+TEST(Canvas, FromPPMReadsWhatP6WriterWrites) {
+  auto c = Canvas(37, 23);
+  for (size_t i = 0; i < c.size(); ++i) {
+    c.set(i, color(static_cast<Real>(i % 256) / 255.0f, static_cast<Real>(i % 7) / 7.0f, 0.25f));
+  }
+  std::ostringstream os(std::ios::binary);
+  write_ppm_p6(os, c);
+  const auto result = canvas_from_ppm(os.str());
+  ASSERT_EQ(result.width(), c.width());
+  ASSERT_EQ(result.height(), c.height());
+  for (size_t i = 0; i < c.size(); ++i) {
+    const auto expected = ByteColor_sRGB(c[i]);
+    ASSERT_EQ(result[i].r, expected.r / 255.0f) << "pixel " << i;
+    ASSERT_EQ(result[i].g, expected.g / 255.0f) << "pixel " << i;
+    ASSERT_EQ(result[i].b, expected.b / 255.0f) << "pixel " << i;
+  }
+}
+
+TEST(Canvas, FromPPMThrowsForTruncatedPixelData) {
+  EXPECT_THROW(canvas_from_ppm("P6\n2 1\n255\n\x01\x02\x03\x04\x05"sv), ppm_parse_error);
+  EXPECT_THROW(canvas_from_ppm("P3\n2 1\n255\n1 2 3 4 5"sv), ppm_parse_error);
+  EXPECT_THROW(canvas_from_ppm("P3\n1 1\n255\n1 2 x"sv), ppm_parse_error);
+}
+
+TEST(Canvas, PPMChunksStartAtLineBreaks) {
+  const auto text = "1 2 3\n4 5\n# 6 7\n8 9 10 11 12 13\n14"sv;
+  const auto starts = Detail::ppm_chunk_starts(text, 4);
+  ASSERT_GE(starts.size(), 3);
+  EXPECT_EQ(starts.front(), 0);
+  EXPECT_EQ(starts.back(), text.size());
+  for (size_t i = 1; i + 1 < starts.size(); ++i) {
+    EXPECT_EQ(text[starts[i] - 1], '\n');
+    EXPECT_LT(starts[i - 1], starts[i]);
+  }
+  EXPECT_EQ(Detail::ppm_chunk_starts("1 2 3 4 5 6 7 8 9"sv, 4).size(), 2); //no line breaks: a single chunk
+}
+
+TEST(Canvas, FromPPMParsesManyChunksInParallel) {
+  constexpr size_t width = 200;
+  constexpr size_t height = 160;
+  std::string ppm = "P3\n200 160\n255\n";
+  for (size_t value = 0; value < width * height * CHANNELS; ++value) {
+    ppm += std::to_string(value % 256);
+    ppm += (value % 11 == 10) ? "\n" : " "; //ragged lines, and triplets split across them
+    if (value % 997 == 0) {
+      ppm += "# 1 2 3 comments in the pixel data\n";
+    }
+  }
+  const auto pixel_data = std::string_view(ppm).substr(parse_header(ppm).data_start);
+  ASSERT_GT(Detail::ppm_chunk_starts(pixel_data).size(), 4);
+  const auto result = canvas_from_ppm(ppm);
+  ASSERT_EQ(result.width(), width);
+  ASSERT_EQ(result.height(), height);
+  for (size_t i = 0; i < result.size(); ++i) {
+    ASSERT_EQ(result[i].r, static_cast<float>((i * 3 + 0) % 256) / 255.0f) << "pixel " << i;
+    ASSERT_EQ(result[i].g, static_cast<float>((i * 3 + 1) % 256) / 255.0f) << "pixel " << i;
+    ASSERT_EQ(result[i].b, static_cast<float>((i * 3 + 2) % 256) / 255.0f) << "pixel " << i;
+  }
+}
+
+TEST(Canvas, LoadFromFileReadsSavedP3AndP6) {
+  auto c = Canvas(5, 3);
+  for (size_t i = 0; i < c.size(); ++i) {
+    c.set(i, color(static_cast<Real>(i) / 15.0f, 0.5f, 1.0f - static_cast<Real>(i) / 15.0f));
+  }
+  const auto path = (std::filesystem::temp_directory_path() / "canvas_roundtrip.ppm").string();
+  for (const auto format : { PPMFormat::P3, PPMFormat::P6 }) {
+    save_to_file(c, path, format);
+    const auto result = load_from_file(path);
+    ASSERT_EQ(result.width(), c.width());
+    ASSERT_EQ(result.height(), c.height());
+    for (size_t i = 0; i < c.size(); ++i) {
+      const auto expected = ByteColor_sRGB(c[i]);
+      EXPECT_EQ(result[i].r, expected.r / 255.0f);
+      EXPECT_EQ(result[i].b, expected.b / 255.0f);
+    }
+  }
+  std::filesystem::remove(path);
+  EXPECT_THROW(load_from_file(path), std::runtime_error);
+}
+
 RESTORE_WARNINGS
\ No newline at end of file
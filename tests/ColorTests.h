@@ -27,4 +27,67 @@ TEST(Color, canBeMultiplied) {
   EXPECT_FLOAT_EQ(result.b, 0.04f);  
 }
 
+TEST(Color, hadamardAndMaddMatchScalarMathExactly) {
+  constexpr auto a = color(0.9f, 0.3f, 0.123f);
+  constexpr auto b = color(0.25f, 0.7f, 1.5f);
+  static_assert(madd(color(1, 2, 3), 0.5f, color(1, 1, 1)) == color(1.5f, 2, 2.5f));
+  const auto product = a * b;
+  EXPECT_EQ(product.r, a.r * b.r);
+  EXPECT_EQ(product.g, a.g * b.g);
+  EXPECT_EQ(product.b, a.b * b.b);
+  const auto m = madd(a, 0.37f, b);
+  EXPECT_EQ(m.r, a.r * 0.37f + b.r);
+  EXPECT_EQ(m.g, a.g * 0.37f + b.g);
+  EXPECT_EQ(m.b, a.b * 0.37f + b.b);
+}
+
+TEST(Color, scaleSumAndDifferenceMatchScalarMathExactly) {
+  constexpr auto a = color(0.9f, 0.3f, 0.123f);
+  constexpr auto b = color(0.25f, 0.7f, 1.5f);
+  const auto scaled = a * 0.37f;
+  EXPECT_EQ(scaled.r, a.r * 0.37f);
+  EXPECT_EQ(scaled.g, a.g * 0.37f);
+  EXPECT_EQ(scaled.b, a.b * 0.37f);
+  const auto sum = a + b;
+  EXPECT_EQ(sum.r, a.r + b.r);
+  EXPECT_EQ(sum.g, a.g + b.g);
+  EXPECT_EQ(sum.b, a.b + b.b);
+  const auto difference = a - b;
+  EXPECT_EQ(difference.r, a.r - b.r);
+  EXPECT_EQ(difference.g, a.g - b.g);
+  EXPECT_EQ(difference.b, a.b - b.b);
+}
+
+TEST(Color, sRGBTableMatchesPowReference) {
+  const auto& table = sRGB_encode_table();
+  const auto one = std::bit_cast<uint32_t>(1.0f);
+  for (uint32_t bits = 0; bits <= one; bits += 101) { //a dense sample of every float in [0, 1]
+    const auto s = std::bit_cast<Real>(bits);
+    ASSERT_EQ(sRGB_encode(s), linear_to_sRGB_byte(s)) << s;
+  }
+  for (const auto edge : table.threshold) { //and the floats right around every step of the curve
+    if (edge > 1.0f) {
+      continue;
+    }
+    for (const auto s : { std::nextafter(edge, 0.0f), edge, std::nextafter(edge, 1.0f) }) {
+      ASSERT_EQ(sRGB_encode(s), linear_to_sRGB_byte(s)) << s;
+    }
+  }
+  for (size_t i = 0; i <= SRGB_TABLE_SIZE; ++i) { //and the bucket edges
+    const auto s = static_cast<Real>(i) / static_cast<Real>(SRGB_TABLE_SIZE);
+    ASSERT_EQ(sRGB_encode(s), linear_to_sRGB_byte(s)) << s;
+  }
+}
+
+TEST(Color, sRGBTableClampsOutOfRangeValues) {
+  EXPECT_EQ(sRGB_encode(-1.0f), 0);
+  EXPECT_EQ(sRGB_encode(1.5f), linear_to_sRGB_byte(1.0f));
+  EXPECT_EQ(sRGB_encode(std::numeric_limits<Real>::infinity()), linear_to_sRGB_byte(1.0f));
+  EXPECT_EQ(sRGB_encode(std::numeric_limits<Real>::quiet_NaN()), 0);
+  const auto c = ByteColor_sRGB(color(1.5f, 0.0f, 0.5f));
+  EXPECT_EQ(c.r, 254);
+  EXPECT_EQ(c.g, 0);
+  EXPECT_EQ(c.b, 187);
+}
+
 RESTORE_WARNINGS
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+#include "../pch.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../World.h"
+#include "../Intersection.h"
+#include "../CompiledScene.h"
+
+DISABLE_WARNINGS_FROM_GTEST
+
+static World random_mixed_world(std::mt19937& rng, int count) {
+    std::uniform_real_distribution<Real> pos(-20.0f, 20.0f);
+    std::uniform_real_distribution<Real> size(0.2f, 2.0f);
+    World w({ plane(translation(0, -25, 0)) });
+    for (auto i = 0; i < count; ++i) {
+        const auto transf = translation(pos(rng), pos(rng), pos(rng)) * rotation_y(pos(rng)) * scaling(size(rng), size(rng), size(rng));
+        switch (i % 5) {
+        case 0: w.push_back(sphere(transf)); break;
+        case 1: w.push_back(cube(transf)); break;
+        case 2: w.push_back(closed_cylinder(-1.0f, 1.0f, DEFAULT_MATERIAL_ID, transf)); break;
+        case 3: w.push_back(cone(-1.0f, 0.0f, DEFAULT_MATERIAL_ID, transf)); break;
+        default: w.push_back(sphere(transf)); break;
+        }
+    }
+    w.build();
+    return w;
+}
+
+TEST(CompiledScene, groupsShapesByType) {
+    const auto w = World({ plane(), sphere(), cylinder(), cube(translation(3, 0, 0)), sphere(translation(0, 3, 0)), cone(-1, 0) });
+    const auto scene = compile(w);
+    EXPECT_EQ(scene.size(), w.size());
+    EXPECT_EQ(scene.spheres.size(), 2u);
+    EXPECT_EQ(scene.planes.size(), 1u);
+    EXPECT_EQ(scene.cubes.size(), 1u);
+    EXPECT_EQ(scene.cylinders.size(), 1u);
+    EXPECT_EQ(scene.cones.size(), 1u);
+    EXPECT_EQ(scene.spheres.object[1], 4u);
+    EXPECT_EQ(scene.spheres.inv[7][1], -3.0f); //the y translation of the inverse
+    EXPECT_EQ(scene.cone_extents.minimum[0], -1.0f);
+    EXPECT_EQ(scene.cylinder_extents.maximum[0], math::MAX);
+}
+
+TEST(CompiledScene, flatPacketsMatchTheWorld) {
+    std::mt19937 rng(77);
+    std::uniform_real_distribution<Real> pos(-20.0f, 20.0f);
+    const auto w = random_mixed_world(rng, static_cast<int>(PACKET_FLAT_LIMIT) - 1); //every shape for every packet
+    const auto scene = compile(w);
+    auto hits = 0;
+    for (auto i = 0; i < 2000; ++i) {
+        RayPacket packet;
+        for (auto& r : packet) {
+            r = ray(point(pos(rng), pos(rng), -30.0f), normalize(vector(pos(rng), pos(rng), 30.0f)));
+        }
+        const auto actual = closest_hits(scene, packet);
+        for (size_t k = 0; k < RAY_PACKET_SIZE; ++k) {
+            const auto expected = closest_hit(w, packet[k]);
+            ASSERT_EQ(actual[k].objPtr, expected.objPtr);
+            ASSERT_EQ(actual[k].t, expected.t); //the same arithmetic, bit for bit
+            hits += expected ? 1 : 0;
+        }
+    }
+    EXPECT_GT(hits, 200);
+}
+
+TEST(CompiledScene, missingEverythingIsNoHit) {
+    const auto w = World({ sphere(translation(0, 0, 5)) });
+    const auto scene = compile(w);
+    const auto r = ray(point(0, 0, 0), vector(0, 0, -1));
+    for (const auto& hit : closest_hits(scene, RayPacket{ r, r, r, r })) {
+        EXPECT_FALSE(hit);
+    }
+}
+
+#if RTC_SIMD
+TEST(CompiledScene, packetsAboveTheFlatLimitMatchTheWorld) {
+    std::mt19937 rng(20);
+    auto w = random_mixed_world(rng, 200);
+    const auto id = w.add_asset({ sphere(), cube(translation(0, 2, 0)) });
+    w.add_instance(instance(id, translation(0, 0, -22)));
+    w.build();
+    ASSERT_GT(w.size(), PACKET_FLAT_LIMIT);
+    const auto scene = compile(w);
+    std::uniform_real_distribution<Real> pos(-25.0f, 25.0f);
+    auto hits = 0;
+    for (auto i = 0; i < 500; ++i) {
+        RayPacket packet;
+        const auto origin = point(pos(rng), pos(rng), -30.0f);
+        for (auto& r : packet) { //every other packet shares an origin, like primary rays
+            r = ray(i % 2 == 0 ? origin : point(pos(rng), pos(rng), -30.0f), normalize(vector(pos(rng), pos(rng), 30.0f)));
+        }
+        const auto actual = closest_hits(scene, packet);
+        for (size_t k = 0; k < RAY_PACKET_SIZE; ++k) {
+            const auto expected = closest_hit(w, packet[k]);
+            ASSERT_EQ(actual[k].t, expected.t);
+            ASSERT_EQ(actual[k].objPtr, expected.objPtr);
+            ASSERT_EQ(actual[k].instance, expected.instance);
+            hits += expected ? 1 : 0;
+        }
+    }
+    EXPECT_GT(hits, 500);
+}
+#endif
+
+TEST(DISABLED_CompiledScene, PacketsVersusWorld) {
+    using clock = std::chrono::steady_clock;
+    std::mt19937 rng(79);
+    std::uniform_real_distribution<Real> pos(-20.0f, 20.0f);
+    std::uniform_real_distribution<Real> size(0.2f, 2.0f);
+    World w({ plane(translation(0, -25, 0)) }); //spheres and a floor, about the size of a chapter scene
+    for (auto i = 0; i < 20; ++i) {
+        w.push_back(sphere(translation(pos(rng), pos(rng), pos(rng)) * scaling(size(rng), size(rng), size(rng))));
+    }
+    w.build();
+    const auto scene = compile(w);
+    std::vector<RayPacket> packets(250'000);
+    for (auto& packet : packets) {
+        const auto origin = point(pos(rng), pos(rng), -30.0f);
+        for (auto& r : packet) {
+            r = ray(origin, normalize(vector(pos(rng), pos(rng), 30.0f)));
+        }
+    }
+    Real checksum = 0.0f;
+    auto start = clock::now();
+    for (const auto& packet : packets) {
+        for (const auto& r : packet) {
+            checksum += closest_hit(w, r).t;
+        }
+    }
+    const std::chrono::duration<double, std::milli> world_ms = clock::now() - start;
+    start = clock::now();
+    for (const auto& packet : packets) {
+        for (const auto& hit : closest_hits(scene, packet)) {
+            checksum += hit.t;
+        }
+    }
+    const std::chrono::duration<double, std::milli> scene_ms = clock::now() - start;
+    std::cout << "world: " << world_ms.count() << "ms, compiled scene: " << scene_ms.count() << "ms (checksum " << checksum << ")\n";
+}
+
+RESTORE_WARNINGS
@@ -91,4 +91,15 @@ TEST(Cone, normalOnSurfaceOfCone) {
     }
 }
 
+TEST(Cone, unboundedConeHasAnInfiniteBoundingBox) {
+    EXPECT_TRUE(is_infinite(local_bounds(cone())));
+}
+
+TEST(Cone, boundedConeHasABoundingBox) {
+    const auto b = local_bounds(cone(-5, 3));
+    EXPECT_FALSE(is_infinite(b));
+    EXPECT_EQ(b.min, point(-5, -5, -5));
+    EXPECT_EQ(b.max, point(5, 3, 5));
+}
+
 RESTORE_WARNINGS
@@ -9,7 +9,7 @@ DISABLE_WARNINGS_FROM_GTEST
 
 TEST(Cube, hasTransformAndInverseTransform) {
     const auto c = cube();
-    EXPECT_EQ(c.get_transform(), Matrix4Identity);
+    EXPECT_EQ(c.get_transform(), AffineIdentity);
     EXPECT_EQ(c.inv_transform(), inverse(c.get_transform()));
 }
 
@@ -318,4 +318,11 @@ TEST(Cube, FindingTheColorsOnAMappedCube) {
 }
 
 
+TEST(Cube, hasABoundingBox) {
+    const auto b = local_bounds(cube());
+    EXPECT_EQ(b.min, point(-1, -1, -1));
+    EXPECT_EQ(b.max, point(1, 1, 1));
+    EXPECT_FALSE(is_infinite(b));
+}
+
 RESTORE_WARNINGS
\ No newline at end of file
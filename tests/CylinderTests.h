@@ -91,7 +91,7 @@ TEST(Cylinder, intersectingATruncatedCylinder) {
         {point(0, 1, -5), normal_vector(0, 0, 1)}, //edge case: the minimum extent is *excluded*
         {point(0, 1.5f, -2), normal_vector(0, 0, 1)} //perpendicular to the cylinder, at the middle of it. 
     }; 
-    const std::vector<std::vector<Real>> points{
+    const std::vector<LocalHits> points{
         MISS,
         MISS,
         MISS,
@@ -155,4 +155,18 @@ TEST(Cylinder, normalOnCylinderEndCap) {
     }
 }
 
+TEST(Cylinder, unboundedCylinderHasAnInfiniteBoundingBox) {
+    const auto b = local_bounds(cylinder());
+    EXPECT_TRUE(is_infinite(b));
+    EXPECT_EQ(b.min, point(-1, math::MIN, -1));
+    EXPECT_EQ(b.max, point(1, math::MAX, 1));
+}
+
+TEST(Cylinder, boundedCylinderHasABoundingBox) {
+    const auto b = local_bounds(cylinder(-5, 3));
+    EXPECT_FALSE(is_infinite(b));
+    EXPECT_EQ(b.min, point(-1, -5, -1));
+    EXPECT_EQ(b.max, point(1, 3, 1));
+}
+
 RESTORE_WARNINGS
\ No newline at end of file
@@ -2,54 +2,137 @@
 #include "../pch.h"
 #include "../Tuple.h"
 #include "../Matrix.h"
-#include "../Group.h"
+#include "../SceneGraph.h"
+#include "../World.h"
 #include "../Ray.h"
 #include "../Intersection.h"
 DISABLE_WARNINGS_FROM_GTEST
 
+TEST(Group, ANewGroupIsEmpty) {
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE);
+    EXPECT_TRUE(g[group].is_group());
+    EXPECT_EQ(g[group].first_child, NO_NODE);
+    EXPECT_TRUE(is_empty(g[group].world_bounds));
+    EXPECT_EQ(g[ROOT_NODE].first_child, group);
+}
+
+TEST(Group, ChildrenAreLinkedByIndex) {
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE);
+    const auto a = g.add_shape(group, sphere());
+    const auto b = g.add_shape(group, cube());
+    EXPECT_EQ(g[group].first_child, b); //the latest first
+    EXPECT_EQ(g[b].next_sibling, a);
+    EXPECT_EQ(g[a].next_sibling, NO_NODE);
+    EXPECT_EQ(g[group].next_sibling, NO_NODE);
+}
+
+TEST(Group, IntersectingRayWithEmptyGroup) {
+    SceneGraph g;
+    g.add_group(ROOT_NODE);
+    EXPECT_TRUE(intersect(g, ray(point(0, 0, 0), vector(0, 0, 1))).empty());
+}
+
+TEST(Group, IntersectingRayWithNonEmptyGroup) {
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE);
+    const auto s1 = g.add_shape(group, sphere());
+    const auto s2 = g.add_shape(group, sphere(translation(0, 0, -3)));
+    g.add_shape(group, sphere(translation(5, 0, 0)));
+    const auto xs = intersect(g, ray(point(0, 0, -5), vector(0, 0, 1)));
+    ASSERT_EQ(xs.size(), 4);
+    EXPECT_EQ(xs[0].objPtr, &g.shape(s2));
+    EXPECT_EQ(xs[1].objPtr, &g.shape(s2));
+    EXPECT_EQ(xs[2].objPtr, &g.shape(s1));
+    EXPECT_EQ(xs[3].objPtr, &g.shape(s1));
+}
+
+TEST(Group, IntersectingTransformedGroup) {
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE, scaling(2, 2, 2));
+    const auto s = g.add_shape(group, sphere(translation(5, 0, 0)));
+    const auto xs = intersect(g, ray(point(10, 0, -10), vector(0, 0, 1)));
+    ASSERT_EQ(xs.size(), 2);
+    EXPECT_EQ(xs[0].objPtr, &g.shape(s)); //the hit carries the sphere, not the group
+}
+
+TEST(Group, ConvertingNormalFromObjectToWorldSpace) {
+    SceneGraph g;
+    const auto g1 = g.add_group(ROOT_NODE, rotation_y(math::HALF_PI));
+    const auto g2 = g.add_group(g1, scaling(1, 2, 3));
+    const auto s = g.add_shape(g2, sphere(translation(5, 0, 0)));
+    constexpr auto third = 0.5773502691896257f; //sqrt(3) / 3
+    const auto n = g.normal_to_world(s, vector(third, third, third));
+    EXPECT_NEAR(n.x, 0.2857f, math::BOOK_EPSILON); //the book's 4 decimals
+    EXPECT_NEAR(n.y, 0.4286f, math::BOOK_EPSILON);
+    EXPECT_NEAR(n.z, -0.8571f, math::BOOK_EPSILON);
+}
+
+TEST(Group, BoundsFollowTheChildren) {
+    SceneGraph g;
+    const auto outer = g.add_group(ROOT_NODE);
+    const auto group = g.add_group(outer);
+    const auto s = g.add_shape(group, sphere(translation(2, 0, 0)));
+    EXPECT_EQ(g[s].world_bounds, aabb(point(1, -1, -1), point(3, 1, 1)));
+    EXPECT_EQ(g[group].world_bounds, g[s].world_bounds);
+    g.set_transform(s, translation(-2, 0, 0));
+    g.update(); //the groups above hear about it here
+    EXPECT_EQ(g[group].world_bounds, aabb(point(-3, -1, -1), point(-1, 1, 1)));
+    g.add_shape(group, sphere(translation(0, 5, 0))); //and about new children right away
+    EXPECT_EQ(g[outer].world_bounds, aabb(point(-3, -1, -1), point(1, 6, 1)));
+    g.set_transform(outer, translation(0, 0, 10)); //the bounds are in world space
+    g.update();
+    EXPECT_EQ(g[outer].world_bounds, aabb(point(-3, -1, 9), point(1, 6, 11)));
+}
+
+TEST(Group, SkipsSubtreesTheRayMisses) {
+    SceneGraph g;
+    const auto ahead = g.add_group(ROOT_NODE);
+    const auto s1 = g.add_shape(ahead, sphere(translation(0, 0, 5)));
+    const auto aside = g.add_group(ROOT_NODE, translation(5, 0, 0));
+    for (auto i = 0; i < 4; ++i) {
+        g.add_shape(aside, sphere(translation(0, Real(i) * 3, 0)));
+    }
+    const auto r = ray(point(0, 0, -5), vector(0, 0, 1));
+    auto visited = 0;
+    traverse_nodes(g, r, 0.0f, math::MAX, [&visited](size_t) noexcept { ++visited; return math::MAX; });
+    EXPECT_EQ(visited, 1); //one box test spared the 4 shapes aside
+    const auto hit = nearest_hit(g, r, 0.0f, math::MAX);
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit.objPtr, &g.shape(s1));
+    EXPECT_FLOAT_EQ(hit.t, 9.0f);
+    EXPECT_FALSE(nearest_hit(g, r, 0.0f, 8.0f)); //the box starts at 9
+}
 
-TEST(Group, ANewGroupIsEmpty) {           
-    Group g;
-    EXPECT_TRUE(g.empty());
-    EXPECT_EQ(g.size(), 0);
-    EXPECT_EQ(g.get_transform(), Matrix4Identity);
-    EXPECT_EQ(g.inv_transform(), inverse(g.get_transform()));
-}
-
-TEST(Group, ANewGroupHasNoParent) {           
-    Group g;
-    EXPECT_FALSE(g.has_parent());
-}
-
-TEST(Group, CanParentShape) {           
-    Group g;
-    Shapes s = Sphere();
-    g.push_back(&s);
-    EXPECT_TRUE(g.front() == s);
-    EXPECT_TRUE(get_parent(g.front()) == &g);
-}
-
-TEST(Group, IntersectingRayWithEmptyGroup) {           
-    Group g;
-    auto r = ray(point(0, 0, 0), vector(0, 0, 1));
-    auto xs = local_intersect(g, r);
-    EXPECT_TRUE(xs.empty());
-}
-
-TEST(Group, IntersectingRayWithNonEmptyGroup) {           
-    Group g;
-    Shapes s1 = sphere();
-    Shapes s2 = sphere();
-    set_transform(s2, translation(0, 0, -3));
-    Shapes s3 = sphere();
-    set_transform(s3, translation(5, 0, 0));
-    auto r = ray(point(0, 0, -5), vector(0, 0, 1));
-    auto xs = local_intersect(g, r);
-    EXPECT_EQ(xs.size(), 4);
-    xs[0] == s2;
-    xs[1] == s2;
-    xs[2] == s1;
-    xs[3] == s1;
+TEST(Group, GraphQueriesMatchTheWorld) {
+    auto w = World({});
+    const auto red = w.add_material(material(color(1, 0, 0)));
+    SceneGraph g;
+    g.add_shape(ROOT_NODE, plane(translation(0, -1, 0))); //unbounded, so never culled
+    const auto group = g.add_group(ROOT_NODE, translation(0, 0, 3), red);
+    g.add_shape(group, sphere(translation(-1.5f, 0, 0)));
+    const auto right = g.add_shape(group, cube(translation(1.5f, 0, 0)));
+    w.add_scene(g);
+    w.build();
+    const std::array rays{ ray(point(1.5f, 0, -5), vector(0, 0, 1)), ray(point(-1.5f, 0, -5), vector(0, 0, 1)),
+        ray(point(0, 0, -5), vector(0, 0, 1)), ray(point(0, 5, 0), vector(0, -1, 0)), ray(point(0, 5, 0), vector(0, 1, 0)) };
+    for (const auto& r : rays) {
+        const auto mine = closest_hit(g, r);
+        const auto theirs = closest_hit(w, r);
+        ASSERT_EQ(bool(mine), bool(theirs));
+        if (mine) {
+            EXPECT_FLOAT_EQ(mine.t, theirs.t);
+            EXPECT_EQ(*mine.objPtr, *theirs.objPtr);
+            EXPECT_EQ(mine.material_id(), theirs.material_id());
+        }
+        EXPECT_EQ(occluded(g, r, 6.0f), occluded(w, r, 6.0f));
+        EXPECT_EQ(intersect(g, r).size(), intersect(w, r).size());
+    }
+    const auto hit = closest_hit(g, rays[0]);
+    EXPECT_EQ(hit.objPtr, &g.shape(right));
+    EXPECT_FLOAT_EQ(hit.t, 7.0f);
+    EXPECT_EQ(hit.material_id(), red); //the group's
 }
 
 RESTORE_WARNINGS
@@ -0,0 +1,205 @@
+#pragma once
+#include "../pch.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../World.h"
+#include "../Intersection.h"
+#include "../HitState.h"
+#include "../Lighting.h"
+#include "../Camera.h"
+#include "../CompiledScene.h"
+
+DISABLE_WARNINGS_FROM_GTEST
+
+//a small asset: a unit sphere with a cube on top of it.
+static std::vector<Shapes> sphere_and_cube() {
+    return { sphere(), cube(translation(0, 2, 0) * scaling(0.5f, 0.5f, 0.5f)) };
+}
+
+TEST(Instance, isMuchSmallerThanAShape) {
+    static_assert(sizeof(Instance) < sizeof(Shapes));
+    const auto i = instance(0, translation(1, 2, 3));
+    EXPECT_EQ(i.transform, affine(translation(1, 2, 3)));
+    EXPECT_EQ(i.inv_transform, affine(translation(-1, -2, -3)));
+    EXPECT_FALSE(i.material);
+}
+
+TEST(Instance, assetsKnowTheirBounds) {
+    const auto a = asset(sphere_and_cube());
+    EXPECT_EQ(a.bounds.min, point(-1, -1, -1));
+    EXPECT_EQ(a.bounds.max, point(1, 2.5f, 1));
+    const auto box = bounds_of(instance(0, translation(10, 0, 0)), a);
+    EXPECT_EQ(box.min, point(9, -1, -1));
+    EXPECT_EQ(box.max, point(11, 2.5f, 1));
+}
+
+TEST(Instance, hitsCarryTheInstance) {
+    World w({});
+    const auto id = w.add_asset(sphere_and_cube());
+    w.add_instances(std::vector{ instance(id, translation(-5, 0, 0)), instance(id, translation(5, 0, 0)) });
+    const auto hit = closest_hit(w, ray(point(5, 0, -5), vector(0, 0, 1)));
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit.t, 4.0f);
+    EXPECT_EQ(hit.instance, &w.instances()[1]);
+    EXPECT_EQ(hit.objPtr, &w.assets()[id].shapes[0]);
+    const auto xs = intersect(w, ray(point(-5, 2, -5), vector(0, 0, 1)));
+    ASSERT_EQ(xs.size(), 2u); //through the cube of the first instance
+    EXPECT_EQ(xs[0].t, 4.5f);
+    EXPECT_EQ(xs[0].instance, &w.instances()[0]);
+    EXPECT_EQ(xs[0].objPtr, &w.assets()[id].shapes[1]);
+    EXPECT_FALSE(closest_hit(w, ray(point(0, 0, -5), vector(0, 0, 1))));
+}
+
+TEST(Instance, normalsGoThroughTheInstanceTransform) {
+    World w({});
+    const auto id = w.add_asset({ sphere(scaling(1, 2, 1)) });
+    w.add_instance(instance(id, translation(0, 0, 10) * scaling(2, 1, 1)));
+    const auto r = ray(point(0, 0, 0), vector(0, 0, 1));
+    const auto hit = closest_hit(w, r);
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit.t, 9.0f);
+    const auto state = prepare_computations(hit, r);
+    EXPECT_EQ(state.point, point(0, 0, 9));
+    EXPECT_EQ(state.normal, vector(0, 0, -1));
+    const auto side = normal_at(w.instances()[0], std::get<Sphere>(w.assets()[id].shapes[0]), point(2, 0, 10));
+    EXPECT_EQ(side, vector(1, 0, 0));
+}
+
+TEST(Instance, canReplaceTheMaterialOfItsAsset) {
+    World w({});
+    const auto blue = w.add_material(material(color(0, 0, 1)));
+    const auto red = w.add_material(material(color(1, 0, 0)));
+    const auto id = w.add_asset({ sphere(blue) });
+    w.add_instances(std::vector{ instance(id, translation(-3, 0, 0)), instance(id, translation(3, 0, 0), red) });
+    const auto original = closest_hit(w, ray(point(-3, 0, -5), vector(0, 0, 1)));
+    const auto recolored = closest_hit(w, ray(point(3, 0, -5), vector(0, 0, 1)));
+    ASSERT_TRUE(original && recolored);
+    EXPECT_EQ(original.material_id(), blue);
+    EXPECT_EQ(recolored.material_id(), red);
+    EXPECT_EQ(w.material_at(recolored.material_id()).color, color(1, 0, 0));
+    EXPECT_EQ(recolored.objPtr, original.objPtr); //the same shape, seen through two instances
+}
+
+TEST(Instance, castShadows) {
+    World w({ plane() });
+    const auto id = w.add_asset({ sphere() });
+    w.add_instance(instance(id, translation(0, 5, 0)));
+    EXPECT_TRUE(occluded(w, ray(point(0, 0.01f, 0), vector(0, 1, 0)), 10.0f));
+    EXPECT_FALSE(occluded(w, ray(point(0, 0.01f, 0), vector(0, 1, 0)), 3.0f));
+    EXPECT_FALSE(occluded(w, ray(point(3, 0.01f, 0), vector(0, 1, 0)), 10.0f));
+}
+
+TEST(Instance, objectsWinTiesWithInstances) {
+    World w({ sphere(translation(0, 0, 5)) });
+    const auto id = w.add_asset({ sphere() });
+    w.add_instance(instance(id, translation(0, 0, 5)));
+    const auto hit = closest_hit(w, ray(point(0, 0, 0), vector(0, 0, 1)));
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit.objPtr, &w.objects()[0]);
+    EXPECT_EQ(hit.instance, nullptr);
+}
+
+//the shapes of the grid's asset, placed by place: a ball of glass on a default cube, or both in surface.
+static std::vector<Shapes> glass_ball_on_a_cube(const Matrix4& place, MaterialId glass, MaterialId surface = DEFAULT_MATERIAL_ID) {
+    return { sphere(surface != DEFAULT_MATERIAL_ID ? surface : glass, place * translation(0, 1, 0)),
+        cube(surface, place * translation(0, 0.25f, 0) * scaling(0.25f, 0.25f, 0.25f)) };
+}
+
+//a grid of instanced assets, and the same shapes placed one by one.
+static std::pair<World, World> instanced_and_flat_grids() {
+    auto glass = material(color(0.1f, 0.1f, 0.1f));
+    glass.transparency = 0.9f;
+    glass.refractive_index = 1.5f;
+    const auto gold = material(color(1, 0.8f, 0.1f));
+    const auto light = point_light(point(-10, 10, -10), color(1, 1, 1));
+    World instanced({ plane() }, light);
+    World flat({ plane() }, light);
+    const auto glass_id = instanced.add_material(glass);
+    const auto gold_id = instanced.add_material(gold);
+    flat.add_material(glass); //the same ids in both tables
+    flat.add_material(gold);
+    const auto id = instanced.add_asset(glass_ball_on_a_cube(Matrix4Identity, glass_id));
+    std::vector<Instance> grid;
+    for (auto x = -2; x <= 2; ++x) {
+        for (auto z = 0; z <= 4; ++z) {
+            const auto place = translation(Real(x) * 2.5f, 0, Real(z) * 2.5f);
+            const auto golden = (x + z) % 3 == 0;
+            grid.push_back(instance(id, place, golden ? gold_id : DEFAULT_MATERIAL_ID));
+            for (const auto& s : glass_ball_on_a_cube(place, glass_id, golden ? gold_id : DEFAULT_MATERIAL_ID)) {
+                flat.push_back(s);
+            }
+        }
+    }
+    instanced.add_instances(grid);
+    instanced.build();
+    flat.build();
+    return { std::move(instanced), std::move(flat) };
+}
+
+TEST(Instance, rendersLikeTheSameShapesPlacedOneByOne) {
+    const auto [instanced, flat] = instanced_and_flat_grids();
+    const auto c = Camera(40, 30, math::PI / 3.0f, view_transform(point(0, 6, -8), point(0, 0, 4), vector(0, 1, 0)));
+    const auto expected = render_single_threaded(c, flat);
+    const auto actual = render_single_threaded(c, instanced);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        //the transforms are applied in two steps instead of one, so the last bits can differ
+        ASSERT_NEAR(actual[i].r, expected[i].r, 1e-3f) << "at pixel " << i;
+        ASSERT_NEAR(actual[i].g, expected[i].g, 1e-3f) << "at pixel " << i;
+        ASSERT_NEAR(actual[i].b, expected[i].b, 1e-3f) << "at pixel " << i;
+    }
+}
+
+TEST(Instance, packetRenderMatchesSingleThreaded) {
+    const auto instanced = instanced_and_flat_grids().first;
+    const auto c = Camera(23, 17, math::PI / 3.0f, view_transform(point(0, 6, -8), point(0, 0, 4), vector(0, 1, 0)));
+    const auto expected = render_single_threaded(c, instanced);
+    const auto actual = render_packets(c, instanced);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(actual[i].r, expected[i].r) << "at pixel " << i;
+        ASSERT_EQ(actual[i].g, expected[i].g) << "at pixel " << i;
+        ASSERT_EQ(actual[i].b, expected[i].b) << "at pixel " << i;
+    }
+}
+
+TEST(DISABLED_Instance, TenThousandInstancesVersusTenThousandShapes) {
+    using clock = std::chrono::steady_clock;
+    std::mt19937 rng(22);
+    std::uniform_real_distribution<Real> pos(-100.0f, 100.0f);
+    std::uniform_real_distribution<Real> angle(-math::PI, math::PI);
+    World instanced({});
+    World flat({});
+    const auto id = instanced.add_asset(sphere_and_cube());
+    std::vector<Instance> placed;
+    for (auto i = 0; i < 10'000; ++i) {
+        const auto place = translation(pos(rng), pos(rng), pos(rng)) * rotation_y(angle(rng));
+        placed.push_back(instance(id, place));
+        flat.push_back(sphere(place));
+        flat.push_back(cube(place * translation(0, 2, 0) * scaling(0.5f, 0.5f, 0.5f)));
+    }
+    auto start = clock::now();
+    instanced.add_instances(placed);
+    instanced.build();
+    const std::chrono::duration<double, std::milli> build_ms = clock::now() - start;
+    flat.build();
+    std::vector<Ray> rays;
+    for (auto i = 0; i < 200'000; ++i) {
+        rays.push_back(ray(point(pos(rng), pos(rng), -150.0f), normalize(vector(pos(rng), pos(rng), 150.0f))));
+    }
+    const auto time = [&rays](const World& w) {
+        Real checksum = 0.0f;
+        const auto begin = clock::now();
+        for (const auto& r : rays) {
+            checksum += closest_hit(w, r).t;
+        }
+        const std::chrono::duration<double, std::milli> ms = clock::now() - begin;
+        return std::pair{ ms.count(), checksum };
+    };
+    const auto [instanced_ms, instanced_sum] = time(instanced);
+    const auto [flat_ms, flat_sum] = time(flat);
+    std::cout << "instances: " << instanced.instances().size() * sizeof(Instance) / 1024 << "KB, top level built in " << build_ms.count() << "ms, "
+        << instanced_ms << "ms (checksum " << instanced_sum << ")\n"
+        << "shapes: " << flat.objects().size() * sizeof(Shapes) / 1024 << "KB, " << flat_ms << "ms (checksum " << flat_sum << ")\n";
+}
+
+RESTORE_WARNINGS
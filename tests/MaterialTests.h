@@ -1,6 +1,8 @@
 #pragma once
 #include "../pch.h"
 #include "../Material.h"
+#include "../Shapes.h"
+#include "../World.h"
 
 
 DISABLE_WARNINGS_FROM_GTEST
@@ -25,5 +27,41 @@ TEST(Material, hasTransparencyAndRefractiveIndex) {
     EXPECT_EQ(m.refractive_index, 1.0f);
 }
 
+TEST(MaterialTable, shapesHoldAnIdInsteadOfAMaterial) {
+    static_assert(sizeof(MaterialId) == 4);
+    static_assert(sizeof(Sphere) < sizeof(Material));
+    constexpr auto s = sphere(MaterialId{ 3 }, translation(0, 1, 0));
+    static_assert(s.material_id() == 3);
+    static_assert(sphere().material_id() == DEFAULT_MATERIAL_ID);
+    static_assert(sphere(MaterialId{ 3 }) != sphere(MaterialId{ 4 }));
+}
+
+TEST(MaterialTable, everyWorldStartsWithTheDefaultMaterial) {
+    const World w({ sphere() });
+    ASSERT_EQ(w.materials().size(), 1u);
+    EXPECT_EQ(w.material_at(DEFAULT_MATERIAL_ID), material());
+    EXPECT_EQ(get_material(w, 0), material());
+}
+
+TEST(MaterialTable, shapesGivenTheSameIdShareAMaterial) {
+    World w({ plane() });
+    const auto gold = w.add_material(material(color(1, 0.8f, 0)));
+    EXPECT_NE(gold, DEFAULT_MATERIAL_ID);
+    w.push_back({ sphere(gold), cube(gold, translation(3, 0, 0)) });
+    w.build();
+    w.edit_material(gold).reflective = 0.5f;
+    EXPECT_TRUE(w.is_built()); //materials don't move anything
+    EXPECT_EQ(get_material(std::as_const(w), 1).reflective, 0.5f);
+    EXPECT_EQ(get_material(std::as_const(w), 2).reflective, 0.5f);
+    EXPECT_EQ(get_material(std::as_const(w), 0).reflective, 0.0f);
+}
+
+TEST(MaterialTable, copiesOfAWorldHaveTheirOwnTable) {
+    const auto a = World();
+    auto b = a;
+    get_material(b, 0).color = color(1, 0, 0);
+    EXPECT_EQ(get_material(a, 0).color, World::DEFAULT_MATERIAL.color);
+    EXPECT_EQ(get_material(std::as_const(b), 0).color, color(1, 0, 0));
+}
 
 RESTORE_WARNINGS
\ No newline at end of file
@@ -1,6 +1,11 @@
 #pragma once
 #include "../pch.h"
 #include "../Matrix.h"
+#include "../Ray.h"
+#include "TestHelpers.h"
+#include <chrono>
+#include <iostream>
+#include <random>
 
 DISABLE_WARNINGS_FROM_GTEST
 
@@ -369,4 +374,85 @@ TEST(Matrix, RodriguesYAxisRotation) {
     EXPECT_EQ(out, vector(-1, 1, 0));
 }
 
+//the SIMD paths (when RTC_SIMD is on) must agree with the scalar reference implementations.
+TEST(Matrix, Matrix4KernelsMatchScalarReference) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<Real> coord(-50.0f, 50.0f);
+    for (int i = 0; i < 1000; ++i) {
+        const auto a = random_transform(rng);
+        const auto b = random_transform(rng);
+        const auto product = a * b;
+        const auto expected_product = Detail::multiply_scalar(a, b);
+        for (uint8_t j = 0; j < product.size(); ++j) {
+            ASSERT_EQ(product[j], expected_product[j]); //same operations in the same order: bit identical
+        }
+        const auto p = point(coord(rng), coord(rng), coord(rng));
+        const auto v = vector(coord(rng), coord(rng), coord(rng));
+        const auto tp = a * p;
+        const auto expected_p = Detail::transform_scalar(a, p);
+        ASSERT_EQ(tp.x, expected_p.x);
+        ASSERT_EQ(tp.y, expected_p.y);
+        ASSERT_EQ(tp.z, expected_p.z);
+        const auto tv = a * v;
+        const auto expected_v = Detail::transform_scalar(a, v);
+        ASSERT_EQ(tv.x, expected_v.x);
+        ASSERT_EQ(tv.y, expected_v.y);
+        ASSERT_EQ(tv.z, expected_v.z);
+        const auto r = a * ray(p, v);
+        ASSERT_EQ(r.origin.x, expected_p.x);
+        ASSERT_EQ(r.direction.z, expected_v.z);
+        const auto inv = inverse(a);
+        const auto expected_inv = Detail::inverse_scalar(a);
+        for (uint8_t j = 0; j < inv.size(); ++j) {
+            ASSERT_NEAR(inv[j], expected_inv[j], 1e-5f); //a different formula, so only equal within rounding
+        }
+        ASSERT_EQ(a * inverse(a), Matrix4Identity);
+    }
+}
+
+TEST(Matrix, Matrix4KernelsAreConstexpr) {
+    static_assert(translation(1, 2, 3) * point(1, 1, 1) == point(2, 3, 4));
+    static_assert(scaling(2, 2, 2) * vector(1, 2, 3) == vector(2, 4, 6));
+    static_assert(inverse(scaling(2, 4, 8))[5] == 0.25f);
+    static_assert(inverse(translation(1, 2, 3))[7] == -2.0f);
+    static_assert((translation(1, 0, 0) * translation(0, 1, 0))[7] == 1.0f);
+}
+
+//a microbenchmark for the Matrix4 hot paths, SIMD against the scalar reference. Build optimized, run with --gtest_also_run_disabled_tests.
+TEST(DISABLED_Matrix4Benchmark, SimdVersusScalar) {
+    constexpr size_t COUNT = 4096;
+    constexpr size_t ROUNDS = 200;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<Real> coord(-50.0f, 50.0f);
+    std::vector<Matrix4> matrices(COUNT);
+    std::vector<Point> points(COUNT);
+    std::ranges::generate(matrices, [&rng]() { return random_transform(rng); });
+    std::ranges::generate(points, [&]() { return point(coord(rng), coord(rng), coord(rng)); });
+
+    const auto measure = [](std::string_view name, auto&& kernel) {
+        Real sink = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < ROUNDS; ++round) {
+            for (size_t i = 0; i < COUNT; ++i) {
+                sink += kernel(i);
+            }
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << std::format("{:<28} {:8.2f} ns/op (checksum {})\n", name, elapsed.count() / (COUNT * ROUNDS), sink);
+    };
+    const auto next = [](size_t i) noexcept { return (i + 1) % COUNT; };
+    const auto total = [](const Matrix4& m) noexcept { return std::accumulate(m.begin(), m.end(), Real{ 0 }); };
+    measure("Matrix4 * Matrix4 (scalar)", [&](size_t i) { return total(Detail::multiply_scalar(matrices[i], matrices[next(i)])); });
+    measure("Matrix4 * Matrix4", [&](size_t i) { return total(matrices[i] * matrices[next(i)]); });
+    const auto sum = [](const auto& t) noexcept { return t.x + t.y + t.z; }; //use every component, so none of the work is optimized away
+    measure("Matrix4 * Point (scalar)", [&](size_t i) { return sum(Detail::transform_scalar(matrices[i], points[i])); });
+    measure("Matrix4 * Point", [&](size_t i) { return sum(matrices[i] * points[i]); });
+    measure("Matrix4 * Ray (scalar)", [&](size_t i) {
+        return sum(Detail::transform_scalar(matrices[i], points[i])) + sum(Detail::transform_scalar(matrices[i], vector(points[next(i)]))); });
+    measure("Matrix4 * Ray", [&](size_t i) { const auto r = matrices[i] * ray(points[i], vector(points[next(i)])); return sum(r.origin) + sum(r.direction); });
+    measure("inverse(Matrix4) (scalar)", [&](size_t i) { return total(Detail::inverse_scalar(matrices[i])); });
+    measure("inverse(Matrix4)", [&](size_t i) { return total(inverse(matrices[i])); });
+    std::cout << "RTC_SIMD=" << RTC_SIMD << "\n";
+}
+
 RESTORE_WARNINGS
\ No newline at end of file
@@ -0,0 +1,206 @@
+#pragma once
+#include "../pch.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "../ObjLoader.h"
+#include "../World.h"
+#include "../Intersection.h"
+
+DISABLE_WARNINGS_FROM_GTEST
+
+//a size x size grid of quads as OBJ text, in the xz plane. Each row of quads is a group; odd rows have normals.
+static std::string grid_obj(size_t size) {
+    std::string obj = "# a grid\n";
+    for (size_t z = 0; z <= size; ++z) {
+        for (size_t x = 0; x <= size; ++x) {
+            obj += std::format("v {} 0 {}\n"sv, Real(x) / Real(size) * 2.0f - 1.0f, Real(z) / Real(size) * 2.0f - 1.0f);
+        }
+    }
+    obj += "vn 0 1 0\n";
+    const auto at = [size](size_t x, size_t z) noexcept { return z * (size + 1) + x + 1; };
+    for (size_t z = 0; z < size; ++z) {
+        obj += std::format("g row{}\n"sv, z);
+        for (size_t x = 0; x < size; ++x) {
+            if (z % 2 == 0) {
+                obj += std::format("f {} {} {} {}\n"sv, at(x, z), at(x + 1, z), at(x + 1, z + 1), at(x, z + 1));
+            } else {
+                obj += std::format("f {}//1 {}//1 {}//1 {}//1\n"sv, at(x, z), at(x + 1, z), at(x + 1, z + 1), at(x, z + 1));
+            }
+        }
+    }
+    return obj;
+}
+
+static constexpr Triangle face(uint32_t p1, uint32_t p2, uint32_t p3) noexcept {
+    return Triangle{ { p1, p2, p3 } };
+}
+
+TEST(Obj, ignoresUnrecognizedLines) {
+    const auto gibberish = "There was a young lady named Bright\n"
+        "who traveled much faster than light.\n"
+        "She set out one day\n"
+        "in a relative way,\n"
+        "and came back the previous night.\n"sv;
+    const auto model = parse_obj(gibberish);
+    EXPECT_EQ(model.ignored_lines, 5);
+    EXPECT_TRUE(model.mesh.vertices.empty());
+    EXPECT_EQ(model.mesh.size(), 0);
+}
+
+TEST(Obj, vertexRecords) {
+    const auto model = parse_obj("v -1 1 0\nv -1.0000 0.5000 0.0000\nv 1 0 0\nv 1 1 0\n"sv);
+    ASSERT_EQ(model.mesh.vertices.size(), 4);
+    EXPECT_EQ(model.mesh.vertices[0], point(-1, 1, 0));
+    EXPECT_EQ(model.mesh.vertices[1], point(-1, 0.5f, 0));
+    EXPECT_EQ(model.mesh.vertices[2], point(1, 0, 0));
+    EXPECT_EQ(model.mesh.vertices[3], point(1, 1, 0));
+}
+
+TEST(Obj, triangleFaces) {
+    const auto model = parse_obj("v -1 1 0\nv -1 0 0\nv 1 0 0\nv 1 1 0\n\nf 1 2 3\nf 1 3 4\n"sv);
+    ASSERT_EQ(model.mesh.triangles.size(), 2);
+    EXPECT_EQ(model.mesh.triangles[0], face(0, 1, 2));
+    EXPECT_EQ(model.mesh.triangles[1], face(0, 2, 3));
+}
+
+TEST(Obj, triangulatesPolygons) {
+    const auto model = parse_obj("v -1 1 0\nv -1 0 0\nv 1 0 0\nv 1 1 0\nv 0 2 0\n\nf 1 2 3 4 5\n"sv);
+    ASSERT_EQ(model.mesh.triangles.size(), 3);
+    EXPECT_EQ(model.mesh.triangles[0], face(0, 1, 2));
+    EXPECT_EQ(model.mesh.triangles[1], face(0, 2, 3));
+    EXPECT_EQ(model.mesh.triangles[2], face(0, 3, 4));
+}
+
+TEST(Obj, trianglesInGroups) {
+    const auto model = parse_obj("v -1 1 0\nv -1 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\ng FirstGroup\nf 1 2 3\ng SecondGroup\nf 1 3 4\n"sv);
+    ASSERT_EQ(model.groups.size(), 3);
+    EXPECT_EQ(model.groups[0].name, ""sv); //the default group
+    EXPECT_EQ(model.groups[0].size(), 1);
+    EXPECT_EQ(model.groups[1].name, "FirstGroup"sv);
+    EXPECT_EQ(model.groups[2].name, "SecondGroup"sv);
+    ASSERT_EQ(model.groups[1].triangle_count, 1);
+    ASSERT_EQ(model.groups[2].triangle_count, 1);
+    EXPECT_EQ(model.mesh.triangles[model.groups[1].first_triangle], face(0, 1, 2));
+    EXPECT_EQ(model.mesh.triangles[model.groups[2].first_triangle], face(0, 2, 3));
+    const auto second = group_mesh(model, 2);
+    ASSERT_EQ(second.vertices.size(), 3); //only the corners it uses
+    EXPECT_EQ(second.triangles[0], face(0, 1, 2));
+    EXPECT_EQ(second.vertices[1], point(1, 0, 0));
+}
+
+TEST(Obj, vertexNormalRecords) {
+    const auto model = parse_obj("vn 0 0 1\nvn 0.707 0 -0.707\nvn 1 2 3\n"sv);
+    ASSERT_EQ(model.mesh.normals.size(), 3);
+    EXPECT_EQ(model.mesh.normals[0], vector(0, 0, 1));
+    EXPECT_EQ(model.mesh.normals[1], vector(0.707f, 0, -0.707f));
+    EXPECT_EQ(model.mesh.normals[2], vector(1, 2, 3));
+}
+
+TEST(Obj, facesWithNormals) {
+    const auto model = parse_obj("v 0 1 0\nv -1 0 0\nv 1 0 0\n\nvn -1 0 0\nvn 1 0 0\nvn 0 1 0\n\nf 1//3 2//1 3//2\nf 1/0/3 2/102/1 3/14/2\n"sv);
+    ASSERT_EQ(model.mesh.smooth_triangles.size(), 2);
+    const auto expected = SmoothTriangle{ { 0, 1, 2 }, { 2, 0, 1 } };
+    EXPECT_EQ(model.mesh.smooth_triangles[0], expected);
+    EXPECT_EQ(model.mesh.smooth_triangles[1], expected);
+    EXPECT_TRUE(model.mesh.triangles.empty());
+}
+
+TEST(Obj, negativeIndicesCountBackFromTheirLine) {
+    const auto model = parse_obj("v 0 0 0\r\nv 1 0 0 # a comment\r\nv 0 1 0\r\nf -3 -2 -1\r\nv 0 0 1\r\nf -1 -3 -2\r\n# the end"sv);
+    ASSERT_EQ(model.mesh.triangles.size(), 2);
+    EXPECT_EQ(model.mesh.triangles[0], face(0, 1, 2));
+    EXPECT_EQ(model.mesh.triangles[1], face(3, 1, 2));
+    EXPECT_EQ(model.mesh.vertices[3], point(0, 0, 1));
+    EXPECT_EQ(model.ignored_lines, 0);
+}
+
+TEST(Obj, throwsForMalformedRecords) {
+    EXPECT_THROW(parse_obj("v 1 x 0\n"sv), obj_parse_error);
+    EXPECT_THROW(parse_obj("v 1 0\n"sv), obj_parse_error);
+    EXPECT_THROW(parse_obj("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n"sv), obj_parse_error); //no fourth vertex
+    EXPECT_THROW(parse_obj("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 0 1 2\n"sv), obj_parse_error); //indices count from 1
+    EXPECT_THROW(parse_obj("v 0 0 0\nv 1 0 0\nv 0 1 0\nf -4 -2 -1\n"sv), obj_parse_error);
+    EXPECT_THROW(parse_obj("v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3\n"sv), obj_parse_error); //half smooth
+    EXPECT_NO_THROW(parse_obj("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2\nf 1 2 3\n"sv)); //too few corners: no face
+}
+
+TEST(Obj, parsesManyChunksInParallel) {
+    const auto obj = grid_obj(40);
+    ASSERT_GT(line_chunk_starts(obj, 256).size(), 16);
+    const auto whole = parse_obj(obj, obj.size() + 1);
+    const auto chunked = parse_obj(obj, 256);
+    EXPECT_EQ(whole.mesh.vertices.size(), 41 * 41);
+    EXPECT_EQ(whole.mesh.triangles.size(), 40 * 20 * 2); //the even rows, two triangles a quad
+    EXPECT_EQ(whole.mesh.smooth_triangles.size(), 40 * 20 * 2);
+    EXPECT_EQ(whole.groups.size(), 41);
+    EXPECT_EQ(chunked.mesh.vertices, whole.mesh.vertices);
+    EXPECT_EQ(chunked.mesh.normals, whole.mesh.normals);
+    EXPECT_EQ(chunked.mesh.triangles, whole.mesh.triangles);
+    EXPECT_EQ(chunked.mesh.smooth_triangles, whole.mesh.smooth_triangles);
+    ASSERT_EQ(chunked.groups.size(), whole.groups.size());
+    for (size_t g = 0; g < whole.groups.size(); ++g) {
+        EXPECT_EQ(chunked.groups[g].name, whole.groups[g].name);
+        EXPECT_EQ(chunked.groups[g].first_triangle, whole.groups[g].first_triangle);
+        EXPECT_EQ(chunked.groups[g].triangle_count, whole.groups[g].triangle_count);
+        EXPECT_EQ(chunked.groups[g].first_smooth_triangle, whole.groups[g].first_smooth_triangle);
+        EXPECT_EQ(chunked.groups[g].smooth_triangle_count, whole.groups[g].smooth_triangle_count);
+    }
+    EXPECT_EQ(whole.groups[3].triangle_count, 80); //row 2 is flat
+    EXPECT_EQ(whole.groups[4].smooth_triangle_count, 80); //and row 3 smooth
+    EXPECT_EQ(whole.groups[4].triangle_count, 0);
+}
+
+TEST(Obj, loadsFromAFileIntoAScene) {
+    const auto path = (std::filesystem::temp_directory_path() / "obj_grid.obj").string();
+    {
+        std::ofstream ofs(path, std::ofstream::binary);
+        ofs << grid_obj(8);
+    }
+    const auto model = load_obj(path);
+    std::filesystem::remove(path);
+    EXPECT_EQ(model.mesh.size(), 128);
+    auto w = World({});
+    const auto red = w.add_material(material(color(1, 0, 0)));
+    SceneGraph graph;
+    const auto node = add_obj(graph, ROOT_NODE, model, translation(0, 1, 0), red);
+    EXPECT_EQ(graph.shapes().size(), 8); //a mesh for each row, and none for the empty default group
+    w.add_scene(graph);
+    const auto r = ray(point(0.3f, 5, 0.3f), vector(0, -1, 0));
+    const auto hit = closest_hit(w, r);
+    ASSERT_TRUE(hit);
+    EXPECT_FLOAT_EQ(hit.t, 4.0f);
+    EXPECT_EQ(w.material_at(hit.material_id()).color, color(1, 0, 0));
+    EXPECT_EQ(normal_at(hit, position(r, hit.t)), vector(0, 1, 0));
+    EXPECT_EQ(graph[node].world_transform, affine(translation(0, 1, 0)));
+    graph = SceneGraph();
+    EXPECT_FLOAT_EQ(closest_hit(w, r).t, 4.0f); //the World keeps the graph's meshes
+
+    auto whole = ObjModel(model);
+    auto one = World({});
+    one.push_back(mesh(one.add_mesh(build_mesh(std::move(whole.mesh))), translation(0, 1, 0)));
+    EXPECT_FLOAT_EQ(closest_hit(one, r).t, 4.0f);
+    EXPECT_THROW(load_obj(path), std::runtime_error);
+}
+
+TEST(DISABLED_Obj, LoadThroughput) {
+    using clock = std::chrono::steady_clock;
+    const auto path = (std::filesystem::temp_directory_path() / "obj_throughput.obj").string();
+    {
+        std::ofstream ofs(path, std::ofstream::binary);
+        ofs << grid_obj(1000);
+    }
+    const auto megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+    for (const auto chunk_size : { std::numeric_limits<size_t>::max(), OBJ_BYTES_PER_TASK }) {
+        const auto start = clock::now();
+        const auto model = chunk_size == OBJ_BYTES_PER_TASK ? load_obj(path) : parse_obj(MappedFile(path).view(), chunk_size);
+        const std::chrono::duration<double> seconds = clock::now() - start;
+        std::cout << (chunk_size == OBJ_BYTES_PER_TASK ? "parallel: " : "one chunk: ") << megabytes << "MB, "
+            << model.mesh.vertices.size() << " vertices, " << model.mesh.size() << " faces in " << seconds.count() * 1000.0 << "ms. "
+            << megabytes / seconds.count() << " MB/s\n";
+    }
+    std::filesystem::remove(path);
+}
+
+RESTORE_WARNINGS
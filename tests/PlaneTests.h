@@ -11,7 +11,7 @@ DISABLE_WARNINGS_FROM_GTEST
 
 TEST(Plane, hasTransform) {
     constexpr auto p = plane();
-    EXPECT_EQ(p.get_transform(), Matrix4Identity);
+    EXPECT_EQ(p.get_transform(), AffineIdentity);
 }
 
 TEST(Plane, normalIsConstantEverywhere) {
@@ -63,4 +63,11 @@ TEST(Plane, intersectWithRayFromBelow) {
     EXPECT_EQ(xs2.object_at(0), p);
 }
 
+TEST(Plane, hasAnInfiniteBoundingBox) {
+    const auto b = local_bounds(plane());
+    EXPECT_TRUE(is_infinite(b));
+    EXPECT_EQ(b.min, point(math::MIN, 0, math::MIN));
+    EXPECT_EQ(b.max, point(math::MAX, 0, math::MAX));
+}
+
 RESTORE_WARNINGS
\ No newline at end of file
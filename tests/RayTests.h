@@ -93,6 +93,28 @@ TEST(Intersections, aggregatesIntersection) {
     EXPECT_EQ(xs[1].t, 2);
 }
 
+TEST(Intersections, spillToTheHeapBeyondTheInlineCapacity) {
+    const Shapes s = sphere();
+    auto xs = intersections();
+    for (size_t i = 0; i < Intersections::INLINE_CAPACITY * 2; ++i) {
+        xs.push_back(intersection(static_cast<Real>(Intersections::INLINE_CAPACITY * 2 - i), s));
+        EXPECT_EQ(xs.is_inline(), xs.size() <= Intersections::INLINE_CAPACITY);
+    }
+    xs.sort();
+    ASSERT_EQ(xs.size(), Intersections::INLINE_CAPACITY * 2);
+    for (Intersections::size_type i = 0; i < xs.size(); ++i) {
+        EXPECT_EQ(xs[i].t, static_cast<Real>(i + 1));
+    }
+    EXPECT_EQ(closest(xs).t, 1.0f);
+}
+
+TEST(intersect, localIntersectReturnsAtMostFourHits) {
+    const auto c = closed_cone(-0.5f, 0.5f);
+    const auto xs = local_intersect(c, ray(point(0, 0, -0.25f), normal_vector(0, 1, 0)));
+    EXPECT_EQ(xs.size(), LocalHits::capacity());
+    EXPECT_EQ(local_intersect(sphere(), ray(point(0, 2, -5), vector(0, 0, 1))), MISS);
+}
+
 TEST(intersect, setsTheObjectOnTheIntersections) {
     const auto r = ray(point(0,0,-5), vector(0,0,1));    
     const Sphere s = sphere();
@@ -106,7 +128,7 @@ TEST(intersect, setsTheObjectOnTheIntersections) {
 }
 
 TEST(closest, returnsClosestIntersection) {    
-    const auto s = sphere();
+    const Shapes s = sphere();
     const auto i1 = intersection(1, s);
     const auto i2 = intersection(2, s);
     const auto xs = intersections(i1, i2);
@@ -116,7 +138,7 @@ TEST(closest, returnsClosestIntersection) {
 }
 
 TEST(closest, returnsClosestPositiveIntersection) {    
-    const auto s = sphere();
+    const Shapes s = sphere();
     const auto i1 = intersection(-1, s);
     const auto i2 = intersection(1, s);
     const auto xs = intersections(i1, i2);
@@ -125,7 +147,7 @@ TEST(closest, returnsClosestPositiveIntersection) {
 }
 
 TEST(closest, returnsEmptyIntersectionIfAllAreNegative) {    
-    const auto s = sphere();
+    const Shapes s = sphere();
     const auto i1 = intersection(-2, s);
     const auto i2 = intersection(-1, s);
     const auto xs = intersections(i1, i2);
@@ -135,7 +157,7 @@ TEST(closest, returnsEmptyIntersectionIfAllAreNegative) {
 }
 
 TEST(closest, canHandleMultipleIntersections) {    
-    const auto s = sphere();
+    const Shapes s = sphere();
     const auto i1 = intersection(5, s);
     const auto i2 = intersection(7, s);
     const auto i3 = intersection(-3, s);
@@ -245,10 +267,11 @@ TEST(Intersections, stateIncludesOverPoint) {
 
 TEST(Intersections, stateIncludesUnderPoint) {
     const auto r = ray(point(0, 0, -5), vector(0, 0, 1));
-    Shapes sh = sphere(glass(), translation(0,0,1));   
+    const std::vector<Material> materials{ material(), glass() };
+    Shapes sh = sphere(MaterialId{ 1 }, translation(0,0,1));   
     const auto i1 = intersection(5, sh);
     const auto xs = intersections({ i1 });
-    const auto hit = prepare_computations(i1, r, xs);
+    const auto hit = prepare_computations(i1, r, xs, materials);
     EXPECT_TRUE(hit);
     EXPECT_GT(hit.under_point.z, std::numeric_limits<Real>::epsilon()/2.0f);
     EXPECT_LT(hit.point.z, hit.under_point.z); 
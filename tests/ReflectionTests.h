@@ -34,8 +34,9 @@ TEST(Reflection, reflectedColorForReflectiveMaterial) {
     constexpr auto sqrt = math::sqrt(2.0f);
     constexpr auto halfSqrt = sqrt / 2.0f;
     auto w = World();
-    Plane p = plane(translation(0,-1,0));
-    p.surface().reflective = 0.5f;
+    auto surface = material();
+    surface.reflective = 0.5f;
+    Plane p = plane(w.add_material(surface), translation(0,-1,0));
     w.push_back(std::move(p));
     const auto r = ray(point(0, 0, -3), vector(0, -halfSqrt, halfSqrt));    
     const auto ix = intersection(sqrt, w.back());
@@ -49,8 +50,9 @@ TEST(Reflection, shadowsCanBlendWithReflections) {
     constexpr auto sqrt = math::sqrt(2.0f);
     constexpr auto halfSqrt = sqrt / 2.0f;
     auto w = World();
-    Plane p = plane(translation(0,-1,0));
-    p.surface().reflective = 0.5f;
+    auto surface = material();
+    surface.reflective = 0.5f;
+    Plane p = plane(w.add_material(surface), translation(0,-1,0));
     w.push_back(std::move(p));
     const auto r = ray(point(0, 0, -3), vector(0, -halfSqrt, halfSqrt));    
     const auto ix = intersection(sqrt, w.back());
@@ -61,9 +63,10 @@ TEST(Reflection, shadowsCanBlendWithReflections) {
 }
 
 TEST(Reflection, canHandleInfiniteRecursion) {       
-    auto lower = plane(mirror(), translation(0,-1,0));    
-    auto upper = plane(mirror(), translation(0,1,0));    
+    auto lower = plane(translation(0,-1,0));    
+    auto upper = plane(translation(0,1,0));    
     auto w = World({lower, upper});
+    w.edit_material(DEFAULT_MATERIAL_ID) = mirror();
     w.light = point_light(ORIGO, color(1, 1, 1));    
     const auto r = ray(ORIGO, vector(0,1,0)); 
     const auto c = color_at(w, r); 
@@ -74,8 +77,9 @@ TEST(Reflection, canLimitRecursion) {
     constexpr auto sqrt = math::sqrt(2.0f);
     constexpr auto halfSqrt = sqrt / 2.0f;
     auto w = World();
-    Plane p = plane(translation(0,-1,0));
-    p.surface().reflective = 0.5f;
+    auto surface = material();
+    surface.reflective = 0.5f;
+    Plane p = plane(w.add_material(surface), translation(0,-1,0));
     w.push_back(std::move(p));
     const auto r = ray(point(0, 0, -3), vector(0, -halfSqrt, halfSqrt));    
     const auto ix = intersection(sqrt, w.back());
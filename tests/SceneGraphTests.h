@@ -0,0 +1,201 @@
+#pragma once
+#include "../pch.h"
+#include "../Tuple.h"
+#include "../Matrix.h"
+#include "../SceneGraph.h"
+#include "../World.h"
+#include "../Ray.h"
+#include "../Intersection.h"
+#include "../CompiledScene.h"
+DISABLE_WARNINGS_FROM_GTEST
+
+TEST(SceneGraph, ANewGraphIsJustTheRoot) {
+    SceneGraph g;
+    EXPECT_EQ(g.size(), 1);
+    EXPECT_TRUE(g.shapes().empty());
+    EXPECT_TRUE(g[ROOT_NODE].is_group());
+    EXPECT_EQ(g[ROOT_NODE].parent, NO_NODE);
+    EXPECT_EQ(g[ROOT_NODE].transform, AffineIdentity);
+    EXPECT_EQ(g[ROOT_NODE].world_transform, AffineIdentity);
+}
+
+TEST(SceneGraph, CanParentShape) {
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE);
+    const auto s = g.add_shape(group, sphere());
+    EXPECT_EQ(g[s].parent, group);
+    EXPECT_FALSE(g[s].is_group());
+    ASSERT_EQ(g.shapes().size(), 1);
+    EXPECT_TRUE(g.shape(s) == Shapes{ sphere() });
+}
+
+TEST(SceneGraph, IntersectingRayWithEmptyGroup) {
+    SceneGraph g;
+    g.add_group(ROOT_NODE);
+    World w({});
+    w.add_scene(g);
+    EXPECT_TRUE(intersect(w, ray(point(0, 0, 0), vector(0, 0, 1))).empty());
+}
+
+TEST(SceneGraph, IntersectingRayWithNonEmptyGroup) {
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE);
+    g.add_shape(group, sphere());
+    g.add_shape(group, sphere(translation(0, 0, -3)));
+    g.add_shape(group, sphere(translation(5, 0, 0)));
+    World w({});
+    w.add_scene(g);
+    const auto xs = intersect(w, ray(point(0, 0, -5), vector(0, 0, 1)));
+    ASSERT_EQ(xs.size(), 4);
+    EXPECT_EQ(xs[0].objPtr, &w.objects()[1]);
+    EXPECT_EQ(xs[1].objPtr, &w.objects()[1]);
+    EXPECT_EQ(xs[2].objPtr, &w.objects()[0]);
+    EXPECT_EQ(xs[3].objPtr, &w.objects()[0]);
+}
+
+TEST(SceneGraph, IntersectingTransformedGroup) {
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE, scaling(2, 2, 2));
+    g.add_shape(group, sphere(translation(5, 0, 0)));
+    World w({});
+    w.add_scene(g);
+    EXPECT_EQ(intersect(w, ray(point(10, 0, -10), vector(0, 0, 1))).size(), 2);
+}
+
+TEST(SceneGraph, ConvertingPointFromWorldToObjectSpace) {
+    SceneGraph g;
+    const auto g1 = g.add_group(ROOT_NODE, rotation_y(math::HALF_PI));
+    const auto g2 = g.add_group(g1, scaling(2, 2, 2));
+    const auto s = g.add_shape(g2, sphere(translation(5, 0, 0)));
+    const auto p = g.world_to_object(s, point(-2, 0, -10));
+    EXPECT_NEAR(p.x, 0.0f, math::BOOK_EPSILON);
+    EXPECT_NEAR(p.y, 0.0f, math::BOOK_EPSILON);
+    EXPECT_NEAR(p.z, -1.0f, math::BOOK_EPSILON);
+}
+
+TEST(SceneGraph, NormalOnChildObjectIsInWorldSpace) {
+    SceneGraph g;
+    const auto g1 = g.add_group(ROOT_NODE, rotation_y(math::HALF_PI));
+    const auto g2 = g.add_group(g1, scaling(1, 2, 3));
+    const auto s = g.add_shape(g2, sphere(translation(5, 0, 0)));
+    const auto n = normal_at(std::get<Sphere>(g.shape(s)), point(1.7321f, 1.1547f, -5.5774f));
+    EXPECT_NEAR(n.x, 0.2857f, math::BOOK_EPSILON); //the book's 4 decimals
+    EXPECT_NEAR(n.y, 0.4286f, math::BOOK_EPSILON);
+    EXPECT_NEAR(n.z, -0.8571f, math::BOOK_EPSILON);
+}
+
+TEST(SceneGraph, WorldTransformsAreCachedPerNode) {
+    SceneGraph g;
+    const auto outer = g.add_group(ROOT_NODE, translation(1, 0, 0));
+    const auto inner = g.add_group(outer, translation(0, 2, 0));
+    const auto s = g.add_shape(inner, sphere(translation(0, 0, 3)));
+    EXPECT_EQ(g[inner].world_transform, affine(translation(1, 2, 0)));
+    EXPECT_EQ(g[s].world_transform, affine(translation(1, 2, 3)));
+    EXPECT_EQ(get_transform(g.shape(s)), affine(translation(1, 2, 3)));
+    EXPECT_EQ(g[s].transform, affine(translation(0, 0, 3))); //the shape's own, relative to its group
+    EXPECT_EQ(g[s].world_inverse, affine(translation(-1, -2, -3)));
+    g.set_transform(outer, translation(4, 0, 0));
+    g.update();
+    EXPECT_EQ(g[s].world_inverse, affine(translation(-4, -2, -3)));
+    EXPECT_EQ(g.world_to_object(inner, point(4, 2, 0)), point(0, 0, 0));
+}
+
+TEST(SceneGraph, UpdateMovesEverythingBelowAChangedNode) {
+    SceneGraph g;
+    const auto left = g.add_group(ROOT_NODE, translation(-5, 0, 0));
+    const auto right = g.add_group(ROOT_NODE, translation(5, 0, 0));
+    const auto a = g.add_shape(left, sphere());
+    const auto b = g.add_shape(right, sphere());
+    g.set_transform(left, translation(-5, 1, 0));
+    EXPECT_FALSE(g.is_current());
+    g.update();
+    EXPECT_TRUE(g.is_current());
+    EXPECT_EQ(get_transform(g.shape(a)), affine(translation(-5, 1, 0)));
+    EXPECT_EQ(get_transform(g.shape(b)), affine(translation(5, 0, 0)));
+    g.set_transform(ROOT_NODE, scaling(2, 2, 2)); //moves the whole scene
+    g.update();
+    EXPECT_EQ(get_transform(g.shape(a)), affine(scaling(2, 2, 2) * translation(-5, 1, 0)));
+    EXPECT_EQ(get_transform(g.shape(b)), affine(scaling(2, 2, 2) * translation(5, 0, 0)));
+}
+
+TEST(SceneGraph, AnimatesInAWorld) {
+    SceneGraph g;
+    const auto arm = g.add_group(ROOT_NODE);
+    g.add_shape(arm, sphere(translation(3, 0, 0)));
+    g.add_shape(arm, cube(translation(6, 0, 0)));
+    auto w = World({ plane(translation(0, -1, 0)) });
+    const auto range = w.add_scene(g);
+    w.push_back(sphere(translation(0, 0, 20)));
+    EXPECT_EQ(range.first, 1u);
+    EXPECT_EQ(range.count, 2u);
+    const auto down_to = [](Real x, Real z) noexcept { return ray(point(x, 10, z), vector(0, -1, 0)); };
+    for (auto frame = 0; frame <= 4; ++frame) {
+        const auto angle = Real(frame) * math::HALF_PI / 4.0f; //swings the arm from +x to -z
+        g.set_transform(arm, rotation_y(angle));
+        g.update();
+        w.replace_scene(range, g);
+        w.build();
+        ASSERT_EQ(w.size(), 4u);
+        const auto ball = rotation_y(angle) * point(3, 0, 0);
+        const auto hit = closest_hit(w, down_to(ball.x, ball.z));
+        ASSERT_TRUE(hit) << "frame " << frame;
+        EXPECT_EQ(hit.objPtr, &w.objects()[1]);
+        EXPECT_NEAR(hit.t, 9.0f, 1e-4f);
+        EXPECT_EQ(w[0], Shapes{ plane(translation(0, -1, 0)) }); //the objects around the range stay
+        EXPECT_EQ(w[3], Shapes{ sphere(translation(0, 0, 20)) });
+    }
+    EXPECT_EQ(closest_hit(w, down_to(3, 0)).objPtr, &w.objects()[0]); //the arm has swung away from where it started
+}
+
+TEST(SceneGraph, CopiesAreIndependent) {
+    static_assert(std::is_trivially_copyable_v<SceneNode>);
+    static_assert(std::is_trivially_copyable_v<Shapes>);
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE);
+    const auto s = g.add_shape(group, sphere());
+    auto moved = g; //no node points at another, so a copy needs no fixing up
+    moved.set_transform(group, translation(0, 4, 0));
+    moved.update();
+    EXPECT_EQ(get_transform(moved.shape(s)), affine(translation(0, 4, 0)));
+    EXPECT_EQ(get_transform(g.shape(s)), AffineIdentity);
+}
+
+TEST(SceneGraph, WorldQueriesSeeTheGraphsShapes) {
+    auto w = World({ plane(translation(0, -1, 0)) });
+    const auto red = w.add_material(material(color(1, 0, 0)));
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE, translation(0, 0, 3));
+    g.add_shape(group, sphere(red, translation(-1.5f, 0, 0)));
+    g.add_shape(group, sphere(translation(1.5f, 0, 0)));
+    w.add_scene(g);
+    const auto hit = closest_hit(w, ray(point(1.5f, 0, -5), vector(0, 0, 1)));
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit.objPtr, &w.objects()[2]);
+    EXPECT_FLOAT_EQ(hit.t, 7.0f);
+    EXPECT_EQ(normal_at(hit, point(1.5f, 0, 2)), vector(0, 0, -1));
+    EXPECT_TRUE(occluded(w, ray(point(-1.5f, 0, -5), vector(0, 0, 1)), 10.0f));
+    EXPECT_FALSE(occluded(w, ray(point(0, 0, -5), vector(0, 0, 1)), 10.0f));
+    const auto scene = compile(w);
+    const auto r = ray(point(-1.5f, 0, -5), vector(0, 0, 1));
+    const auto compiled = closest_hits(scene, RayPacket{ r, r, r, r })[0];
+    EXPECT_EQ(compiled.objPtr, &w.objects()[1]);
+    EXPECT_EQ(compiled.material_id(), red);
+    EXPECT_EQ(w.material_at(compiled.material_id()).color, color(1, 0, 0));
+}
+
+TEST(SceneGraph, ChildrenWithoutAMaterialWearTheGroups) {
+    constexpr MaterialId blue = 1, red = 2; //in the table of the World the graph is added to
+    SceneGraph g;
+    const auto group = g.add_group(ROOT_NODE, Matrix4Identity, blue);
+    const auto inner = g.add_group(group);
+    const auto plain = g.add_shape(inner, sphere());
+    const auto own = g.add_shape(group, sphere(red));
+    EXPECT_EQ(material_id(g.shape(plain)), blue);
+    EXPECT_EQ(material_id(g.shape(own)), red);
+    g.set_material(group, DEFAULT_MATERIAL_ID);
+    g.update();
+    EXPECT_EQ(material_id(g.shape(plain)), DEFAULT_MATERIAL_ID);
+    EXPECT_EQ(material_id(g.shape(own)), red);
+}
+
+RESTORE_WARNINGS
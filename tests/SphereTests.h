@@ -8,7 +8,7 @@ DISABLE_WARNINGS_FROM_GTEST
 
 TEST(Sphere, hasTransform) {
     const auto s = sphere();
-    EXPECT_EQ(s.get_transform(), Matrix4Identity);
+    EXPECT_EQ(s.get_transform(), AffineIdentity);
     EXPECT_EQ(s.inv_transform(), inverse(s.get_transform()));
 }
 
@@ -67,15 +67,20 @@ TEST(Sphere, normalOnTransformedSphere) {
 
 TEST(Sphere, hasADefaultMaterial) {    
     constexpr auto s = sphere();    
-    EXPECT_EQ(s.surface(), material());
+    EXPECT_EQ(s.material_id(), DEFAULT_MATERIAL_ID);
 }
 
 TEST(Sphere, canBeAssignedMaterial) {    
     auto s = sphere();    
-    auto surface = material();
-    surface.ambient = 1.0f;
-    s.surface() = surface;
-    EXPECT_EQ(s.surface(), surface);
+    s.set_material(MaterialId{ 2 });
+    EXPECT_EQ(s.material_id(), 2u);
+}
+
+TEST(Sphere, hasABoundingBox) {
+    const auto b = local_bounds(sphere());
+    EXPECT_EQ(b.min, point(-1, -1, -1));
+    EXPECT_EQ(b.max, point(1, 1, 1));
+    EXPECT_FALSE(is_infinite(b));
 }
 
 RESTORE_WARNINGS
\ No newline at end of file
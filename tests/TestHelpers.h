@@ -0,0 +1,13 @@
+#pragma once
+#include "../pch.h"
+#include "../Matrix.h"
+#include <random>
+
+//a translation, two rotations, a shear and a non-uniform scale: an affine transform exercising every element.
+inline Matrix4 random_transform(std::mt19937& rng) {
+    std::uniform_real_distribution<Real> angle(-math::PI, math::PI);
+    std::uniform_real_distribution<Real> scale(0.25f, 4.0f);
+    std::uniform_real_distribution<Real> offset(-10.0f, 10.0f);
+    return translation(offset(rng), offset(rng), offset(rng)) * rotation_y(angle(rng)) * rotation_x(angle(rng)) *
+        shearing(0.1f, 0.0f, 0.2f, 0.0f, 0.0f, 0.3f) * scaling(scale(rng), scale(rng), scale(rng));
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "../pch.h"
+#include "../ThreadPool.h"
+
+DISABLE_WARNINGS_FROM_GTEST
+
+TEST(ThreadPool, parallelForVisitsEveryIndexExactlyOnce) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.thread_count(), 4);
+    for (const size_t grain : { 1, 7, 64, 1000, 5000 }) {
+        std::vector<std::atomic<int>> visits(1000);
+        pool.parallel_for(visits.size(), grain, [&visits, grain](size_t begin, size_t end) noexcept {
+            EXPECT_LE(end - begin, grain);
+            for (auto i = begin; i < end; ++i) {
+                visits[i].fetch_add(1);
+            }
+        });
+        EXPECT_TRUE(std::ranges::all_of(visits, [](const auto& v) { return v.load() == 1; }));
+    }
+}
+
+TEST(ThreadPool, canBeReusedForManyJobs) {
+    ThreadPool pool(3);
+    std::atomic<size_t> sum{ 0 };
+    for (size_t job = 0; job < 200; ++job) {
+        pool.parallel_for(100, 3, [&sum](size_t begin, size_t end) noexcept {
+            for (auto i = begin; i < end; ++i) {
+                sum.fetch_add(i);
+            }
+        });
+    }
+    EXPECT_EQ(sum.load(), 200 * (99 * 100 / 2));
+}
+
+TEST(ThreadPool, singleThreadedPoolRunsInline) {
+    ThreadPool pool(1);
+    const auto caller = std::this_thread::get_id();
+    pool.parallel_for(100, 1, [caller](size_t, size_t) noexcept {
+        EXPECT_EQ(std::this_thread::get_id(), caller);
+    });
+}
+
+TEST(ThreadPool, nestedParallelForRunsInlineInsteadOfDeadlocking) {
+    ThreadPool pool(4);
+    std::atomic<size_t> count{ 0 };
+    pool.parallel_for(16, 1, [&pool, &count](size_t, size_t) noexcept {
+        pool.parallel_for(16, 1, [&count](size_t begin, size_t end) noexcept {
+            count.fetch_add(end - begin);
+        });
+    });
+    EXPECT_EQ(count.load(), 16 * 16);
+}
+
+RESTORE_WARNINGS
@@ -0,0 +1,94 @@
+#pragma once
+#include "../pch.h"
+#include <condition_variable>
+#include <optional>
+#include <thread>
+#include "../TileScheduler.h"
+
+DISABLE_WARNINGS_FROM_GTEST
+
+TEST(TileScheduler, gridCoversTheImageWithEdgeTilesCutShort) {
+    const auto grid = tile_grid(40, 20, 16);
+    EXPECT_EQ(grid.columns(), 3);
+    EXPECT_EQ(grid.rows(), 2);
+    EXPECT_EQ(grid.size(), 6);
+    EXPECT_EQ(grid[0], (Tile{ 0, 0, 16, 16 }));
+    EXPECT_EQ(grid[2], (Tile{ 32, 0, 8, 16 }));
+    EXPECT_EQ(grid[5], (Tile{ 32, 16, 8, 4 }));
+}
+
+TEST(TileScheduler, pixelsOfATileAreVisitedInScanlineOrder) {
+    std::vector<Pixel> visited;
+    for (const auto p : pixels(Tile{ 4, 10, 3, 2 })) {
+        visited.push_back(p);
+    }
+    const std::vector<Pixel> expected{ {4, 10}, {5, 10}, {6, 10}, {4, 11}, {5, 11}, {6, 11} };
+    EXPECT_EQ(visited, expected);
+    EXPECT_EQ(pixels(Tile{ 4, 10, 3, 2 }).size(), 6);
+}
+
+TEST(TileScheduler, emptyTilesHaveNoPixels) {
+    EXPECT_EQ(pixels(Tile{ 4, 10, 0, 2 }).begin(), pixels(Tile{ 4, 10, 0, 2 }).end());
+    EXPECT_EQ(pixels(Tile{ 4, 10, 3, 0 }).begin(), pixels(Tile{ 4, 10, 3, 0 }).end());
+}
+
+TEST(TileScheduler, scanlineIsOneRowOfTheImage) {
+    const auto row = pixels(scanline(7, 5));
+    EXPECT_EQ(row.size(), 5);
+    EXPECT_EQ(*row.begin(), (Pixel{ 0, 7 }));
+    EXPECT_TRUE(std::ranges::all_of(row, [](Pixel p) { return p.y == 7 && p.x < 5; }));
+}
+
+TEST(TileScheduler, ownerTakesFromTheFrontThievesFromTheBack) {
+    WorkStealingDeque<int> q;
+    for (int i = 0; i < 4; ++i) {
+        q.push_back(i);
+    }
+    EXPECT_EQ(q.pop_front(), 0);
+    EXPECT_EQ(q.steal(), 3);
+    EXPECT_EQ(q.size(), 2);
+    EXPECT_EQ(q.pop_front(), 1);
+    EXPECT_EQ(q.steal(), 2);
+    EXPECT_FALSE(q.pop_front());
+    EXPECT_FALSE(q.steal());
+}
+
+TEST(TileScheduler, everyPixelIsVisitedExactlyOnce) {
+    ThreadPool pool(4);
+    for (const auto [w, h] : { std::pair{ 1, 1 }, std::pair{ 16, 16 }, std::pair{ 100, 37 }, std::pair{ 37, 100 } }) {
+        std::vector<std::atomic<int>> visits(static_cast<size_t>(w * h));
+        for_each_tile(pool, tile_grid(w, h), [&visits, w](const Tile& tile) noexcept {
+            for (auto y = tile.y; y < tile.y + tile.height; ++y) {
+                for (auto x = tile.x; x < tile.x + tile.width; ++x) {
+                    visits[y * w + x].fetch_add(1);
+                }
+            }
+        });
+        EXPECT_TRUE(std::ranges::all_of(visits, [](const auto& v) { return v.load() == 1; }));
+    }
+}
+
+TEST(TileScheduler, idleThreadsStealFromBusyOnes) {
+    ThreadPool pool(4);
+    const auto grid = tile_grid(256, 256, 16); //256 tiles in 4 runs of 64. the top quarter of the image is the first run
+    std::mutex m;
+    std::condition_variable helped_out;
+    std::optional<std::thread::id> busy; //the thread on the first tile of the top quarter to start
+    bool helped = false; //some other thread has rendered a tile of the top quarter since
+    for_each_tile(pool, grid, [&](const Tile& tile) noexcept {
+        if (tile.y >= 64) {
+            return;
+        }
+        std::unique_lock lock(m);
+        if (!busy) { //'glass and mirrors': the tile takes until another thread has taken over some of the run
+            busy = std::this_thread::get_id();
+            helped_out.wait_for(lock, std::chrono::seconds(30), [&helped]() noexcept { return helped; }); //only times out if nobody steals
+        } else if (std::this_thread::get_id() != *busy) {
+            helped = true;
+            helped_out.notify_all();
+        }
+    });
+    EXPECT_TRUE(helped);
+}
+
+RESTORE_WARNINGS
@@ -0,0 +1,266 @@
+#pragma once
+#include "../pch.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../Triangle.h"
+#include "../Mesh.h"
+#include "../World.h"
+#include "../Intersection.h"
+#include "../HitState.h"
+#include "../Camera.h"
+#include "../CompiledScene.h"
+
+DISABLE_WARNINGS_FROM_GTEST
+
+static constexpr auto P1 = point(0, 1, 0);
+static constexpr auto P2 = point(-1, 0, 0);
+static constexpr auto P3 = point(1, 0, 0);
+
+//the book's triangle, as a mesh of one face. smooth adds the book's normals and makes it a smooth triangle.
+static MeshRef book_triangle(bool smooth = false) {
+    MeshData m;
+    m.vertices = { P1, P2, P3 };
+    if (smooth) {
+        m.normals = { vector(0, 1, 0), vector(-1, 0, 0), vector(1, 0, 0) };
+        m.smooth_triangles = { SmoothTriangle{ { 0, 1, 2 }, { 0, 1, 2 } } };
+    } else {
+        m.triangles = { Triangle{ { 0, 1, 2 } } };
+    }
+    return build_mesh(std::move(m));
+}
+
+//a size x size grid of quads in the xz plane, each split in two, with a bump in the middle.
+static MeshData grid_mesh(uint32_t size) {
+    MeshData m;
+    for (uint32_t z = 0; z <= size; ++z) {
+        for (uint32_t x = 0; x <= size; ++x) {
+            const auto fx = Real(x) / Real(size) * 2.0f - 1.0f;
+            const auto fz = Real(z) / Real(size) * 2.0f - 1.0f;
+            m.vertices.push_back(point(fx, 0.5f - 0.5f * (fx * fx + fz * fz), fz));
+        }
+    }
+    const auto at = [size](uint32_t x, uint32_t z) noexcept { return z * (size + 1) + x; };
+    for (uint32_t z = 0; z < size; ++z) {
+        for (uint32_t x = 0; x < size; ++x) {
+            m.triangles.push_back(Triangle{ { at(x, z), at(x + 1, z), at(x + 1, z + 1) } });
+            m.triangles.push_back(Triangle{ { at(x, z), at(x + 1, z + 1), at(x, z + 1) } });
+        }
+    }
+    return m;
+}
+
+TEST(Triangle, normalIsThePlanesNormal) {
+    EXPECT_EQ(triangle_normal(P1, P2, P3), vector(0, 0, -1));
+    EXPECT_EQ(triangle_bounds(P1, P2, P3), aabb(point(-1, 0, 0), point(1, 1, 0)));
+}
+
+TEST(Triangle, intersectingARayParallelToTheTriangle) {
+    EXPECT_FALSE(intersect_triangle(P1, P2, P3, ray(point(0, -1, -2), vector(0, 1, 0))));
+}
+
+TEST(Triangle, aRayMissesEachEdge) {
+    EXPECT_FALSE(intersect_triangle(P1, P2, P3, ray(point(1, 1, -2), vector(0, 0, 1)))); //p1-p3
+    EXPECT_FALSE(intersect_triangle(P1, P2, P3, ray(point(-1, 1, -2), vector(0, 0, 1)))); //p1-p2
+    EXPECT_FALSE(intersect_triangle(P1, P2, P3, ray(point(0, -1, -2), vector(0, 0, 1)))); //p2-p3
+}
+
+TEST(Triangle, aRayStrikesATriangle) {
+    const auto hit = intersect_triangle(P1, P2, P3, ray(point(0, 0.5f, -2), vector(0, 0, 1)));
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit.t, 2.0f);
+}
+
+TEST(Triangle, meshesOfOneTriangleActLikeTheTriangle) {
+    const auto faces = book_triangle();
+    const Shapes t = mesh(faces);
+    const auto xs = intersect(t, ray(point(0, 0.5f, -2), vector(0, 0, 1)));
+    ASSERT_EQ(xs.size(), 1);
+    EXPECT_EQ(xs[0].t, 2.0f);
+    EXPECT_TRUE(intersect(t, ray(point(1, 1, -2), vector(0, 0, 1))).empty());
+    EXPECT_EQ(normal_at(xs[0], point(0, 0.5f, 0)), vector(0, 0, -1));
+    EXPECT_EQ(normal_at(xs[0], point(-0.5f, 0.75f, 0)), vector(0, 0, -1)); //flat: the same everywhere
+}
+
+TEST(Triangle, meshNormalsNeedTheHit) {
+    static_assert(has_point_normal<Sphere>);
+    static_assert(!has_point_normal<Mesh>); //normal_at(mesh, point) doesn't compile: a point doesn't say which face it's on
+}
+
+TEST(SmoothTriangle, intersectionStoresUAndV) {
+    const auto faces = book_triangle(true);
+    const Shapes tri = mesh(faces);
+    const auto xs = intersect(tri, ray(point(-0.2f, 0.3f, -2), vector(0, 0, 1)));
+    ASSERT_EQ(xs.size(), 1);
+    EXPECT_FLOAT_EQ(xs[0].u, 0.45f);
+    EXPECT_FLOAT_EQ(xs[0].v, 0.25f);
+}
+
+TEST(SmoothTriangle, usesUAndVToInterpolateTheNormal) {
+    const auto faces = book_triangle(true);
+    const Shapes tri = mesh(faces);
+    const auto i = intersection_with_uv(1, tri, 0.45f, 0.25f);
+    const auto n = normal_at(i, point(0, 0, 0));
+    EXPECT_NEAR(n.x, -0.5547f, math::BOOK_EPSILON);
+    EXPECT_NEAR(n.y, 0.83205f, math::BOOK_EPSILON);
+    EXPECT_NEAR(n.z, 0.0f, math::BOOK_EPSILON);
+}
+
+TEST(SmoothTriangle, preparingTheNormal) {
+    const auto faces = book_triangle(true);
+    const Shapes tri = mesh(faces);
+    const auto i = intersection_with_uv(1, tri, 0.45f, 0.25f);
+    const auto r = ray(point(-0.2f, 0.3f, -2), vector(0, 0, 1));
+    const auto state = prepare_computations(i, r, intersections({ i }), std::vector{ material() });
+    EXPECT_NEAR(state.normal.x, -0.5547f, math::BOOK_EPSILON);
+    EXPECT_NEAR(state.normal.y, 0.83205f, math::BOOK_EPSILON);
+    EXPECT_NEAR(state.normal.z, 0.0f, math::BOOK_EPSILON);
+}
+
+TEST(Mesh, isOneSmallShape) {
+    static_assert(sizeof(Mesh) <= sizeof(Sphere) + sizeof(const MeshData*));
+    static_assert(std::is_trivially_copyable_v<Mesh>);
+    const auto id = build_mesh(grid_mesh(8));
+    const auto m = mesh(id, translation(0, 1, 0));
+    EXPECT_EQ(m.data().size(), 128u);
+    EXPECT_EQ(local_bounds(m), aabb(point(-1, -0.5f, -1), point(1, 0.5f, 1)));
+    EXPECT_EQ(bounds_of(Shapes{ m }), aabb(point(-1, 0.5f, -1), point(1, 1.5f, 1)));
+    World w({ m });
+    EXPECT_EQ(w.size(), 1);
+}
+
+TEST(Mesh, theWorldKeepsItsMeshesAlive) {
+    auto ref = build_mesh(grid_mesh(4));
+    const MeshData* data = &*ref;
+    auto w = World({});
+    w.push_back({ mesh(w.add_mesh(ref)), mesh(ref, translation(0, 3, 0)) });
+    EXPECT_EQ(ref.use_count(), 2u);
+    EXPECT_EQ(&std::get<Mesh>(w.objects()[0]).data(), data); //shared, not copied
+    ref = MeshRef{};
+    const auto copy = w;
+    w = World({});
+    EXPECT_EQ(&std::get<Mesh>(copy.objects()[1]).data(), data);
+    EXPECT_EQ(std::get<Mesh>(copy.objects()[1]).data().size(), 32u);
+    EXPECT_EQ(mesh(MeshRef{}).data().size(), 0u); //the empty default
+    EXPECT_EQ(Mesh{}.data().size(), 0u);
+}
+
+TEST(Mesh, bvhFindsTheSameFacesAsTestingEveryOne) {
+    const auto id = build_mesh(grid_mesh(64));
+    const auto& data = *id;
+    std::mt19937 rng(24);
+    std::uniform_real_distribution<Real> pos(-1.5f, 1.5f);
+    auto hits = 0;
+    for (auto i = 0; i < 2000; ++i) {
+        const auto r = ray(point(pos(rng), 2.0f, pos(rng)), normalize(vector(pos(rng), -2.0f, pos(rng))));
+        TriangleHit expected;
+        uint32_t expected_face = 0;
+        for (uint32_t face = 0; face < data.size(); ++face) {
+            const auto [a, b, c] = data.corners(face);
+            const auto hit = intersect_triangle(data.vertices[a], data.vertices[b], data.vertices[c], r);
+            if (hit && hit.t >= 0.0f && hit.t < expected.t) {
+                expected = hit;
+                expected_face = face;
+            }
+        }
+        const auto [face, hit] = nearest_face(data, r, 0.0f, math::MAX);
+        ASSERT_EQ(hit.t, expected.t);
+        if (hit) {
+            ASSERT_EQ(face, expected_face);
+            ++hits;
+        }
+    }
+    EXPECT_GT(hits, 500);
+}
+
+TEST(Mesh, worldQueriesReportTheFace) {
+    const auto id = build_mesh(grid_mesh(16));
+    auto w = World({ mesh(id, translation(0, 1, 0)), sphere(translation(0, 5, 0)) });
+    const auto r = ray(point(0.01f, 10, 0.02f), vector(0, -1, 0));
+    const auto xs = intersect(w, r);
+    ASSERT_EQ(xs.size(), 3);
+    EXPECT_EQ(xs[2].objPtr, &w.objects()[0]);
+    EXPECT_NEAR(xs[2].t, 8.5f, 0.01f); //near the top of the bump
+    const auto hit = closest_hit(w, ray(point(0.9f, 10, 0.5f), vector(0, -1, 0)));
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit.objPtr, &w.objects()[0]);
+    EXPECT_EQ(hit, intersect(w, ray(point(0.9f, 10, 0.5f), vector(0, -1, 0)))[0]);
+    const auto n = prepare_computations(hit, ray(point(0.9f, 10, 0.5f), vector(0, -1, 0))).normal;
+    EXPECT_GT(n.y, 0.5f); //the slope of the bump, facing up and out
+    EXPECT_GT(n.x, 0.0f);
+    EXPECT_TRUE(occluded(w, ray(point(0.9f, 0, 0.5f), vector(0, 1, 0)), 3.0f));
+    EXPECT_FALSE(occluded(w, ray(point(0.9f, 0, 0.5f), vector(0, 1, 0)), 0.5f));
+    const auto scene = compile(w);
+    EXPECT_EQ(scene.meshes.size(), 1);
+    const auto down = ray(point(0.9f, 10, 0.5f), vector(0, -1, 0));
+    EXPECT_EQ(closest_hits(scene, RayPacket{ down, down, down, down })[0], hit);
+}
+
+TEST(Mesh, shadowRaysSeePastAFaceAtTheirOrigin) {
+    constexpr auto back = vector(0, 0, 2);
+    MeshData m;
+    m.vertices = { P1, P2, P3, P1 + back, P2 + back, P3 + back };
+    m.triangles = { Triangle{ { 0, 1, 2 } }, Triangle{ { 3, 4, 5 } } };
+    const auto faces = build_mesh(std::move(m));
+    const auto r = ray(point(0, 0.5f, 0), vector(0, 0, 1)); //starts on the first face
+    const auto hits = local_intersect(mesh(faces), r);
+    ASSERT_EQ(hits.size(), 1);
+    EXPECT_EQ(hits[0], 0.0f); //hides the face behind it
+    EXPECT_TRUE(any_face(*faces, r, std::numeric_limits<Real>::denorm_min(), 5.0f));
+    const auto w = World({ mesh(faces) });
+    EXPECT_TRUE(occluded(w, r, 5.0f));
+    EXPECT_FALSE(occluded(w, r, 2.0f)); //the second face is at t == 2, not before it
+    auto instanced = World({});
+    instanced.add_instance(instance(instanced.add_asset({ mesh(faces) }), Matrix4Identity));
+    EXPECT_TRUE(occluded(instanced, r, 5.0f));
+}
+
+TEST(Mesh, rendersTheSameInPacketsAndInAssets) {
+    const auto id = build_mesh(grid_mesh(24));
+    const auto light = point_light(point(-10, 10, -10), color(1, 1, 1));
+    auto w = World({ plane() }, light);
+    const auto clay = w.add_material(material(color(0.8f, 0.3f, 0.2f)));
+    w.push_back(mesh(id, clay, translation(0, 0.5f, 0) * scaling(2, 2, 2)));
+    const auto c = Camera(23, 17, math::PI / 3.0f, view_transform(point(0, 4, -6), point(0, 0.5f, 0), vector(0, 1, 0)));
+    const auto expected = render_single_threaded(c, w);
+    const auto actual = render_packets(c, w);
+    auto instanced = World({ plane() }, light);
+    EXPECT_EQ(instanced.add_material(material(color(0.8f, 0.3f, 0.2f))), clay);
+    const auto asset = instanced.add_asset({ mesh(id, clay) });
+    instanced.add_instance(instance(asset, translation(0, 0.5f, 0) * scaling(2, 2, 2)));
+    const auto through_instance = render_single_threaded(c, instanced);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(actual[i].r, expected[i].r) << "at pixel " << i;
+        ASSERT_EQ(actual[i].g, expected[i].g) << "at pixel " << i;
+        ASSERT_EQ(actual[i].b, expected[i].b) << "at pixel " << i;
+        ASSERT_NEAR(through_instance[i].r, expected[i].r, 1e-3f) << "at pixel " << i;
+        ASSERT_NEAR(through_instance[i].g, expected[i].g, 1e-3f) << "at pixel " << i;
+        ASSERT_NEAR(through_instance[i].b, expected[i].b, 1e-3f) << "at pixel " << i;
+    }
+}
+
+TEST(DISABLED_Mesh, AMillionTriangles) {
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    const auto id = build_mesh(grid_mesh(708)); //2 * 708 * 708 = 1,002,528 faces
+    const std::chrono::duration<double, std::milli> build_ms = clock::now() - start;
+    const auto& data = *id;
+    const auto w = World({ mesh(id) });
+    std::mt19937 rng(25);
+    std::uniform_real_distribution<Real> pos(-1.0f, 1.0f);
+    std::vector<Ray> rays;
+    for (auto i = 0; i < 1'000'000; ++i) {
+        rays.push_back(ray(point(pos(rng), 2.0f, pos(rng)), normalize(vector(pos(rng), -2.0f, pos(rng)))));
+    }
+    Real checksum = 0.0f;
+    start = clock::now();
+    for (const auto& r : rays) {
+        checksum += closest_hit(w, r).t;
+    }
+    const std::chrono::duration<double, std::milli> trace_ms = clock::now() - start;
+    const auto bytes = data.vertices.size() * sizeof(Point) + data.triangles.size() * sizeof(Triangle) + data.bvh.nodes.size() * sizeof(BVHNode) + data.bvh.indices.size() * sizeof(BVH::size_type);
+    std::cout << data.size() << " faces, " << bytes / (1024 * 1024) << "MB, built in " << build_ms.count() << "ms. "
+        << rays.size() / trace_ms.count() / 1000.0 << " million rays/s (checksum " << checksum << ")\n";
+}
+
+RESTORE_WARNINGS
@@ -2,6 +2,7 @@
 #include "../pch.h"
 #include "../Tuple.h"
 #include "../Math.h"
+#include <random>
 
 DISABLE_WARNINGS_FROM_GTEST
 
@@ -124,4 +125,46 @@ TEST(Vector, RodriguesRotationZAxis) {
 }
 
 
+//the SIMD kernels (when RTC_SIMD is on) must agree bit for bit with the scalar formulas.
+TEST(Vector, kernelsMatchScalarMathExactly) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<Real> dist(-100.0f, 100.0f);
+  for (int i = 0; i < 10000; ++i) {
+    const auto a = vector(dist(rng), dist(rng), dist(rng));
+    const auto b = vector(dist(rng), dist(rng), dist(rng));
+    const auto s = dist(rng);
+    ASSERT_EQ(dot(a, b), a.x * b.x + a.y * b.y + a.z * b.z);
+    const auto c = cross(a, b);
+    ASSERT_EQ(c.x, a.y * b.z - a.z * b.y);
+    ASSERT_EQ(c.y, a.z * b.x - a.x * b.z);
+    ASSERT_EQ(c.z, a.x * b.y - a.y * b.x);
+    const auto length = static_cast<Real>(std::sqrt(a.x * a.x + a.y * a.y + a.z * a.z));
+    ASSERT_EQ(magnitude(a), length);
+    const auto n = normalize(a);
+    ASSERT_EQ(n.x, a.x * (1.0f / length));
+    ASSERT_EQ(n.y, a.y * (1.0f / length));
+    ASSERT_EQ(n.z, a.z * (1.0f / length));
+    const auto m = madd(a, s, b);
+    ASSERT_EQ(m.x, a.x * s + b.x);
+    ASSERT_EQ(m.y, a.y * s + b.y);
+    ASSERT_EQ(m.z, a.z * s + b.z);
+    const auto r = reflect(a, n);
+    const auto expected = a - n * 2 * dot(a, n);
+    ASSERT_EQ(r.x, expected.x);
+    ASSERT_EQ(r.y, expected.y);
+    ASSERT_EQ(r.z, expected.z);
+  }
+}
+
+TEST(Vector, kernelsAreConstexpr) {
+  static_assert(dot(vector(1, 2, 3), vector(4, 5, 6)) == 32);
+  static_assert(cross(vector(1, 0, 0), vector(0, 1, 0)) == vector(0, 0, 1));
+  static_assert(normalize(vector(0, 3, 4)) == vector(0, 0.6f, 0.8f));
+  static_assert(madd(vector(1, 2, 3), 2, vector(1, 1, 1)) == vector(3, 5, 7));
+  static_assert(madd(vector(1, 2, 3), 2, point(1, 1, 1)) == point(3, 5, 7));
+  static_assert(reflect(vector(1, -1, 0), vector(0, 1, 0)) == vector(1, 1, 0));
+  static_assert(!USE_SIMD || (sizeof(Vector) == 16 && alignof(Vector) == 16));
+  static_assert(!USE_SIMD || (sizeof(Point) == 16 && alignof(Point) == 16));
+}
+
 RESTORE_WARNINGS
\ No newline at end of file
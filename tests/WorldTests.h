@@ -9,11 +9,12 @@ DISABLE_WARNINGS_FROM_GTEST
 TEST(World, hasDefaultWorld) {
   const auto w = World();
   const Shapes s0{ sphere() };
-  const Shapes s1 = sphere(World::DEFAULT_MATERIAL); 
+  const Shapes s1 = sphere(MaterialId{ 1 }); 
   const auto s2 = sphere(scaling(0.5f, 0.5f, 0.5f));
   EXPECT_TRUE(w.size() == 2);
   EXPECT_FALSE(w.contains(s0));
   EXPECT_TRUE(w.contains(s1));
+  EXPECT_EQ(w.material_at(MaterialId{ 1 }), World::DEFAULT_MATERIAL);
   EXPECT_TRUE(w.contains(s2));
 }
 
@@ -73,4 +74,56 @@ TEST(World, colorWhenHitBehindRay) {
     EXPECT_EQ(col,  get_material(w, 1).color);
 }
 
+TEST(World, closestHitIsTheNearestNonNegativeIntersection) {
+    const auto w = World();
+    auto hit = closest_hit(w, ray(point(0, 0, -5), vector(0, 0, 1)));
+    EXPECT_EQ(hit.objPtr, &w[0]);
+    EXPECT_FLOAT_EQ(hit.t, 4.0f);
+    hit = closest_hit(w, ray(point(0, 0, 0), vector(0, 0, 1))); //from inside both spheres
+    EXPECT_EQ(hit.objPtr, &w[1]);
+    EXPECT_FLOAT_EQ(hit.t, 0.5f);
+    EXPECT_FALSE(closest_hit(w, ray(point(0, 0, 5), vector(0, 0, 1))));
+}
+
+TEST(World, occludedOnlyCountsHitsBetweenTheOriginAndMaxT) {
+    const auto w = World(); //unit sphere at origo, hit at t = 4 and t = 6 from z = -5
+    const auto r = ray(point(0, 0, -5), vector(0, 0, 1));
+    EXPECT_TRUE(occluded(w, r, 10.0f));
+    EXPECT_TRUE(occluded(w, r, 4.5f));
+    EXPECT_FALSE(occluded(w, r, 3.5f)); //the sphere is beyond max_t
+    EXPECT_FALSE(occluded(w, ray(point(0, 0, 5), vector(0, 0, 1)), 10.0f)); //the sphere is behind the ray
+    EXPECT_FALSE(occluded(w, ray(point(0, 5, -5), vector(0, 0, 1)), 10.0f));
+}
+
+TEST(World, occludedByAnUnboundedShape) {
+    const auto w = World({ plane(translation(0, -1, 0)) });
+    EXPECT_TRUE(occluded(w, ray(point(0, 1, 0), vector(0, -1, 0)), 5.0f));
+    EXPECT_FALSE(occluded(w, ray(point(0, 1, 0), vector(0, -1, 0)), 1.5f));
+}
+
+TEST(World, pushingShapesLeavesTheBVHUnbuilt) {
+    auto w = World();
+    EXPECT_TRUE(w.is_built());
+    w.push_back(sphere(translation(0, 0, 10)));
+    w.push_back(sphere(translation(0, 0, 20)));
+    EXPECT_FALSE(w.is_built());
+    EXPECT_EQ(w.bvh().size(), 2); //still the BVH of the two default spheres
+    const auto hit = closest_hit(w, ray(point(0, 0, 15), vector(0, 0, 1)));
+    EXPECT_EQ(hit.objPtr, &w.objects()[3]);
+    w.build();
+    EXPECT_TRUE(w.is_built());
+    EXPECT_EQ(w.bvh().size(), 4);
+}
+
+TEST(World, movingAShapeInPlaceIsSeenByQueries) {
+    auto w = World();
+    set_transform(w[0], translation(0, 10, 0));
+    EXPECT_FALSE(w.is_built());
+    const auto r = ray(point(0, 10, -5), vector(0, 0, 1));
+    EXPECT_FLOAT_EQ(closest_hit(w, r).t, 4.0f);
+    w.build();
+    EXPECT_FLOAT_EQ(closest_hit(w, r).t, 4.0f);
+    EXPECT_FALSE(occluded(w, ray(point(0, 0, -5), vector(0, 0, 1)), 4.2f)); //only the small sphere is left at origo
+}
+
 RESTORE_WARNINGS
\ No newline at end of file